@@ -0,0 +1,21 @@
+#!/bin/sh
+# Writes about $1 lines (default 21000) of depth-6 arithmetic expressions
+# to stdout, each a full binary tree over the parameters of its function.
+# There is no main, so peachc -s keeps every function.
+awk -v lines="${1:-21000}" '
+function tree(depth, n) {
+    if (depth == 0)
+        return substr("abcd", n % 4 + 1, 1)
+    return "(" tree(depth - 1, n * 2) " " substr("+-*+", n % 4 + 1, 1) " " tree(depth - 1, n * 2 + 1) ")"
+}
+BEGIN {
+    for (f = 0; f * 15 < lines; f++) {
+        print "def e" f "(a: int, b: int, c: int, d: int) -> int = {"
+        print "    var r: int = 0"
+        for (k = 0; k < 10; k++)
+            print "    r = r + " tree(6, f + k)
+        print "    return r"
+        print "}"
+        print ""
+    }
+}'
@@ -0,0 +1,32 @@
+#!/bin/sh
+# Writes a synthetic statement-heavy program of about $1 lines (default
+# 264000) to stdout: many small functions with locals, loops, branches and
+# calls. There is no main, so peachc -s keeps every function.
+awk -v lines="${1:-264000}" 'BEGIN {
+    for (f = 0; f * 21 < lines; f++) {
+        print "def f" f "(a: int, b: int) -> int = {"
+        print "    var x: int = a * " (f % 7 + 1) " + b"
+        print "    var y: int = b - a / " (f % 5 + 1)
+        print "    var i: int = 0"
+        print "    while (i < 10) {"
+        print "        if (x > y) {"
+        print "            x = x - y + i"
+        print "        } else {"
+        print "            y = y - x + i * 2"
+        print "        }"
+        print "        i = i + 1"
+        print "    }"
+        print "    val z: int = (x + y) * (x - y) % 97"
+        print "    if (z == 0) {"
+        print "        return x"
+        print "    }"
+        if (f > 0)
+            print "    x = f" (f - 1) "(z, x + 1)"
+        else
+            print "    x = x + z"
+        print "    y = y + x * 3"
+        print "    return x + y"
+        print "}"
+        print ""
+    }
+}'
@@ -0,0 +1,34 @@
+// LD_PRELOAD shim that counts calls to malloc, calloc and realloc and
+// prints the total and the peak RSS to stderr at exit. glibc only: it
+// forwards to the __libc_* entry points instead of looking up the next
+// symbol.
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+static unsigned long calls;
+
+void* malloc(size_t size) {
+    calls++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    calls++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    calls++;
+    return __libc_realloc(ptr, size);
+}
+
+__attribute__((destructor)) static void report(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    fprintf(stderr, "  malloc calls: %lu, peak RSS %ld MiB\n", calls, usage.ru_maxrss / 1024);
+}
@@ -0,0 +1,105 @@
+#!/bin/sh
+# Builds and times the benchmark programs in this directory.
+#
+#   ./run.sh [kernel...]    e.g. ./run.sh restrict saxpy
+#
+# PEACHC selects the compiler (default: ../../peachc). Binaries are written
+# to $BUILD (default: ./build).
+#
+# The compiler benchmarks time peachc itself on corpora generated into
+# $BUILD on first use: statements.peach (gen_statements.sh, ~264k lines)
+# and expressions.peach (gen_expressions.sh, ~21k lines of depth-6
+# arithmetic expressions).
+set -e
+
+cd "$(dirname "$0")"
+PEACHC=${PEACHC:-../../peachc}
+BUILD=${BUILD:-build}
+mkdir -p "$BUILD"
+
+# Best wall time of five runs, in seconds
+best_of_5() {
+    best=""
+    for run in 1 2 3 4 5; do
+        start=$(date +%s.%N)
+        "$@" > /dev/null
+        end=$(date +%s.%N)
+        best=$(echo "$start $end $best" | awk '{ t = $2 - $1; if ($3 == "" || t < $3) print t; else print $3 }')
+    done
+    printf '%.2f s' "$best"
+}
+
+# noalias kernels: compare with a copy that has noalias removed. -fno-inline
+# keeps gcc from specializing the kernel into main, where it can see the
+# arrays do not overlap anyway.
+noalias_kernel() {
+    sed 's/noalias //g' "$1.peach" > "$BUILD/$1_plain.peach"
+    for level in 2 3; do
+        "$PEACHC" -O "$level" -fno-inline -o "$BUILD/$1" "$1.peach" > /dev/null
+        "$PEACHC" -O "$level" -fno-inline -o "$BUILD/$1_plain" "$BUILD/$1_plain.peach" > /dev/null
+        echo "$1 -O$level: plain $(best_of_5 "$BUILD/$1_plain"), noalias $(best_of_5 "$BUILD/$1")"
+    done
+}
+
+# Vec programs: compare with $1_ref.c, a hand-written C vector of the same layout
+vec_program() {
+    for level in 2 3; do
+        "$PEACHC" -O "$level" -o "$BUILD/$1" "$1.peach" > /dev/null
+        gcc -O"$level" -o "$BUILD/$1_ref" "$1_ref.c"
+        echo "$1 -O$level: Vec $(best_of_5 "$BUILD/$1"), C $(best_of_5 "$BUILD/$1_ref")"
+    done
+}
+
+# Path of generated corpus $1, written on first use
+corpus() {
+    [ -f "$BUILD/$1.peach" ] || "./gen_$1.sh" > "$BUILD/$1.peach"
+    echo "$BUILD/$1.peach"
+}
+
+# Runs peachc -s -v on corpus $1 under malloc_count.so and prints the
+# lines matching $2
+translate() {
+    [ -f "$BUILD/malloc_count.so" ] || gcc -O2 -shared -fPIC -o "$BUILD/malloc_count.so" malloc_count.c
+    LD_PRELOAD="$BUILD/malloc_count.so" "$PEACHC" -s -v -o "$BUILD/$1" "$(corpus "$1")" 2>&1 | grep -E "$2"
+}
+
+# AST allocation: node count, arena size, malloc calls and wall time
+ast_benchmark() {
+    echo "ast (statements):"
+    translate statements 'AST:|malloc calls'
+    echo "  wall time $(best_of_5 "$PEACHC" -s -o "$BUILD/statements" "$(corpus statements)")"
+}
+
+# Lexing and parsing through the token stream: tokens/s and peak RSS
+parse_benchmark() {
+    echo "parse (statements):"
+    translate statements 'Parsed|peak RSS'
+}
+
+# AST passes on deep expressions: what each pass reports, codegen time and
+# total wall time
+passes_benchmark() {
+    echo "passes (expressions):"
+    translate expressions 'AST:|Folded|Removed|Inferred|Passing|Inlining|Generated [0-9]'
+    echo "  wall time $(best_of_5 "$PEACHC" -s -o "$BUILD/expressions" "$(corpus expressions)")"
+}
+
+# Code generation throughput on both corpora
+codegen_benchmark() {
+    for name in statements expressions; do
+        echo "codegen ($name):"
+        translate "$name" 'Generated [0-9]'
+    done
+}
+
+for kernel in ${@:-restrict saxpy vec_push vec_iterate ast parse passes codegen}; do
+    case "$kernel" in
+        restrict|saxpy) noalias_kernel "$kernel" ;;
+        vec_push|vec_iterate) vec_program "$kernel" ;;
+        ast) ast_benchmark ;;
+        parse) parse_benchmark ;;
+        passes) passes_benchmark ;;
+        codegen) codegen_benchmark ;;
+        *) echo "unknown kernel: $kernel" >&2; exit 1 ;;
+    esac
+done
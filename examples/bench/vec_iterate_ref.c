@@ -0,0 +1,29 @@
+// Hand-written counterpart of vec_iterate.peach: sums 5M ints 100 times.
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    int* data;
+    long len;
+    long cap;
+} IntVec;
+
+int main(void) {
+    IntVec v = {malloc(5000000 * sizeof(int)), 0, 5000000};
+    if (!v.data) {
+        abort();
+    }
+    for (int i = 0; i < 5000000; i++) {
+        v.data[v.len++] = i % 1024;
+    }
+    
+    long total = 0;
+    for (int round = 0; round < 100; round++) {
+        for (long i = 0; i < v.len; i++) {
+            total += v.data[i];
+        }
+    }
+    printf("%ld\n", total);
+    free(v.data);
+    return 0;
+}
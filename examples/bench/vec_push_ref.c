@@ -0,0 +1,39 @@
+// Hand-written counterpart of vec_push.peach: the same data/len/cap layout,
+// doubling growth through realloc.
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    int* data;
+    long len;
+    long cap;
+} IntVec;
+
+static void grow(IntVec* v) {
+    v->cap = v->cap < 4 ? 8 : v->cap * 2;
+    v->data = realloc(v->data, (size_t)v->cap * sizeof(int));
+    if (!v->data) {
+        abort();
+    }
+}
+
+static inline void push(IntVec* v, int x) {
+    if (v->len == v->cap) {
+        grow(v);
+    }
+    v->data[v->len++] = x;
+}
+
+int main(void) {
+    long total = 0;
+    for (int round = 0; round < 20; round++) {
+        IntVec v = {0};
+        for (int i = 0; i < 5000000; i++) {
+            push(&v, i);
+        }
+        total += v.len;
+        free(v.data);
+    }
+    printf("%ld\n", total);
+    return 0;
+}
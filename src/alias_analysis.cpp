@@ -0,0 +1,352 @@
+#include "alias_analysis.h"
+
+namespace {
+
+// Builtins read their arguments and touch no other memory
+bool isBuiltin(Symbol name) {
+    static const Symbol print("print"), range("range"), len("len");
+    return name == print || name == range || name == len;
+}
+
+// Element type reached through a parameter, empty if it holds no pointer
+std::string pathElementType(TypeNode* type) {
+    if (auto* pointerType = nodeCast<PointerTypeNode>(type)) {
+        return pointerType->baseType->toCType();
+    }
+    if (auto* sliceType = nodeCast<SliceTypeNode>(type)) {
+        return sliceType->elementType->toCType();
+    }
+    if (auto* vecType = nodeCast<VecTypeNode>(type)) {
+        return vecType->elementType->toCType();
+    }
+    if (auto* mapType = nodeCast<MapTypeNode>(type)) {
+        return mapType->valueType->toCType(); // keys are only written by its methods
+    }
+    if (auto* arrayType = nodeCast<ArrayTypeNode>(type)) {
+        return arrayType->toCType(); // innermost element type
+    }
+    if (nodeCast<StructTypeNode>(type)) {
+        return type->toCType(); // fields may be pointers
+    }
+    if (auto* basicType = nodeCast<BasicTypeNode>(type)) {
+        if (basicType->typeName == "string") {
+            return "char";
+        }
+    }
+    return "";
+}
+
+bool* restrictFlag(TypeNode* type) {
+    if (auto* pointerType = nodeCast<PointerTypeNode>(type)) {
+        return &pointerType->isRestrict;
+    }
+    if (auto* sliceType = nodeCast<SliceTypeNode>(type)) {
+        return &sliceType->isRestrict;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+void AliasAnalyzer::analyze(ProgramNode* program) {
+    for (auto& decl : program->globalDeclarations) {
+        if (auto* varDecl = nodeCast<VarDeclNode>(decl.get())) {
+            globals.insert(varDecl->name);
+        }
+    }
+    
+    for (auto& implBlock : program->implBlocks) {
+        for (auto& method : implBlock->methods) {
+            analyzeFunction(method.get(), implBlock.get());
+        }
+    }
+    
+    for (auto& function : program->functions) {
+        analyzeFunction(function.get(), nullptr);
+    }
+}
+
+void AliasAnalyzer::analyzeFunction(FunctionNode* function, const ImplBlockNode* impl) {
+    paths.clear();
+    locals.clear();
+    derivedFrom.clear();
+    writtenThrough.clear();
+    rebound.clear();
+    opaque = false;
+    
+    if (impl) {
+        // The receiver holds or points to caller memory, whatever its kind
+        static const Symbol self("self");
+        paths.push_back({self, "struct " + impl->structName, nullptr});
+        locals.insert(self);
+    }
+    
+    for (auto& param : function->parameters) {
+        locals.insert(param.first);
+        std::string elementType = pathElementType(param.second.get());
+        if (!elementType.empty()) {
+            paths.push_back({param.first, elementType, restrictFlag(param.second.get())});
+        }
+    }
+    
+    if (function->body) {
+        StmtVisitor::visit(function->body.get());
+    }
+    
+    if (opaque) {
+        return;
+    }
+    
+    for (const auto& path : paths) {
+        if (!path.isRestrict || *path.isRestrict || rebound.count(path.name)) {
+            continue;
+        }
+    
+        bool safe = true;
+        for (const auto& other : paths) {
+            if (&other == &path || !mayOverlap(path.elementType, other.elementType)) {
+                continue;
+            }
+            if (isWrittenThrough(path.name) || isWrittenThrough(other.name)) {
+                safe = false;
+                break;
+            }
+        }
+    
+        if (safe) {
+            *path.isRestrict = true;
+            restrictCount++;
+        }
+    }
+}
+
+bool AliasAnalyzer::reaches(Symbol name, Symbol path, std::unordered_set<Symbol>& visited) const {
+    if (name == path) {
+        return true;
+    }
+    if (!visited.insert(name).second) {
+        return false;
+    }
+    
+    auto it = derivedFrom.find(name);
+    if (it != derivedFrom.end()) {
+        for (Symbol source : it->second) {
+            if (reaches(source, path, visited)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool AliasAnalyzer::isWrittenThrough(Symbol path) const {
+    for (Symbol written : writtenThrough) {
+        std::unordered_set<Symbol> visited;
+        if (reaches(written, path, visited)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AliasAnalyzer::mayOverlap(const std::string& a, const std::string& b) {
+    // Aggregates, chars and pointers may alias other element types
+    auto isWildcard = [](const std::string& type) {
+        return type.compare(0, 7, "struct ") == 0 || type.compare(0, 6, "union ") == 0 ||
+               type.find("char") != std::string::npos || type.back() == '*';
+    };
+    return a == b || isWildcard(a) || isWildcard(b);
+}
+
+void AliasAnalyzer::collectNames(ExprNode* expr, std::vector<Symbol>& names) {
+    if (auto* ident = nodeCast<IdentifierNode>(expr)) {
+        names.push_back(ident->name);
+    } else if (auto* binOp = nodeCast<BinaryOpNode>(expr)) {
+        collectNames(binOp->left.get(), names);
+        collectNames(binOp->right.get(), names);
+    } else if (auto* unaryOp = nodeCast<UnaryOpNode>(expr)) {
+        collectNames(unaryOp->operand.get(), names);
+    } else if (auto* index = nodeCast<IndexNode>(expr)) {
+        collectNames(index->array.get(), names);
+        collectNames(index->index.get(), names);
+    } else if (auto* addrOf = nodeCast<AddressOfNode>(expr)) {
+        collectNames(addrOf->operand.get(), names);
+    } else if (auto* deref = nodeCast<DereferenceNode>(expr)) {
+        collectNames(deref->operand.get(), names);
+    } else if (auto* fieldAccess = nodeCast<FieldAccessNode>(expr)) {
+        collectNames(fieldAccess->object.get(), names);
+    } else if (auto* arrayLit = nodeCast<ArrayLiteralNode>(expr)) {
+        for (auto& element : arrayLit->elements) {
+            collectNames(element.get(), names);
+        }
+    } else if (auto* call = nodeCast<CallNode>(expr)) {
+        for (auto& arg : call->arguments) {
+            collectNames(arg.get(), names);
+        }
+    } else if (auto* methodCall = nodeCast<MethodCallNode>(expr)) {
+        collectNames(methodCall->receiver.get(), names);
+        for (auto& arg : methodCall->arguments) {
+            collectNames(arg.get(), names);
+        }
+    } else if (auto* structInit = nodeCast<StructInitNode>(expr)) {
+        for (auto& field : structInit->fields) {
+            collectNames(field.second.get(), names);
+        }
+    } else if (auto* unionInit = nodeCast<UnionInitNode>(expr)) {
+        collectNames(unionInit->value.get(), names);
+    }
+}
+
+void AliasAnalyzer::recordWrite(ExprNode* target) {
+    // Walk down to the variable the stored-to memory is reached from
+    ExprNode* base = target;
+    while (true) {
+        if (auto* index = nodeCast<IndexNode>(base)) {
+            base = index->array.get();
+        } else if (auto* deref = nodeCast<DereferenceNode>(base)) {
+            base = deref->operand.get();
+        } else if (auto* fieldAccess = nodeCast<FieldAccessNode>(base)) {
+            base = fieldAccess->object.get();
+        } else {
+            break;
+        }
+    }
+    
+    std::vector<Symbol> names;
+    collectNames(base, names);
+    writtenThrough.insert(names.begin(), names.end());
+}
+
+void AliasAnalyzer::recordAssignment(ExprNode* target, ExprNode* value) {
+    if (auto* ident = nodeCast<IdentifierNode>(target)) {
+        // Rebinding a variable, it now also carries whatever value came from
+        rebound.insert(ident->name);
+        collectNames(value, derivedFrom[ident->name]);
+    } else {
+        recordWrite(target);
+    }
+}
+
+void AliasAnalyzer::visitIdentifier(IdentifierNode* node) {
+    if (!locals.count(node->name) && globals.count(node->name)) {
+        opaque = true;
+    }
+}
+
+void AliasAnalyzer::visitBinaryOp(BinaryOpNode* node) {
+    if (node->op == "=") {
+        recordAssignment(node->left.get(), node->right.get());
+    }
+    ExprVisitor::visit(node->left.get());
+    ExprVisitor::visit(node->right.get());
+}
+
+void AliasAnalyzer::visitUnaryOp(UnaryOpNode* node) {
+    ExprVisitor::visit(node->operand.get());
+}
+
+void AliasAnalyzer::visitArrayLiteral(ArrayLiteralNode* node) {
+    for (auto& element : node->elements) {
+        ExprVisitor::visit(element.get());
+    }
+}
+
+void AliasAnalyzer::visitIndex(IndexNode* node) {
+    ExprVisitor::visit(node->array.get());
+    ExprVisitor::visit(node->index.get());
+}
+
+void AliasAnalyzer::visitCall(CallNode* node) {
+    // A user function may reach the same memory through globals
+    if (!isBuiltin(node->functionName)) {
+        opaque = true;
+    }
+    for (auto& arg : node->arguments) {
+        ExprVisitor::visit(arg.get());
+    }
+}
+
+void AliasAnalyzer::visitAddressOf(AddressOfNode* node) {
+    // A pointer to the variable could be used to rebind it
+    if (auto* ident = nodeCast<IdentifierNode>(node->operand.get())) {
+        rebound.insert(ident->name);
+    }
+    ExprVisitor::visit(node->operand.get());
+}
+
+void AliasAnalyzer::visitDereference(DereferenceNode* node) {
+    ExprVisitor::visit(node->operand.get());
+}
+
+void AliasAnalyzer::visitFieldAccess(FieldAccessNode* node) {
+    ExprVisitor::visit(node->object.get());
+}
+
+void AliasAnalyzer::visitStructInit(StructInitNode* node) {
+    for (auto& field : node->fields) {
+        ExprVisitor::visit(field.second.get());
+    }
+}
+
+void AliasAnalyzer::visitUnionInit(UnionInitNode* node) {
+    ExprVisitor::visit(node->value.get());
+}
+
+void AliasAnalyzer::visitMethodCall(MethodCallNode* node) {
+    opaque = true;
+    ExprVisitor::visit(node->receiver.get());
+    for (auto& arg : node->arguments) {
+        ExprVisitor::visit(arg.get());
+    }
+}
+
+void AliasAnalyzer::visitExprStmt(ExprStmtNode* node) {
+    ExprVisitor::visit(node->expr.get());
+}
+
+void AliasAnalyzer::visitVarDecl(VarDeclNode* node) {
+    locals.insert(node->name);
+    if (node->initializer) {
+        ExprVisitor::visit(node->initializer.get());
+        collectNames(node->initializer.get(), derivedFrom[node->name]);
+    }
+}
+
+void AliasAnalyzer::visitAssignment(AssignmentNode* node) {
+    recordAssignment(node->target.get(), node->value.get());
+    ExprVisitor::visit(node->target.get());
+    ExprVisitor::visit(node->value.get());
+}
+
+void AliasAnalyzer::visitBlock(BlockNode* node) {
+    for (auto& stmt : node->statements) {
+        StmtVisitor::visit(stmt.get());
+    }
+}
+
+void AliasAnalyzer::visitReturn(ReturnNode* node) {
+    if (node->value) {
+        ExprVisitor::visit(node->value.get());
+    }
+}
+
+void AliasAnalyzer::visitIf(IfNode* node) {
+    ExprVisitor::visit(node->condition.get());
+    StmtVisitor::visit(node->thenBranch.get());
+    if (node->elseBranch) {
+        StmtVisitor::visit(node->elseBranch.get());
+    }
+}
+
+void AliasAnalyzer::visitWhile(WhileNode* node) {
+    ExprVisitor::visit(node->condition.get());
+    StmtVisitor::visit(node->body.get());
+}
+
+void AliasAnalyzer::visitFor(ForNode* node) {
+    // The iterator copies elements, which may themselves be pointers
+    locals.insert(node->iteratorName);
+    collectNames(node->collection.get(), derivedFrom[node->iteratorName]);
+    ExprVisitor::visit(node->collection.get());
+    StmtVisitor::visit(node->body.get());
+}
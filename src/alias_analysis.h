@@ -0,0 +1,85 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+#include "ast_visitor.h"
+
+// Alias analysis run between constant folding and code generation. It marks
+// pointer and slice parameters that can be lowered with C `restrict`.
+//
+// `noalias` parameters are restrict on the programmer's word. Any other
+// parameter is only marked when its function body shows that the qualifier
+// cannot change the program's meaning, whoever the caller is:
+//  - the body calls no user function and touches no global variable, so
+//    parameters are the only way into memory the caller owns;
+//  - the parameter is never reassigned and its address is not taken;
+//  - no memory is written through it or through any other parameter whose
+//    elements may overlap with it (same element type, structs, chars and
+//    pointers), following locals derived from each parameter.
+class AliasAnalyzer : public ExprVisitor<AliasAnalyzer>, public StmtVisitor<AliasAnalyzer> {
+private:
+    friend class ExprVisitor<AliasAnalyzer>;
+    friend class StmtVisitor<AliasAnalyzer>;
+    
+    // A way into caller-owned memory: a pointer-like parameter or receiver
+    struct AccessPath {
+        Symbol name;
+        std::string elementType;
+        bool* isRestrict; // nullptr when it cannot be qualified (receivers, arrays)
+    };
+    
+    std::unordered_set<Symbol> globals;
+    size_t restrictCount;
+    
+    // Per-function state
+    std::vector<AccessPath> paths;
+    std::unordered_set<Symbol> locals;
+    std::unordered_map<Symbol, std::vector<Symbol>> derivedFrom; // name -> names its value came from
+    std::unordered_set<Symbol> writtenThrough;
+    std::unordered_set<Symbol> rebound; // parameters reassigned or whose address is taken
+    bool opaque; // calls user code or touches globals
+    
+    void analyzeFunction(FunctionNode* function, const ImplBlockNode* impl);
+    bool reaches(Symbol name, Symbol path, std::unordered_set<Symbol>& visited) const;
+    bool isWrittenThrough(Symbol path) const;
+    static bool mayOverlap(const std::string& a, const std::string& b);
+    
+    // Collect the identifiers an expression reads its value from
+    static void collectNames(ExprNode* expr, std::vector<Symbol>& names);
+    void recordWrite(ExprNode* target);
+    void recordAssignment(ExprNode* target, ExprNode* value);
+    
+    // Expressions
+    void visitIdentifier(IdentifierNode* node);
+    void visitBinaryOp(BinaryOpNode* node);
+    void visitUnaryOp(UnaryOpNode* node);
+    void visitArrayLiteral(ArrayLiteralNode* node);
+    void visitIndex(IndexNode* node);
+    void visitCall(CallNode* node);
+    void visitAddressOf(AddressOfNode* node);
+    void visitDereference(DereferenceNode* node);
+    void visitFieldAccess(FieldAccessNode* node);
+    void visitStructInit(StructInitNode* node);
+    void visitUnionInit(UnionInitNode* node);
+    void visitMethodCall(MethodCallNode* node);
+    
+    // Statements
+    void visitExprStmt(ExprStmtNode* node);
+    void visitVarDecl(VarDeclNode* node);
+    void visitAssignment(AssignmentNode* node);
+    void visitBlock(BlockNode* node);
+    void visitReturn(ReturnNode* node);
+    void visitIf(IfNode* node);
+    void visitWhile(WhileNode* node);
+    void visitFor(ForNode* node);
+    
+public:
+    AliasAnalyzer() : restrictCount(0), opaque(false) {}
+    
+    void analyze(ProgramNode* program);
+    
+    // Number of parameters marked restrict without a `noalias`
+    size_t getRestrictCount() const { return restrictCount; }
+};
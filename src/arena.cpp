@@ -0,0 +1,41 @@
+#include "arena.h"
+#include <cstdint>
+
+namespace {
+// Chunks double in size until they reach this limit
+constexpr size_t MAX_CHUNK_SIZE = 1024 * 1024;
+}
+
+AstArena::AstArena(size_t initialChunkSize)
+    : cursor(nullptr), limit(nullptr), nextChunkSize(initialChunkSize),
+      nodeCount(0), bytesUsed(0) {}
+
+void* AstArena::allocate(size_t size, size_t align) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(cursor);
+    uintptr_t aligned = (address + align - 1) & ~(uintptr_t)(align - 1);
+
+    if (!cursor || aligned + size > reinterpret_cast<uintptr_t>(limit)) {
+        grow(size + align);
+        address = reinterpret_cast<uintptr_t>(cursor);
+        aligned = (address + align - 1) & ~(uintptr_t)(align - 1);
+    }
+
+    cursor = reinterpret_cast<char*>(aligned + size);
+    bytesUsed += size;
+    return reinterpret_cast<void*>(aligned);
+}
+
+void AstArena::grow(size_t minSize) {
+    size_t chunkSize = nextChunkSize;
+    if (chunkSize < minSize) {
+        chunkSize = minSize;
+    }
+
+    chunks.push_back(std::unique_ptr<char[]>(new char[chunkSize]));
+    cursor = chunks.back().get();
+    limit = cursor + chunkSize;
+
+    if (nextChunkSize < MAX_CHUNK_SIZE) {
+        nextChunkSize *= 2;
+    }
+}
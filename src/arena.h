@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include "ast.h"
+
+// Bump-pointer arena owning the memory of every AST node of a compilation unit.
+// Nodes are handed out as AstPtr, whose deleter only runs the destructor; the
+// chunks are released in one shot when the arena goes away, so the arena must
+// outlive every tree built in it.
+class AstArena {
+private:
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char* cursor;
+    char* limit;
+    size_t nextChunkSize;
+    size_t nodeCount;
+    size_t bytesUsed;
+
+    void* allocate(size_t size, size_t align);
+    void grow(size_t minSize);
+
+public:
+    explicit AstArena(size_t initialChunkSize = 64 * 1024);
+
+    // Prevent copying, nodes point into the chunks
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    template<typename T, typename... Args>
+    AstPtr<T> make(Args&&... args) {
+        void* memory = allocate(sizeof(T), alignof(T));
+        nodeCount++;
+        return AstPtr<T>(new (memory) T(std::forward<Args>(args)...));
+    }
+
+    size_t getNodeCount() const { return nodeCount; }
+    size_t getBytesUsed() const { return bytesUsed; }
+    size_t getChunkCount() const { return chunks.size(); }
+};
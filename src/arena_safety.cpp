@@ -0,0 +1,296 @@
+#include "arena_safety.h"
+#include <stdexcept>
+
+namespace {
+
+// Receiver spelled the way it is written, "h.scratch", empty when it is not a path
+std::string pathName(ExprNode* expr) {
+    if (auto* ident = nodeCast<IdentifierNode>(expr)) {
+        return ident->name.str();
+    }
+    if (auto* fieldAccess = nodeCast<FieldAccessNode>(expr)) {
+        std::string object = pathName(fieldAccess->object.get());
+        return object.empty() ? "" : object + "." + fieldAccess->fieldName.str();
+    }
+    return "";
+}
+
+} // namespace
+
+void ArenaSafetyChecker::check(ProgramNode* program) {
+    for (auto& implBlock : program->implBlocks) {
+        for (auto& method : implBlock->methods) {
+            checkFunction(method.get(), implBlock->structName + "." + method->name.str());
+        }
+    }
+    for (auto& function : program->functions) {
+        checkFunction(function.get(), function->name.str());
+    }
+}
+
+void ArenaSafetyChecker::checkFunction(FunctionNode* function, const std::string& name) {
+    functionName = name;
+    pointers.clear();
+    scopes.clear();
+    terminated = false;
+    
+    if (function->body) {
+        StmtVisitor::visit(function->body.get());
+    }
+}
+
+std::optional<ArenaSafetyChecker::Pointer> ArenaSafetyChecker::pointerOf(ExprNode* expr) const {
+    static const Symbol alloc("alloc");
+    if (auto* methodCall = nodeCast<MethodCallNode>(expr)) {
+        if (methodCall->methodName == alloc && methodCall->typeArgument) {
+            std::string arena = pathName(methodCall->receiver.get());
+            if (!arena.empty()) {
+                return Pointer{arena, ""};
+            }
+        }
+        return std::nullopt;
+    }
+    if (auto* ident = nodeCast<IdentifierNode>(expr)) {
+        auto it = pointers.find(ident->name);
+        if (it != pointers.end()) {
+            return it->second;
+        }
+    }
+    return std::nullopt;
+}
+
+void ArenaSafetyChecker::declare(Symbol name, std::optional<Pointer> pointer) {
+    if (!scopes.empty()) {
+        auto& hidden = scopes.back();
+        bool recorded = false;
+        for (const auto& entry : hidden) {
+            recorded = recorded || entry.first == name;
+        }
+        if (!recorded) {
+            auto it = pointers.find(name);
+            hidden.emplace_back(name, it != pointers.end() ? std::optional<Pointer>(it->second) : std::nullopt);
+        }
+    }
+    
+    if (pointer) {
+        pointers[name] = *pointer;
+    } else {
+        pointers.erase(name);
+    }
+}
+
+void ArenaSafetyChecker::endScope() {
+    // Declarations end with the block, the variables they hid are back
+    for (auto& [name, hidden] : scopes.back()) {
+        if (hidden) {
+            pointers[name] = *hidden;
+        } else {
+            pointers.erase(name);
+        }
+    }
+    scopes.pop_back();
+}
+
+void ArenaSafetyChecker::assign(ExprNode* target, ExprNode* value) {
+    ExprVisitor::visit(value);
+    
+    // Assigning a variable gives it a new value; any other target is a use
+    if (auto* ident = nodeCast<IdentifierNode>(target)) {
+        if (auto pointer = pointerOf(value)) {
+            pointers[ident->name] = *pointer;
+        } else {
+            pointers.erase(ident->name);
+        }
+    } else {
+        ExprVisitor::visit(target);
+    }
+}
+
+ArenaSafetyChecker::State ArenaSafetyChecker::merge(const State& a, bool aTerminated,
+                                                    const State& b, bool bTerminated) const {
+    // A path that returned does not reach the join
+    if (aTerminated) {
+        return b;
+    }
+    if (bTerminated) {
+        return a;
+    }
+    
+    // Dangling only if it dangles on both paths
+    State merged;
+    for (const auto& [name, pointer] : a) {
+        auto it = b.find(name);
+        if (it == b.end() || it->second.arena != pointer.arena) {
+            continue;
+        }
+        Pointer joined = pointer;
+        if (it->second.freedBy.empty()) {
+            joined.freedBy.clear();
+        }
+        merged[name] = joined;
+    }
+    return merged;
+}
+
+void ArenaSafetyChecker::visitIdentifier(IdentifierNode* node) {
+    auto it = pointers.find(node->name);
+    if (it != pointers.end() && !it->second.freedBy.empty()) {
+        throw std::runtime_error("Use of dangling pointer '" + node->name.str() + "' in " + functionName +
+                                 ": arena '" + it->second.arena + "' was " + it->second.freedBy +
+                                 " after it was allocated");
+    }
+}
+
+void ArenaSafetyChecker::visitBinaryOp(BinaryOpNode* node) {
+    if (node->op == "=") {
+        assign(node->left.get(), node->right.get());
+        return;
+    }
+    ExprVisitor::visit(node->left.get());
+    ExprVisitor::visit(node->right.get());
+}
+
+void ArenaSafetyChecker::visitUnaryOp(UnaryOpNode* node) {
+    ExprVisitor::visit(node->operand.get());
+}
+
+void ArenaSafetyChecker::visitArrayLiteral(ArrayLiteralNode* node) {
+    for (auto& element : node->elements) {
+        ExprVisitor::visit(element.get());
+    }
+}
+
+void ArenaSafetyChecker::visitIndex(IndexNode* node) {
+    ExprVisitor::visit(node->array.get());
+    ExprVisitor::visit(node->index.get());
+}
+
+void ArenaSafetyChecker::visitCall(CallNode* node) {
+    for (auto& arg : node->arguments) {
+        ExprVisitor::visit(arg.get());
+    }
+}
+
+void ArenaSafetyChecker::visitAddressOf(AddressOfNode* node) {
+    // &p does not read p
+    if (!nodeCast<IdentifierNode>(node->operand.get())) {
+        ExprVisitor::visit(node->operand.get());
+    }
+}
+
+void ArenaSafetyChecker::visitDereference(DereferenceNode* node) {
+    ExprVisitor::visit(node->operand.get());
+}
+
+void ArenaSafetyChecker::visitFieldAccess(FieldAccessNode* node) {
+    ExprVisitor::visit(node->object.get());
+}
+
+void ArenaSafetyChecker::visitStructInit(StructInitNode* node) {
+    for (auto& field : node->fields) {
+        ExprVisitor::visit(field.second.get());
+    }
+}
+
+void ArenaSafetyChecker::visitUnionInit(UnionInitNode* node) {
+    ExprVisitor::visit(node->value.get());
+}
+
+void ArenaSafetyChecker::visitMethodCall(MethodCallNode* node) {
+    ExprVisitor::visit(node->receiver.get());
+    for (auto& arg : node->arguments) {
+        ExprVisitor::visit(arg.get());
+    }
+    
+    // reset() and release() free everything allocated from the arena
+    static const Symbol reset("reset"), release("release");
+    if (node->methodName != reset && node->methodName != release) {
+        return;
+    }
+    std::string arena = pathName(node->receiver.get());
+    if (arena.empty()) {
+        return;
+    }
+    for (auto& [name, pointer] : pointers) {
+        if (pointer.arena == arena) {
+            pointer.freedBy = node->methodName == reset ? "reset" : "released";
+        }
+    }
+}
+
+void ArenaSafetyChecker::visitExprStmt(ExprStmtNode* node) {
+    ExprVisitor::visit(node->expr.get());
+}
+
+void ArenaSafetyChecker::visitVarDecl(VarDeclNode* node) {
+    std::optional<Pointer> pointer;
+    if (node->initializer) {
+        ExprVisitor::visit(node->initializer.get());
+        pointer = pointerOf(node->initializer.get());
+    }
+    declare(node->name, pointer);
+}
+
+void ArenaSafetyChecker::visitAssignment(AssignmentNode* node) {
+    assign(node->target.get(), node->value.get());
+}
+
+void ArenaSafetyChecker::visitBlock(BlockNode* node) {
+    scopes.emplace_back();
+    for (auto& stmt : node->statements) {
+        if (terminated) {
+            break; // unreachable
+        }
+        StmtVisitor::visit(stmt.get());
+    }
+    
+    endScope();
+}
+
+void ArenaSafetyChecker::visitReturn(ReturnNode* node) {
+    if (node->value) {
+        ExprVisitor::visit(node->value.get());
+    }
+    terminated = true;
+}
+
+void ArenaSafetyChecker::visitIf(IfNode* node) {
+    ExprVisitor::visit(node->condition.get());
+    State before = pointers;
+    
+    StmtVisitor::visit(node->thenBranch.get());
+    State afterThen = std::move(pointers);
+    bool thenTerminated = terminated;
+    
+    pointers = std::move(before);
+    terminated = false;
+    if (node->elseBranch) {
+        StmtVisitor::visit(node->elseBranch.get());
+    }
+    
+    pointers = merge(afterThen, thenTerminated, pointers, terminated);
+    terminated = thenTerminated && terminated;
+}
+
+void ArenaSafetyChecker::visitWhile(WhileNode* node) {
+    ExprVisitor::visit(node->condition.get());
+    State before = pointers;
+    
+    // Uses in the body are checked as on the first iteration
+    StmtVisitor::visit(node->body.get());
+    pointers = merge(before, false, pointers, terminated);
+    terminated = false;
+}
+
+void ArenaSafetyChecker::visitFor(ForNode* node) {
+    ExprVisitor::visit(node->collection.get());
+    State before = pointers;
+    
+    scopes.emplace_back();
+    declare(node->iteratorName, std::nullopt);
+    StmtVisitor::visit(node->body.get());
+    endScope();
+    
+    pointers = merge(before, false, pointers, terminated);
+    terminated = false;
+}
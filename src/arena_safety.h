@@ -0,0 +1,80 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "ast_visitor.h"
+
+// Check run after constant folding that rejects uses of dangling arena
+// pointers. A local pointer initialized or assigned from `a.alloc[T](n)`, or
+// copied from such a pointer, points into arena `a`. After `a.reset()` or
+// `a.release()` it dangles until it is assigned again, and reading it is an
+// error.
+//
+// Arenas are matched by how the receiver is spelled, e.g. "a" or
+// "self.scratch". The check follows statements in order and reports only
+// uses that dangle on every path reaching them: after an if, a pointer
+// dangles when it dangles at the end of both branches, and a loop body may
+// run zero times. Pointers stored in fields or reached through another
+// arena are not tracked.
+class ArenaSafetyChecker : public ExprVisitor<ArenaSafetyChecker>, public StmtVisitor<ArenaSafetyChecker> {
+private:
+    friend class ExprVisitor<ArenaSafetyChecker>;
+    friend class StmtVisitor<ArenaSafetyChecker>;
+    
+    struct Pointer {
+        std::string arena;
+        std::string freedBy; // "reset" or "released" once it dangles, else empty
+    };
+    using State = std::unordered_map<Symbol, Pointer>;
+    
+    // Per-function state
+    std::string functionName;
+    State pointers;
+    bool terminated; // the current path has returned
+    
+    // Innermost block last: the entries its declarations hid, restored on exit
+    std::vector<std::vector<std::pair<Symbol, std::optional<Pointer>>>> scopes;
+    
+    void checkFunction(FunctionNode* function, const std::string& name);
+    
+    // Arena pointer an expression evaluates to, if it is one
+    std::optional<Pointer> pointerOf(ExprNode* expr) const;
+    void declare(Symbol name, std::optional<Pointer> pointer);
+    void endScope();
+    void assign(ExprNode* target, ExprNode* value);
+    
+    // State after two paths join
+    State merge(const State& a, bool aTerminated, const State& b, bool bTerminated) const;
+    
+    // Expressions
+    void visitIdentifier(IdentifierNode* node);
+    void visitBinaryOp(BinaryOpNode* node);
+    void visitUnaryOp(UnaryOpNode* node);
+    void visitArrayLiteral(ArrayLiteralNode* node);
+    void visitIndex(IndexNode* node);
+    void visitCall(CallNode* node);
+    void visitAddressOf(AddressOfNode* node);
+    void visitDereference(DereferenceNode* node);
+    void visitFieldAccess(FieldAccessNode* node);
+    void visitStructInit(StructInitNode* node);
+    void visitUnionInit(UnionInitNode* node);
+    void visitMethodCall(MethodCallNode* node);
+    
+    // Statements
+    void visitExprStmt(ExprStmtNode* node);
+    void visitVarDecl(VarDeclNode* node);
+    void visitAssignment(AssignmentNode* node);
+    void visitBlock(BlockNode* node);
+    void visitReturn(ReturnNode* node);
+    void visitIf(IfNode* node);
+    void visitWhile(WhileNode* node);
+    void visitFor(ForNode* node);
+    
+public:
+    ArenaSafetyChecker() : terminated(false) {}
+    
+    // Throws std::runtime_error at the first dangling use
+    void check(ProgramNode* program);
+};
@@ -1,4 +1,20 @@
 #include "ast.h"
+#include "vector_types.h"
+
+namespace {
+
+// Identifier-safe spelling of a C type, e.g. struct Point* -> struct_Pointp
+std::string mangle(const std::string& cType) {
+    std::string name;
+    for (char c : cType) {
+        if (c == ' ') name += '_';
+        else if (c == '*') name += 'p';
+        else name += c;
+    }
+    return name;
+}
+
+} // namespace
 
 std::string BasicTypeNode::toCType() const {
     if (typeName == "int") return "int";
@@ -8,6 +24,8 @@ std::string BasicTypeNode::toCType() const {
     if (typeName == "bool") return "int"; // C doesn't have bool
     if (typeName == "string") return "char*";
     if (typeName == "void") return "void";
+    if (typeName == "Arena") return "peach_arena";
+    if (const VectorType* vector = findVectorType(typeName)) return vector->cType();
     return typeName; // fallback
 }
 
@@ -21,6 +39,28 @@ std::string ArrayTypeNode::toCType() const {
     return elementType->toCType();
 }
 
+std::string SliceTypeNode::toCType() const {
+    // One typedef per element type, e.g. []struct Point -> peach_slice_struct_Point
+    std::string name = isRestrict ? "peach_rslice_" : "peach_slice_";
+    return name + mangle(elementType->toCType());
+}
+
+std::string VecTypeNode::toCType() const {
+    return cTypeFor(elementType->toCType());
+}
+
+std::string VecTypeNode::cTypeFor(const std::string& elementCType) {
+    return "peach_vec_" + mangle(elementCType);
+}
+
+std::string MapTypeNode::toCType() const {
+    return cTypeFor(keyType->toCType(), valueType->toCType());
+}
+
+std::string MapTypeNode::cTypeFor(const std::string& keyCType, const std::string& valueCType) {
+    return "peach_map_" + mangle(keyCType) + "_" + mangle(valueCType);
+}
+
 std::string StructTypeNode::toCType() const {
     return "struct " + structName;
 }
\ No newline at end of file
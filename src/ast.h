@@ -5,6 +5,7 @@
 #include <string>
 #include <optional>
 #include <variant>
+#include "interner.h"
 
 // Forward declarations
 class ASTNode;
@@ -12,14 +13,44 @@ class ExprNode;
 class StmtNode;
 class TypeNode;
 
-using ASTNodePtr = std::unique_ptr<ASTNode>;
-using ExprNodePtr = std::unique_ptr<ExprNode>;
-using StmtNodePtr = std::unique_ptr<StmtNode>;
-using TypeNodePtr = std::unique_ptr<TypeNode>;
+// Nodes are placed in an AstArena (see arena.h). The owning pointers only run
+// the destructor; the arena releases the memory of the whole tree at once.
+struct AstDeleter {
+    template<typename T>
+    void operator()(T* node) const { node->~T(); }
+};
+
+template<typename T>
+using AstPtr = std::unique_ptr<T, AstDeleter>;
+
+using ASTNodePtr = AstPtr<ASTNode>;
+using ExprNodePtr = AstPtr<ExprNode>;
+using StmtNodePtr = AstPtr<StmtNode>;
+using TypeNodePtr = AstPtr<TypeNode>;
+
+// Concrete node kinds, used for O(1) dispatch (see ast_visitor.h)
+enum class NodeKind {
+    // Types
+    BasicType, PointerType, ArrayType, SliceType, VecType, MapType, StructType,
+    
+    // Expressions
+    IntLiteral, LongLiteral, FloatLiteral, DoubleLiteral, StringLiteral, BoolLiteral,
+    Identifier, ArrayLiteral, Index, BinaryOp, UnaryOp, Call, AddressOf, Dereference,
+    FieldAccess, StructInit, UnionInit, MethodCall,
+    
+    // Statements
+    ExprStmt, VarDecl, Assignment, Block, Return, If, While, For,
+    StructDef, UnionDef, EnumDef, ImplBlock,
+    
+    // Top level
+    Function, Program
+};
 
 // Base AST Node
 class ASTNode {
 public:
+    const NodeKind kind;
+    
     virtual ~ASTNode() = default;
     
     // Prevent copying for safety
@@ -31,271 +62,414 @@ public:
     ASTNode& operator=(ASTNode&&) = default;
     
 protected:
-    ASTNode() = default;
+    explicit ASTNode(NodeKind k) : kind(k) {}
 };
 
+// Kind-checked downcast, returns nullptr when node is not a T
+template<typename T>
+T* nodeCast(ASTNode* node) {
+    return node && node->kind == T::Kind ? static_cast<T*>(node) : nullptr;
+}
+
+template<typename T>
+const T* nodeCast(const ASTNode* node) {
+    return node && node->kind == T::Kind ? static_cast<const T*>(node) : nullptr;
+}
+
 // Type nodes
 class TypeNode : public ASTNode {
 public:
     virtual std::string toCType() const = 0;
+    
+protected:
+    explicit TypeNode(NodeKind k) : ASTNode(k) {}
 };
 
 class BasicTypeNode : public TypeNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::BasicType;
+    
     std::string typeName;
     
-    explicit BasicTypeNode(const std::string& name) : typeName(name) {}
+    explicit BasicTypeNode(const std::string& name) : TypeNode(Kind), typeName(name) {}
     std::string toCType() const override;
 };
 
 class PointerTypeNode : public TypeNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::PointerType;
+    
     TypeNodePtr baseType;
+    bool isRestrict; // parameter emitted as `T* restrict`
     
-    explicit PointerTypeNode(TypeNodePtr base) : baseType(std::move(base)) {}
+    explicit PointerTypeNode(TypeNodePtr base)
+        : TypeNode(Kind), baseType(std::move(base)), isRestrict(false) {}
     std::string toCType() const override;
 };
 
 class ArrayTypeNode : public TypeNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::ArrayType;
+    
     TypeNodePtr elementType;
     ExprNodePtr size; // nullptr if size is inferred
     
     ArrayTypeNode(TypeNodePtr elem, ExprNodePtr s = nullptr) 
-        : elementType(std::move(elem)), size(std::move(s)) {}
+        : TypeNode(Kind), elementType(std::move(elem)), size(std::move(s)) {}
     std::string toCType() const override;
 };
 
+// []T, a pointer and a length passed by value
+class SliceTypeNode : public TypeNode {
+public:
+    static constexpr NodeKind Kind = NodeKind::SliceType;
+    
+    TypeNodePtr elementType;
+    bool isRestrict; // lowered to a slice with a restrict-qualified ptr
+    
+    explicit SliceTypeNode(TypeNodePtr elem)
+        : TypeNode(Kind), elementType(std::move(elem)), isRestrict(false) {}
+    std::string toCType() const override;
+};
+
+// Vec[T], the builtin growable array. Lowered to a struct of data, len and
+// cap with functions specialized for T, see BuiltinGenerator::generateVecFunctions.
+// A copy shares the elements, so functions that grow a Vec take *Vec[T].
+class VecTypeNode : public TypeNode {
+public:
+    static constexpr NodeKind Kind = NodeKind::VecType;
+    
+    TypeNodePtr elementType;
+    
+    explicit VecTypeNode(TypeNodePtr elem) : TypeNode(Kind), elementType(std::move(elem)) {}
+    std::string toCType() const override;
+    
+    // C name of the Vec of the given C element type, e.g. peach_vec_int
+    static std::string cTypeFor(const std::string& elementCType);
+};
+
+// Map[K, V], the builtin hash map with int, long or string keys. Lowered
+// like Vec, see BuiltinGenerator::generateMapFunctions. String keys are
+// not copied.
+class MapTypeNode : public TypeNode {
+public:
+    static constexpr NodeKind Kind = NodeKind::MapType;
+    
+    TypeNodePtr keyType;
+    TypeNodePtr valueType;
+    
+    MapTypeNode(TypeNodePtr key, TypeNodePtr value)
+        : TypeNode(Kind), keyType(std::move(key)), valueType(std::move(value)) {}
+    std::string toCType() const override;
+    
+    // C name of the Map of the given C key and value types, e.g. peach_map_charp_long
+    static std::string cTypeFor(const std::string& keyCType, const std::string& valueCType);
+};
+
 class StructTypeNode : public TypeNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::StructType;
+    
     std::string structName;
+    bool isReadOnlyReference; // parameter emitted as `const struct X*`
     
-    explicit StructTypeNode(const std::string& name) : structName(name) {}
+    explicit StructTypeNode(const std::string& name)
+        : TypeNode(Kind), structName(name), isReadOnlyReference(false) {}
     std::string toCType() const override;
 };
 // Expression nodes
 class ExprNode : public ASTNode {
 public:
     virtual ~ExprNode() = default;
+    
+protected:
+    explicit ExprNode(NodeKind k) : ASTNode(k) {}
 };
 
 class IntLiteralNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::IntLiteral;
+    
     int value;
-    explicit IntLiteralNode(int val) : value(val) {}
+    explicit IntLiteralNode(int val) : ExprNode(Kind), value(val) {}
 };
 
 class LongLiteralNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::LongLiteral;
+    
     long value;
-    explicit LongLiteralNode(long val) : value(val) {}
+    explicit LongLiteralNode(long val) : ExprNode(Kind), value(val) {}
 };
 
 class FloatLiteralNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::FloatLiteral;
+    
     float value;
-    explicit FloatLiteralNode(float val) : value(val) {}
+    explicit FloatLiteralNode(float val) : ExprNode(Kind), value(val) {}
 };
 
 class DoubleLiteralNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::DoubleLiteral;
+    
     double value;
-    explicit DoubleLiteralNode(double val) : value(val) {}
+    explicit DoubleLiteralNode(double val) : ExprNode(Kind), value(val) {}
 };
 
 class StringLiteralNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::StringLiteral;
+    
     std::string value;
-    explicit StringLiteralNode(const std::string& val) : value(val) {}
+    explicit StringLiteralNode(const std::string& val) : ExprNode(Kind), value(val) {}
 };
 
 class BoolLiteralNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::BoolLiteral;
+    
     bool value;
-    explicit BoolLiteralNode(bool val) : value(val) {}
+    explicit BoolLiteralNode(bool val) : ExprNode(Kind), value(val) {}
 };
 
 class IdentifierNode : public ExprNode {
 public:
-    std::string name;
-    explicit IdentifierNode(const std::string& n) : name(n) {}
+    static constexpr NodeKind Kind = NodeKind::Identifier;
+    
+    Symbol name;
+    explicit IdentifierNode(Symbol n) : ExprNode(Kind), name(n) {}
 };
 
 class ArrayLiteralNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::ArrayLiteral;
+    
     std::vector<ExprNodePtr> elements;
     explicit ArrayLiteralNode(std::vector<ExprNodePtr> elems) 
-        : elements(std::move(elems)) {}
+        : ExprNode(Kind), elements(std::move(elems)) {}
 };
 
 class IndexNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::Index;
+    
     ExprNodePtr array;
     ExprNodePtr index;
     
     IndexNode(ExprNodePtr arr, ExprNodePtr idx)
-        : array(std::move(arr)), index(std::move(idx)) {}
+        : ExprNode(Kind), array(std::move(arr)), index(std::move(idx)) {}
 };
 
 class BinaryOpNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::BinaryOp;
+    
     ExprNodePtr left;
     ExprNodePtr right;
     std::string op;
     
     BinaryOpNode(ExprNodePtr l, ExprNodePtr r, const std::string& o)
-        : left(std::move(l)), right(std::move(r)), op(o) {}
+        : ExprNode(Kind), left(std::move(l)), right(std::move(r)), op(o) {}
 };
 
 class UnaryOpNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::UnaryOp;
+    
     ExprNodePtr operand;
     std::string op;
     
     UnaryOpNode(ExprNodePtr o, const std::string& operation)
-        : operand(std::move(o)), op(operation) {}
+        : ExprNode(Kind), operand(std::move(o)), op(operation) {}
 };
 
 class CallNode : public ExprNode {
 public:
-    std::string functionName;
+    static constexpr NodeKind Kind = NodeKind::Call;
+    
+    Symbol functionName;
     std::vector<ExprNodePtr> arguments;
+    std::vector<TypeNodePtr> typeArguments; // T in Vec[T](), K and V in Map[K, V]()
     
-    CallNode(const std::string& name, std::vector<ExprNodePtr> args)
-        : functionName(name), arguments(std::move(args)) {}
+    CallNode(Symbol name, std::vector<ExprNodePtr> args, std::vector<TypeNodePtr> typeArgs = {})
+        : ExprNode(Kind), functionName(name), arguments(std::move(args)), typeArguments(std::move(typeArgs)) {}
 };
 
 class AddressOfNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::AddressOf;
+    
     ExprNodePtr operand;
-    explicit AddressOfNode(ExprNodePtr op) : operand(std::move(op)) {}
+    explicit AddressOfNode(ExprNodePtr op) : ExprNode(Kind), operand(std::move(op)) {}
 };
 
 class DereferenceNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::Dereference;
+    
     ExprNodePtr operand;
-    explicit DereferenceNode(ExprNodePtr op) : operand(std::move(op)) {}
+    explicit DereferenceNode(ExprNodePtr op) : ExprNode(Kind), operand(std::move(op)) {}
 };
 
 class FieldAccessNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::FieldAccess;
+    
     ExprNodePtr object;
-    std::string fieldName;
+    Symbol fieldName;
     
-    FieldAccessNode(ExprNodePtr obj, const std::string& field)
-        : object(std::move(obj)), fieldName(field) {}
+    FieldAccessNode(ExprNodePtr obj, Symbol field)
+        : ExprNode(Kind), object(std::move(obj)), fieldName(field) {}
 };
 
 class StructInitNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::StructInit;
+    
     std::string structName;
     std::vector<std::pair<std::string, ExprNodePtr>> fields; // field name -> value
     
     StructInitNode(const std::string& name, std::vector<std::pair<std::string, ExprNodePtr>> f)
-        : structName(name), fields(std::move(f)) {}
+        : ExprNode(Kind), structName(name), fields(std::move(f)) {}
 };
 
 class UnionInitNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::UnionInit;
+    
     std::string unionName;
     std::string activeMember; // which member is being initialized
     ExprNodePtr value;
     
     UnionInitNode(const std::string& name, const std::string& member, ExprNodePtr val)
-        : unionName(name), activeMember(member), value(std::move(val)) {}
+        : ExprNode(Kind), unionName(name), activeMember(member), value(std::move(val)) {}
 };
 
 class MethodCallNode : public ExprNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::MethodCall;
+    
     ExprNodePtr receiver;
-    std::string methodName;
+    Symbol methodName;
     std::vector<ExprNodePtr> arguments;
+    TypeNodePtr typeArgument; // T in arena.alloc[T](n), else null
     
-    MethodCallNode(ExprNodePtr rec, const std::string& name, std::vector<ExprNodePtr> args)
-        : receiver(std::move(rec)), methodName(name), arguments(std::move(args)) {}
+    MethodCallNode(ExprNodePtr rec, Symbol name, std::vector<ExprNodePtr> args, TypeNodePtr typeArg = nullptr)
+        : ExprNode(Kind), receiver(std::move(rec)), methodName(name), arguments(std::move(args)),
+          typeArgument(std::move(typeArg)) {}
 };
 
 // Statement nodes
 class StmtNode : public ASTNode {
 public:
     virtual ~StmtNode() = default;
+    
+protected:
+    explicit StmtNode(NodeKind k) : ASTNode(k) {}
 };
 
 class ExprStmtNode : public StmtNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::ExprStmt;
+    
     ExprNodePtr expr;
-    explicit ExprStmtNode(ExprNodePtr e) : expr(std::move(e)) {}
+    explicit ExprStmtNode(ExprNodePtr e) : StmtNode(Kind), expr(std::move(e)) {}
 };
 
 class VarDeclNode : public StmtNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::VarDecl;
+    
     bool isConst;
-    std::string name;
+    Symbol name;
     TypeNodePtr type;
     ExprNodePtr initializer;
     
-    VarDeclNode(bool c, const std::string& n, TypeNodePtr t, ExprNodePtr init)
-        : isConst(c), name(n), type(std::move(t)), initializer(std::move(init)) {}
+    VarDeclNode(bool c, Symbol n, TypeNodePtr t, ExprNodePtr init)
+        : StmtNode(Kind), isConst(c), name(n), type(std::move(t)), initializer(std::move(init)) {}
 };
 
 class AssignmentNode : public StmtNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::Assignment;
+    
     ExprNodePtr target;
     ExprNodePtr value;
     
     AssignmentNode(ExprNodePtr t, ExprNodePtr v)
-        : target(std::move(t)), value(std::move(v)) {}
+        : StmtNode(Kind), target(std::move(t)), value(std::move(v)) {}
 };
 
 class BlockNode : public StmtNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::Block;
+    
     std::vector<StmtNodePtr> statements;
     
     explicit BlockNode(std::vector<StmtNodePtr> stmts) 
-        : statements(std::move(stmts)) {}
+        : StmtNode(Kind), statements(std::move(stmts)) {}
 };
 
 class ReturnNode : public StmtNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::Return;
+    
     ExprNodePtr value;
-    explicit ReturnNode(ExprNodePtr val = nullptr) : value(std::move(val)) {}
+    explicit ReturnNode(ExprNodePtr val = nullptr) : StmtNode(Kind), value(std::move(val)) {}
 };
 
 class IfNode : public StmtNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::If;
+    
     ExprNodePtr condition;
     StmtNodePtr thenBranch;
     StmtNodePtr elseBranch;
     
     IfNode(ExprNodePtr cond, StmtNodePtr then, StmtNodePtr els = nullptr)
-        : condition(std::move(cond)), thenBranch(std::move(then)), 
+        : StmtNode(Kind), condition(std::move(cond)), thenBranch(std::move(then)), 
           elseBranch(std::move(els)) {}
 };
 
 class WhileNode : public StmtNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::While;
+    
     ExprNodePtr condition;
     StmtNodePtr body;
     
     WhileNode(ExprNodePtr cond, StmtNodePtr b)
-        : condition(std::move(cond)), body(std::move(b)) {}
+        : StmtNode(Kind), condition(std::move(cond)), body(std::move(b)) {}
+};
+
+// Reduction clause of a parallel loop, e.g. reduce(+: total)
+struct Reduction {
+    std::string op; // "+", "*", "min" or "max"
+    Symbol variable;
 };
 
 class ForNode : public StmtNode {
 public:
-    std::string iteratorName;
+    static constexpr NodeKind Kind = NodeKind::For;
+    
+    Symbol iteratorName;
     ExprNodePtr collection;
     StmtNodePtr body;
+    bool isParallel; // par for: iterations may run on any thread
+    std::vector<Reduction> reductions;
     
-    ForNode(const std::string& iter, ExprNodePtr coll, StmtNodePtr b)
-        : iteratorName(iter), collection(std::move(coll)), body(std::move(b)) {}
+    ForNode(Symbol iter, ExprNodePtr coll, StmtNodePtr b)
+        : StmtNode(Kind), iteratorName(iter), collection(std::move(coll)), body(std::move(b)),
+          isParallel(false) {}
 };
 
 struct StructField {
-    std::string name;
+    Symbol name;
     TypeNodePtr type;
     
-    StructField(const std::string& n, TypeNodePtr t) 
+    StructField(Symbol n, TypeNodePtr t) 
         : name(n), type(std::move(t)) {}
     
     // Move constructor and assignment
@@ -309,27 +483,31 @@ struct StructField {
 
 class StructDefNode : public StmtNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::StructDef;
+    
     std::string name;
     std::vector<StructField> fields;
     
     StructDefNode(const std::string& n, std::vector<StructField> f)
-        : name(n), fields(std::move(f)) {}
+        : StmtNode(Kind), name(n), fields(std::move(f)) {}
 };
 
 class UnionDefNode : public StmtNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::UnionDef;
+    
     std::string name;
     std::vector<StructField> fields; // Reuse StructField for union members
     
     UnionDefNode(const std::string& n, std::vector<StructField> f)
-        : name(n), fields(std::move(f)) {}
+        : StmtNode(Kind), name(n), fields(std::move(f)) {}
 };
 
 struct EnumMember {
     std::string name;
-    std::unique_ptr<ExprNode> value; // Optional explicit value
+    ExprNodePtr value; // Optional explicit value
     
-    EnumMember(const std::string& n, std::unique_ptr<ExprNode> v = nullptr) 
+    EnumMember(const std::string& n, ExprNodePtr v = nullptr) 
         : name(n), value(std::move(v)) {}
     
     // Move constructor and assignment
@@ -343,27 +521,44 @@ struct EnumMember {
 
 class EnumDefNode : public StmtNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::EnumDef;
+    
     std::string name;
     std::vector<EnumMember> members;
     
     EnumDefNode(const std::string& n, std::vector<EnumMember> m)
-        : name(n), members(std::move(m)) {}
+        : StmtNode(Kind), name(n), members(std::move(m)) {}
 };
 
 // Function and program nodes
+// Programmer's say on inlining, from @inline or @noinline
+enum class InlineHint {
+    Auto,
+    Always,
+    Never
+};
+
 class FunctionNode : public ASTNode {
 public:
-    std::string name;
-    std::vector<std::pair<std::string, TypeNodePtr>> parameters;
+    static constexpr NodeKind Kind = NodeKind::Function;
+    
+    Symbol name;
+    std::vector<std::pair<Symbol, TypeNodePtr>> parameters;
     TypeNodePtr returnType;
     StmtNodePtr body;
-    
-    FunctionNode(const std::string& n, 
-                 std::vector<std::pair<std::string, TypeNodePtr>> params,
+    bool receiverByReference;         // value receiver emitted as `const struct X*`
+    std::vector<Symbol> addressTaken; // locals other code may reach while a call runs
+    InlineHint inlineHint;
+    bool isInline;                    // inlined into its callers, see InlineAnalyzer
+    bool isExported;                  // @export, kept and visible to other units
+    
+    FunctionNode(Symbol n, 
+                 std::vector<std::pair<Symbol, TypeNodePtr>> params,
                  TypeNodePtr ret,
                  StmtNodePtr b)
-        : name(n), parameters(std::move(params)), 
-          returnType(std::move(ret)), body(std::move(b)) {}
+        : ASTNode(Kind), name(n), parameters(std::move(params)), 
+          returnType(std::move(ret)), body(std::move(b)), receiverByReference(false),
+          inlineHint(InlineHint::Auto), isInline(false), isExported(false) {}
 };
 
 enum class ReceiverType {
@@ -374,20 +569,26 @@ enum class ReceiverType {
 
 class ImplBlockNode : public StmtNode {
 public:
+    static constexpr NodeKind Kind = NodeKind::ImplBlock;
+    
     ReceiverType receiverType;
     std::string structName;
-    std::vector<std::unique_ptr<FunctionNode>> methods;
+    std::vector<AstPtr<FunctionNode>> methods;
     
-    ImplBlockNode(ReceiverType type, const std::string& name, std::vector<std::unique_ptr<FunctionNode>> m)
-        : receiverType(type), structName(name), methods(std::move(m)) {}
+    ImplBlockNode(ReceiverType type, const std::string& name, std::vector<AstPtr<FunctionNode>> m)
+        : StmtNode(Kind), receiverType(type), structName(name), methods(std::move(m)) {}
 };
 
 class ProgramNode : public ASTNode {
 public:
-    std::vector<std::unique_ptr<FunctionNode>> functions;
+    static constexpr NodeKind Kind = NodeKind::Program;
+    
+    std::vector<AstPtr<FunctionNode>> functions;
     std::vector<StmtNodePtr> globalDeclarations;
-    std::vector<std::unique_ptr<StructDefNode>> structs;
-    std::vector<std::unique_ptr<UnionDefNode>> unions;
-    std::vector<std::unique_ptr<EnumDefNode>> enums;
-    std::vector<std::unique_ptr<ImplBlockNode>> implBlocks;
+    std::vector<AstPtr<StructDefNode>> structs;
+    std::vector<AstPtr<UnionDefNode>> unions;
+    std::vector<AstPtr<EnumDefNode>> enums;
+    std::vector<AstPtr<ImplBlockNode>> implBlocks;
+    
+    ProgramNode() : ASTNode(Kind) {}
 };
\ No newline at end of file
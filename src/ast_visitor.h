@@ -0,0 +1,66 @@
+#pragma once
+#include "ast.h"
+
+// Switch-based CRTP visitors. visit() dispatches on ASTNode::kind in O(1) and
+// calls Derived::visitXxx for the concrete node. Handlers a pass does not
+// override fall back to visitExpr()/visitStmt(), which return R().
+//
+// A class that visits both expressions and statements inherits from both
+// bases and pulls in both visit() overloads with using-declarations. Handlers
+// may be private if the base is declared a friend.
+
+#define PEACH_EXPR_NODE_KINDS(X) \
+    X(IntLiteral) X(LongLiteral) X(FloatLiteral) X(DoubleLiteral) \
+    X(StringLiteral) X(BoolLiteral) X(Identifier) X(ArrayLiteral) X(Index) \
+    X(BinaryOp) X(UnaryOp) X(Call) X(AddressOf) X(Dereference) X(FieldAccess) \
+    X(StructInit) X(UnionInit) X(MethodCall)
+
+#define PEACH_STMT_NODE_KINDS(X) \
+    X(ExprStmt) X(VarDecl) X(Assignment) X(Block) X(Return) X(If) X(While) \
+    X(For) X(StructDef) X(UnionDef) X(EnumDef) X(ImplBlock)
+
+template<typename Derived, typename R = void>
+class ExprVisitor {
+public:
+    R visit(ExprNode* node) {
+        Derived* self = static_cast<Derived*>(this);
+        switch (node->kind) {
+#define PEACH_VISIT_CASE(K) \
+            case NodeKind::K: return self->visit##K(static_cast<K##Node*>(node));
+            PEACH_EXPR_NODE_KINDS(PEACH_VISIT_CASE)
+#undef PEACH_VISIT_CASE
+            default: return self->visitExpr(node);
+        }
+    }
+    
+protected:
+    R visitExpr(ExprNode*) { return R(); }
+    
+#define PEACH_VISIT_DEFAULT(K) \
+    R visit##K(K##Node* node) { return static_cast<Derived*>(this)->visitExpr(node); }
+    PEACH_EXPR_NODE_KINDS(PEACH_VISIT_DEFAULT)
+#undef PEACH_VISIT_DEFAULT
+};
+
+template<typename Derived, typename R = void>
+class StmtVisitor {
+public:
+    R visit(StmtNode* node) {
+        Derived* self = static_cast<Derived*>(this);
+        switch (node->kind) {
+#define PEACH_VISIT_CASE(K) \
+            case NodeKind::K: return self->visit##K(static_cast<K##Node*>(node));
+            PEACH_STMT_NODE_KINDS(PEACH_VISIT_CASE)
+#undef PEACH_VISIT_CASE
+            default: return self->visitStmt(node);
+        }
+    }
+    
+protected:
+    R visitStmt(StmtNode*) { return R(); }
+    
+#define PEACH_VISIT_DEFAULT(K) \
+    R visit##K(K##Node* node) { return static_cast<Derived*>(this)->visitStmt(node); }
+    PEACH_STMT_NODE_KINDS(PEACH_VISIT_DEFAULT)
+#undef PEACH_VISIT_DEFAULT
+};
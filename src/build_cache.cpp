@@ -0,0 +1,147 @@
+#include "build_cache.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+
+uint64_t rotl(uint64_t x, int bits) {
+    return (x << bits) | (x >> (64 - bits));
+}
+
+uint64_t mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+bool copyFile(const std::string& from, const std::string& to) {
+    int in = open(from.c_str(), O_RDONLY);
+    if (in < 0) {
+        return false;
+    }
+    int out = open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        close(in);
+        return false;
+    }
+    
+    char buffer[65536];
+    ssize_t count;
+    bool ok = true;
+    while ((count = read(in, buffer, sizeof(buffer))) > 0) {
+        if (write(out, buffer, count) != count) {
+            ok = false;
+            break;
+        }
+    }
+    if (count < 0) {
+        ok = false;
+    }
+    
+    close(in);
+    if (close(out) != 0) {
+        ok = false;
+    }
+    return ok;
+}
+
+} // namespace
+
+ContentHasher::ContentHasher() : lanes{PRIME1, PRIME2}, length(0) {}
+
+ContentHasher& ContentHasher::update(std::string_view bytes) {
+    const char* data = bytes.data();
+    size_t size = bytes.size();
+    
+    // Eight bytes at a time into two independent lanes, then the tail
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        lanes[0] = rotl(lanes[0] ^ (word * PRIME1), 31) * PRIME2;
+        lanes[1] = rotl(lanes[1] + (word * PRIME2), 27) * PRIME1;
+        data += 8;
+        size -= 8;
+    }
+    for (size_t i = 0; i < size; i++) {
+        uint64_t byte = static_cast<unsigned char>(data[i]);
+        lanes[0] = rotl(lanes[0] ^ (byte * PRIME1), 11) * PRIME2;
+        lanes[1] = rotl(lanes[1] + (byte * PRIME2), 13) * PRIME1;
+    }
+    
+    // Fold the running length in after every update so that field
+    // boundaries count: ("ab", "c") and ("a", "bc") hash differently
+    length += bytes.size();
+    lanes[0] ^= mix(length);
+    lanes[1] += mix(length ^ PRIME1);
+    return *this;
+}
+
+std::string ContentHasher::hexDigest() const {
+    uint64_t high = mix(lanes[0] ^ rotl(lanes[1], 17));
+    uint64_t low = mix(lanes[1] + high);
+    
+    char text[33];
+    std::snprintf(text, sizeof(text), "%016llx%016llx",
+                  static_cast<unsigned long long>(high), static_cast<unsigned long long>(low));
+    return text;
+}
+
+BuildCache::BuildCache(const std::string& dir) : directory(dir) {
+    while (directory.size() > 1 && directory.back() == '/') {
+        directory.pop_back();
+    }
+}
+
+std::string BuildCache::entryPath(const std::string& key, const std::string& extension) const {
+    return directory + "/" + key.substr(0, 2) + "/" + key + extension;
+}
+
+bool BuildCache::fetch(const std::string& key, const std::string& extension, const std::string& destination) const {
+    if (!isEnabled()) {
+        return false;
+    }
+    
+    std::string entry = entryPath(key, extension);
+    if (access(entry.c_str(), R_OK) != 0) {
+        return false;
+    }
+    
+    // A copy, not a link: the next build rewrites its outputs in place
+    std::remove(destination.c_str());
+    return copyFile(entry, destination);
+}
+
+void BuildCache::store(const std::string& key, const std::string& extension, const std::string& source) const {
+    if (!isEnabled() || key.empty()) { // empty when the caller skipped the cache
+        return;
+    }
+    
+    std::string bucket = directory + "/" + key.substr(0, 2);
+    mkdir(directory.c_str(), 0755);
+    if (mkdir(bucket.c_str(), 0755) != 0 && errno != EEXIST) {
+        return;
+    }
+    
+    // Write under a unique temporary name, then publish atomically
+    static std::atomic<unsigned> counter(0);
+    std::string temporary = bucket + "/.tmp." + std::to_string(getpid()) + "." +
+                            std::to_string(counter++) + extension;
+    if (!copyFile(source, temporary)) {
+        std::remove(temporary.c_str());
+        return;
+    }
+    if (std::rename(temporary.c_str(), entryPath(key, extension).c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
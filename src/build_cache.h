@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Streaming 128-bit content hash used for cache keys. Not cryptographic; it
+// only has to make accidental collisions between build inputs negligible.
+class ContentHasher {
+private:
+    uint64_t lanes[2];
+    uint64_t length;
+    
+public:
+    ContentHasher();
+    
+    ContentHasher& update(std::string_view bytes);
+    std::string hexDigest() const;
+};
+
+// Content-addressed store of build artifacts (generated C, objects) on local
+// disk. Entries live at <dir>/<first two hex digits>/<key><extension> and are
+// published with an atomic rename, so several peachc processes or threads can
+// share one cache. Entries are copied in and out, never linked, so that
+// rewriting a build output cannot change an entry. A default-constructed
+// cache is disabled.
+class BuildCache {
+private:
+    std::string directory;
+    
+    std::string entryPath(const std::string& key, const std::string& extension) const;
+    
+public:
+    BuildCache() = default;
+    explicit BuildCache(const std::string& dir);
+    
+    bool isEnabled() const { return !directory.empty(); }
+    
+    // Copy a cached entry to destination. Returns false on a miss.
+    bool fetch(const std::string& key, const std::string& extension, const std::string& destination) const;
+    
+    // Add the file at source to the cache. Failures are ignored: the cache
+    // is only an accelerator.
+    void store(const std::string& key, const std::string& extension, const std::string& source) const;
+};
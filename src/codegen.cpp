@@ -2,12 +2,14 @@
 #include "gen/builtin.h"
 #include "gen/func.h"
 #include "gen/stmt.h"
+#include "gen/type.h"
+#include "ast_visitor.h"
+#include "vector_types.h"
 #include <stdexcept>
 
-CodeGenerator::CodeGenerator() : indentLevel(0) {}
+CodeGenerator::CodeGenerator() : indentLevel(0), wholeProgram(false), bufferedOutput(false) {}
 
-std::string CodeGenerator::generate(std::unique_ptr<ProgramNode>& ast) {
-    output.str("");
+const OutputBuffer& CodeGenerator::generate(AstPtr<ProgramNode>& ast) {
     output.clear();
     
     // First pass: build type registry
@@ -15,15 +17,16 @@ std::string CodeGenerator::generate(std::unique_ptr<ProgramNode>& ast) {
     
     // Second pass: analyze usage
     analyzeUsage(ast.get());
+    typeRegistry.setUsesVectors(usageTracker.isVectorUsed());
     
     // Generate built-in functions and includes
-    BuiltinGenerator builtinGen(output, indentLevel, usageTracker);
+    BuiltinGenerator builtinGen(output, indentLevel, usageTracker, wholeProgram, bufferedOutput);
     builtinGen.generateAll();
     
     // Generate the program
     generateProgram(ast.get());
     
-    return output.str();
+    return output;
 }
 
 void CodeGenerator::generateProgram(ProgramNode* node) {
@@ -33,6 +36,26 @@ void CodeGenerator::generateProgram(ProgramNode* node) {
     StmtGenerator stmtGen(output, indentLevel, &typeRegistry);
     ExprGenerator exprGen(output, indentLevel, &globalSymbols, &typeRegistry);
     
+    // Vec and Map structs only point to their elements, so they go before
+    // the structs that may hold them. Declaring all names first lets them
+    // hold each other, e.g. Map[int, Vec[int]] and Vec[Map[int, int]].
+    BuiltinGenerator builtinGen(output, indentLevel, usageTracker, wholeProgram, bufferedOutput);
+    for (const auto& vec : typeRegistry.getVecs()) {
+        output << "typedef struct " << vec.name << " " << vec.name << ";\n";
+    }
+    for (const auto& map : typeRegistry.getMaps()) {
+        output << "typedef struct " << map.name << " " << map.name << ";\n";
+    }
+    if (!typeRegistry.getVecs().empty() || !typeRegistry.getMaps().empty()) {
+        output << "\n";
+    }
+    for (const auto& vec : typeRegistry.getVecs()) {
+        builtinGen.generateVecType(vec.name, vec.elementType);
+    }
+    for (const auto& map : typeRegistry.getMaps()) {
+        builtinGen.generateMapType(map.name);
+    }
+    
     // Generate struct definitions first
     for (auto& structDef : node->structs) {
         generateStruct(structDef.get());
@@ -51,8 +74,29 @@ void CodeGenerator::generateProgram(ProgramNode* node) {
         output << "\n";
     }
     
+    // Slice typedefs, after the structs their elements may refer to
+    for (const auto& slice : typeRegistry.getSlices()) {
+        output << "typedef struct { " << slice.elementType
+               << (slice.isRestrict ? "* restrict ptr" : "* ptr") << "; size_t len; } " << slice.name << ";\n";
+    }
+    
+    if (!typeRegistry.getSlices().empty()) {
+        output << "\n";
+    }
+    
+    // Vec and Map functions, now that their element types are complete
+    for (const auto& vec : typeRegistry.getVecs()) {
+        builtinGen.generateVecFunctions(vec.name, vec.elementType);
+    }
+    for (const auto& map : typeRegistry.getMaps()) {
+        builtinGen.generateMapFunctions(map.name, map.keyType, map.valueType);
+    }
+    
     // Generate global declarations
     for (auto& decl : node->globalDeclarations) {
+        if (wholeProgram) {
+            output << "static ";
+        }
         stmtGen.generate(decl.get());
         output << ";\n";
     }
@@ -63,6 +107,11 @@ void CodeGenerator::generateProgram(ProgramNode* node) {
     
     // Generate methods from impl blocks first (before functions that might use them)
     FuncGenerator funcGen(output, indentLevel, &typeRegistry);
+    funcGen.setWholeProgram(wholeProgram);
+    
+    if (wholeProgram) {
+        generatePrototypes(node, funcGen);
+    }
     
     for (auto& implBlock : node->implBlocks) {
         generateImplBlock(implBlock.get(), funcGen);
@@ -76,33 +125,104 @@ void CodeGenerator::generateProgram(ProgramNode* node) {
     }
 }
 
-void CodeGenerator::analyzeUsage(ProgramNode* node) {
-    // Analyze global declarations
-    for (auto& decl : node->globalDeclarations) {
-        analyzeStatement(decl.get());
+namespace {
+
+// Usage analysis pass: records which builtins and types the program needs and
+// registers variable types. Dispatch goes through the node kind tags.
+class UsageAnalyzer : public ExprVisitor<UsageAnalyzer>, public StmtVisitor<UsageAnalyzer> {
+private:
+    friend class ExprVisitor<UsageAnalyzer>;
+    friend class StmtVisitor<UsageAnalyzer>;
+    
+    OutputBuffer& output;
+    int& indentLevel;
+    UsageTracker& usageTracker;
+    TypeRegistry& typeRegistry;
+    
+public:
+    UsageAnalyzer(OutputBuffer& out, int& indent, UsageTracker& tracker, TypeRegistry& registry)
+        : output(out), indentLevel(indent), usageTracker(tracker), typeRegistry(registry) {}
+    
+    using ExprVisitor<UsageAnalyzer>::visit;
+    using StmtVisitor<UsageAnalyzer>::visit;
+    
+    void analyzeFunction(FunctionNode* node) {
+        if (node->isInline || node->inlineHint == InlineHint::Never) {
+            usageTracker.trackInlining();
+        }
+        for (const auto& param : node->parameters) {
+            trackRuntimeType(param.second.get());
+        }
+        if (node->returnType) {
+            trackRuntimeType(node->returnType.get());
+        }
+        
+        // Analyze function body
+        visit(node->body.get());
     }
     
-    // Analyze functions
-    for (auto& func : node->functions) {
-        analyzeFunction(func.get());
+    // Vector types, Arena, Vec and Map need their runtime wherever they
+    // appear, e.g. in []f32x8 or *Arena; each Vec[T] and Map[K, V] also
+    // gets its C type
+    void trackRuntimeType(TypeNode* type) {
+        while (type) {
+            if (auto* vecType = nodeCast<VecTypeNode>(type)) {
+                trackVec(vecType->elementType.get());
+                break;
+            } else if (auto* mapType = nodeCast<MapTypeNode>(type)) {
+                trackMap(mapType->keyType.get(), mapType->valueType.get());
+                break;
+            } else if (auto* arrayType = nodeCast<ArrayTypeNode>(type)) {
+                type = arrayType->elementType.get();
+            } else if (auto* pointerType = nodeCast<PointerTypeNode>(type)) {
+                type = pointerType->baseType.get();
+            } else if (auto* sliceType = nodeCast<SliceTypeNode>(type)) {
+                type = sliceType->elementType.get();
+            } else {
+                if (auto* basicType = nodeCast<BasicTypeNode>(type)) {
+                    if (findVectorType(basicType->typeName) || basicType->typeName == "Arena") {
+                        usageTracker.trackType(basicType->typeName);
+                    }
+                }
+                break;
+            }
+        }
     }
-}
-
-void CodeGenerator::analyzeFunction(FunctionNode* node) {
-    // Analyze function body
-    analyzeStatement(node->body.get());
-}
-
-void CodeGenerator::analyzeStatement(StmtNode* node) {
-    if (auto* block = dynamic_cast<BlockNode*>(node)) {
+    
+    void trackVec(TypeNode* elementType) {
+        // Elements may need a runtime too, e.g. Vec[Vec[f32x8]]
+        trackRuntimeType(elementType);
+        std::string elementCType = elementType->toCType();
+        typeRegistry.registerVec(VecTypeNode::cTypeFor(elementCType), elementCType);
+        usageTracker.trackType("Vec");
+    }
+    
+    void trackMap(TypeNode* keyType, TypeNode* valueType) {
+        // Keys are hashed and compared by the runtime, which knows these
+        std::string keyCType = keyType->toCType();
+        if (keyCType != "int" && keyCType != "long" && keyCType != "char*") {
+            throw std::runtime_error("Map keys must be int, long or string, not '" + keyCType + "'");
+        }
+        trackRuntimeType(valueType);
+        std::string valueCType = valueType->toCType();
+        typeRegistry.registerMap(MapTypeNode::cTypeFor(keyCType, valueCType), keyCType, valueCType);
+        usageTracker.trackType("Map");
+    }
+    
+private:
+    void visitBlock(BlockNode* block) {
         for (auto& stmt : block->statements) {
-            analyzeStatement(stmt.get());
+            visit(stmt.get());
         }
-    } else if (auto* exprStmt = dynamic_cast<ExprStmtNode*>(node)) {
-        analyzeExpression(exprStmt->expr.get());
-    } else if (auto* varDecl = dynamic_cast<VarDeclNode*>(node)) {
+    }
+    
+    void visitExprStmt(ExprStmtNode* exprStmt) {
+        visit(exprStmt->expr.get());
+    }
+    
+    void visitVarDecl(VarDeclNode* varDecl) {
         if (varDecl->initializer) {
-            analyzeExpression(varDecl->initializer.get());
+            visit(varDecl->initializer.get());
             
             // Register variable type in type registry
             if (varDecl->type) {
@@ -116,94 +236,174 @@ void CodeGenerator::analyzeStatement(StmtNode* node) {
         }
         if (varDecl->type) {
             // Track type usage
-            if (auto* basicType = dynamic_cast<BasicTypeNode*>(varDecl->type.get())) {
+            if (auto* basicType = nodeCast<BasicTypeNode>(varDecl->type.get())) {
                 usageTracker.trackType(basicType->typeName);
             }
+            trackRuntimeType(varDecl->type.get());
+            
+            // Declared without a value, e.g. a global `var m: Map[int, int]`
+            if (!varDecl->initializer) {
+                typeRegistry.registerVariable(varDecl->name, varDecl->type->toCType());
+            }
         }
-    } else if (auto* ifNode = dynamic_cast<IfNode*>(node)) {
-        analyzeExpression(ifNode->condition.get());
-        analyzeStatement(ifNode->thenBranch.get());
+    }
+    
+    void visitIf(IfNode* ifNode) {
+        visit(ifNode->condition.get());
+        visit(ifNode->thenBranch.get());
         if (ifNode->elseBranch) {
-            analyzeStatement(ifNode->elseBranch.get());
+            visit(ifNode->elseBranch.get());
         }
-    } else if (auto* whileNode = dynamic_cast<WhileNode*>(node)) {
-        analyzeExpression(whileNode->condition.get());
-        analyzeStatement(whileNode->body.get());
-    } else if (auto* forNode = dynamic_cast<ForNode*>(node)) {
-        analyzeExpression(forNode->collection.get());
-        analyzeStatement(forNode->body.get());
-    } else if (auto* returnNode = dynamic_cast<ReturnNode*>(node)) {
+    }
+    
+    void visitWhile(WhileNode* whileNode) {
+        visit(whileNode->condition.get());
+        visit(whileNode->body.get());
+    }
+    
+    void visitFor(ForNode* forNode) {
+        if (forNode->isParallel) {
+            usageTracker.trackParallelLoop();
+        }
+        visit(forNode->collection.get());
+        visit(forNode->body.get());
+    }
+    
+    void visitReturn(ReturnNode* returnNode) {
         if (returnNode->value) {
-            analyzeExpression(returnNode->value.get());
+            visit(returnNode->value.get());
         }
     }
-}
-
-void CodeGenerator::analyzeExpression(ExprNode* node) {
-    if (auto* call = dynamic_cast<CallNode*>(node)) {
+    
+    void visitCall(CallNode* call) {
+        static const Symbol vecName("Vec"), mapName("Map");
         usageTracker.trackFunction(call->functionName);
+        if (call->functionName == vecName && call->typeArguments.size() == 1) {
+            trackVec(call->typeArguments[0].get());
+        } else if (call->functionName == mapName && call->typeArguments.size() == 2) {
+            trackMap(call->typeArguments[0].get(), call->typeArguments[1].get());
+        }
         for (auto& arg : call->arguments) {
-            analyzeExpression(arg.get());
+            visit(arg.get());
         }
-    } else if (auto* binOp = dynamic_cast<BinaryOpNode*>(node)) {
-        analyzeExpression(binOp->left.get());
-        analyzeExpression(binOp->right.get());
-    } else if (auto* unaryOp = dynamic_cast<UnaryOpNode*>(node)) {
-        analyzeExpression(unaryOp->operand.get());
-    } else if (auto* indexNode = dynamic_cast<IndexNode*>(node)) {
-        analyzeExpression(indexNode->array.get());
-        analyzeExpression(indexNode->index.get());
-    } else if (auto* addrOf = dynamic_cast<AddressOfNode*>(node)) {
-        analyzeExpression(addrOf->operand.get());
-    } else if (auto* deref = dynamic_cast<DereferenceNode*>(node)) {
-        analyzeExpression(deref->operand.get());
-    } else if (auto* arrayLit = dynamic_cast<ArrayLiteralNode*>(node)) {
+    }
+    
+    void visitBinaryOp(BinaryOpNode* binOp) {
+        visit(binOp->left.get());
+        visit(binOp->right.get());
+    }
+    
+    void visitUnaryOp(UnaryOpNode* unaryOp) {
+        visit(unaryOp->operand.get());
+    }
+    
+    void visitIndex(IndexNode* indexNode) {
+        visit(indexNode->array.get());
+        visit(indexNode->index.get());
+    }
+    
+    void visitAddressOf(AddressOfNode* addrOf) {
+        visit(addrOf->operand.get());
+    }
+    
+    void visitDereference(DereferenceNode* deref) {
+        visit(deref->operand.get());
+    }
+    
+    void visitArrayLiteral(ArrayLiteralNode* arrayLit) {
         for (auto& elem : arrayLit->elements) {
-            analyzeExpression(elem.get());
+            visit(elem.get());
         }
-    } else if (auto* fieldAccess = dynamic_cast<FieldAccessNode*>(node)) {
-        analyzeExpression(fieldAccess->object.get());
+    }
+    
+    void visitFieldAccess(FieldAccessNode* fieldAccess) {
+        visit(fieldAccess->object.get());
         // Track that we're accessing fields (might need struct types)
-    } else if (auto* structInit = dynamic_cast<StructInitNode*>(node)) {
+    }
+    
+    void visitStructInit(StructInitNode* structInit) {
         for (const auto& field : structInit->fields) {
-            analyzeExpression(field.second.get());
+            visit(field.second.get());
         }
-    } else if (auto* methodCall = dynamic_cast<MethodCallNode*>(node)) {
-        analyzeExpression(methodCall->receiver.get());
+    }
+    
+    void visitMethodCall(MethodCallNode* methodCall) {
+        visit(methodCall->receiver.get());
         for (auto& arg : methodCall->arguments) {
-            analyzeExpression(arg.get());
+            visit(arg.get());
         }
-    } else if (dynamic_cast<DoubleLiteralNode*>(node)) {
-        usageTracker.trackType("double");
-    } else if (dynamic_cast<FloatLiteralNode*>(node)) {
-        usageTracker.trackType("float");
-    } else if (dynamic_cast<IntLiteralNode*>(node)) {
-        usageTracker.trackType("int");
-    } else if (dynamic_cast<LongLiteralNode*>(node)) {
-        usageTracker.trackType("long");
-    } else if (dynamic_cast<StringLiteralNode*>(node)) {
-        usageTracker.trackType("string");
-    } else if (dynamic_cast<BoolLiteralNode*>(node)) {
-        usageTracker.trackType("bool");
     }
+    
+    void visitDoubleLiteral(DoubleLiteralNode*) { usageTracker.trackType("double"); }
+    void visitFloatLiteral(FloatLiteralNode*) { usageTracker.trackType("float"); }
+    void visitIntLiteral(IntLiteralNode*) { usageTracker.trackType("int"); }
+    void visitLongLiteral(LongLiteralNode*) { usageTracker.trackType("long"); }
+    void visitStringLiteral(StringLiteralNode*) { usageTracker.trackType("string"); }
+    void visitBoolLiteral(BoolLiteralNode*) { usageTracker.trackType("bool"); }
+    
     // Identifiers don't need analysis
+};
+
+} // namespace
+
+void CodeGenerator::analyzeUsage(ProgramNode* node) {
+    UsageAnalyzer analyzer(output, indentLevel, usageTracker, typeRegistry);
+    
+    // Fields of struct and union types
+    for (auto& structDef : node->structs) {
+        for (auto& field : structDef->fields) {
+            analyzer.trackRuntimeType(field.type.get());
+        }
+    }
+    for (auto& unionDef : node->unions) {
+        for (auto& field : unionDef->fields) {
+            analyzer.trackRuntimeType(field.type.get());
+        }
+    }
+    
+    // Analyze global declarations
+    for (auto& decl : node->globalDeclarations) {
+        analyzer.visit(decl.get());
+    }
+    
+    // Analyze methods and functions
+    for (auto& implBlock : node->implBlocks) {
+        for (auto& method : implBlock->methods) {
+            analyzer.analyzeFunction(method.get());
+        }
+    }
+    for (auto& func : node->functions) {
+        analyzer.analyzeFunction(func.get());
+    }
 }
 
 void CodeGenerator::generateStruct(StructDefNode* node) {
     output << "struct " << node->name << " {\n";
     
     for (const auto& field : node->fields) {
-        output << "    " << field.type->toCType() << " " << field.name << ";\n";
+        generateField(field);
     }
     
     output << "};\n";
 }
 
+void CodeGenerator::generateField(const StructField& field) {
+    output << "    ";
+    if (auto* arrayType = nodeCast<ArrayTypeNode>(field.type.get())) {
+        // Array fields need their (folded) dimensions after the name
+        TypeGenerator typeGen(output, indentLevel);
+        output << typeGen.generateArrayDeclaration(arrayType, field.name, nullptr);
+    } else {
+        output << field.type->toCType() << " " << field.name;
+    }
+    output << ";\n";
+}
+
 void CodeGenerator::generateUnion(UnionDefNode* node) {
     output << "union " << node->name << " {\n";
     
     for (const auto& field : node->fields) {
-        output << "    " << field.type->toCType() << " " << field.name << ";\n";
+        generateField(field);
     }
     
     output << "};\n";
@@ -235,40 +435,66 @@ void CodeGenerator::generateEnum(EnumDefNode* node) {
 void CodeGenerator::generateImplBlock(ImplBlockNode* node, FuncGenerator& funcGen) {
     // Generate methods with special naming convention and receiver parameter
     for (auto& method : node->methods) {
-        // Create method name: __StructName_methodName format
-        std::string methodName = "__" + node->structName + "_" + method->name;
-        
-        // Add suffix for pointer receiver
-        if (node->receiverType == ReceiverType::Pointer) {
-            methodName += "_p";
-        }
-        
-        // Generate function signature
-        std::string returnType = method->returnType ? method->returnType->toCType() : "void";
-        output << returnType << " " << methodName << "(";
-        
-        // Add receiver parameter first
-        if (node->receiverType == ReceiverType::Value) {
-            output << "struct " << node->structName << " self";
-        } else if (node->receiverType == ReceiverType::Pointer) {
-            output << "struct " << node->structName << "* self";
-        } else { // Reference
-            output << "struct " << node->structName << "* self";
-        }
-        
-        // Add other parameters
-        for (const auto& param : method->parameters) {
-            output << ", " << param.second->toCType() << " " << param.first;
-        }
-        
-        output << ") ";
+        funcGen.markFunctionStart();
+        generateMethodSignature(node, method.get(), funcGen);
+        output << " ";
         
         // Generate function body using the existing function generator
-        funcGen.generateBody(method.get());
+        std::string receiverType = "struct " + node->structName;
+        if (node->receiverType != ReceiverType::Value) {
+            receiverType += "*"; // Pointer or reference
+        }
+        funcGen.generateBody(method.get(), receiverType);
         output << "\n";
     }
 }
 
+void CodeGenerator::generateMethodSignature(ImplBlockNode* implBlock, FunctionNode* method, FuncGenerator& funcGen) {
+    // Create method name: __StructName_methodName format
+    std::string methodName = "__" + implBlock->structName + "_" + method->name.str();
+    
+    // Add suffix for pointer receiver
+    if (implBlock->receiverType == ReceiverType::Pointer) {
+        methodName += "_p";
+    }
+    
+    funcGen.generateSpecifiers(method);
+    std::string returnType = method->returnType ? method->returnType->toCType() : "void";
+    output << returnType << " " << methodName << "(";
+    
+    // Add receiver parameter first
+    std::string receiverType = "struct " + implBlock->structName;
+    if (implBlock->receiverType != ReceiverType::Value) {
+        receiverType += "*"; // Pointer or reference
+    }
+    if (method->receiverByReference) {
+        output << "const " << receiverType << "* self"; // read-only, see EscapeAnalyzer
+    } else {
+        output << receiverType << " self";
+    }
+    
+    // Add other parameters
+    TypeGenerator typeGen(output, indentLevel);
+    for (const auto& param : method->parameters) {
+        output << ", " << typeGen.generateParameterDeclaration(param.second.get(), param.first.str());
+    }
+    
+    output << ")";
+}
+
+void CodeGenerator::generatePrototypes(ProgramNode* node, FuncGenerator& funcGen) {
+    for (auto& implBlock : node->implBlocks) {
+        for (auto& method : implBlock->methods) {
+            generateMethodSignature(implBlock.get(), method.get(), funcGen);
+            output << ";\n";
+        }
+    }
+    for (auto& func : node->functions) {
+        funcGen.generatePrototype(func.get());
+    }
+    output << "\n";
+}
+
 void CodeGenerator::buildTypeRegistry(ProgramNode* node) {
     // Clear previous type information
     typeRegistry.clear();
@@ -278,7 +504,7 @@ void CodeGenerator::buildTypeRegistry(ProgramNode* node) {
         typeRegistry.registerStruct(structDef->name);
         
         for (const auto& field : structDef->fields) {
-            typeRegistry.addStructField(structDef->name, field.name, field.type->toCType());
+            typeRegistry.addStructField(structDef->name, field.name, TypeGenerator::declaredType(field.type.get()));
         }
     }
     
@@ -287,7 +513,7 @@ void CodeGenerator::buildTypeRegistry(ProgramNode* node) {
         typeRegistry.registerStruct(unionDef->name); // Use same registration for unions
         
         for (const auto& field : unionDef->fields) {
-            typeRegistry.addStructField(unionDef->name, field.name, field.type->toCType());
+            typeRegistry.addStructField(unionDef->name, field.name, TypeGenerator::declaredType(field.type.get()));
         }
     }
     
@@ -301,14 +527,33 @@ void CodeGenerator::buildTypeRegistry(ProgramNode* node) {
         for (const auto& method : implBlock->methods) {
             std::vector<std::string> paramTypes;
             for (const auto& param : method->parameters) {
-                paramTypes.push_back(param.second->toCType());
+                registerSliceType(param.second.get());
+                paramTypes.push_back(TypeGenerator::parameterCType(param.second.get()));
             }
             
             std::string returnType = method->returnType ? method->returnType->toCType() : "void";
             MethodInfo methodInfo(method->name, returnType, paramTypes, 
-                                  implBlock->receiverType == ReceiverType::Pointer);
+                                  implBlock->receiverType == ReceiverType::Pointer,
+                                  method->receiverByReference);
             
             typeRegistry.addStructMethod(implBlock->structName, methodInfo);
         }
     }
+    
+    // Register function signatures
+    for (const auto& func : node->functions) {
+        std::vector<std::string> paramTypes;
+        for (const auto& param : func->parameters) {
+            registerSliceType(param.second.get());
+            paramTypes.push_back(TypeGenerator::parameterCType(param.second.get()));
+        }
+        typeRegistry.registerFunction(func->name, paramTypes);
+    }
+}
+
+void CodeGenerator::registerSliceType(TypeNode* type) {
+    if (auto* sliceType = nodeCast<SliceTypeNode>(type)) {
+        typeRegistry.registerSlice(sliceType->toCType(), sliceType->elementType->toCType(),
+                                   sliceType->isRestrict);
+    }
 }
\ No newline at end of file
@@ -1,31 +1,45 @@
 #pragma once
 #include <string>
-#include <sstream>
 #include <memory>
 #include "ast.h"
 #include "usage_tracker.h"
 #include "type_registry.h"
+#include "gen/output_buffer.h"
 
 class CodeGenerator {
 private:
-    std::stringstream output;
+    OutputBuffer output;
     int indentLevel;
     UsageTracker usageTracker;
     TypeRegistry typeRegistry;
+    bool wholeProgram; // the program is the only unit, see setWholeProgram
+    bool bufferedOutput;
     
 public:
     CodeGenerator();
-    std::string generate(std::unique_ptr<ProgramNode>& ast);
+    
+    // The program is every source of the executable merged (--amalgamate):
+    // functions other than main and globals get internal linkage, and all
+    // functions are declared up front since files may call each other
+    void setWholeProgram(bool whole) { wholeProgram = whole; }
+    
+    // print keeps output in a large per-thread buffer written with write(2),
+    // see BuiltinGenerator::generatePrintFunctions
+    void setBufferedOutput(bool buffered) { bufferedOutput = buffered; }
+    
+    // The returned buffer is owned by the generator
+    const OutputBuffer& generate(AstPtr<ProgramNode>& ast);
     
 private:
     void generateProgram(ProgramNode* node);
     void generateStruct(StructDefNode* node);
     void generateUnion(UnionDefNode* node);
+    void generateField(const StructField& field);
     void generateEnum(EnumDefNode* node);
     void generateImplBlock(ImplBlockNode* node, class FuncGenerator& funcGen);
+    void generateMethodSignature(ImplBlockNode* implBlock, FunctionNode* method, class FuncGenerator& funcGen);
+    void generatePrototypes(ProgramNode* node, class FuncGenerator& funcGen);
     void analyzeUsage(ProgramNode* node);
-    void analyzeFunction(FunctionNode* node);
-    void analyzeStatement(StmtNode* node);
-    void analyzeExpression(ExprNode* node);
     void buildTypeRegistry(ProgramNode* node);
+    void registerSliceType(TypeNode* type);
 };
\ No newline at end of file
@@ -1,110 +1,561 @@
 #include "compiler.h"
-#include <fstream>
+#include "source_file.h"
+#include "process.h"
+#include "const_fold.h"
+#include "arena_safety.h"
+#include "dead_code.h"
+#include "alias_analysis.h"
+#include "escape_analysis.h"
+#include "inline_analysis.h"
+#include "version.h"
 #include <sstream>
 #include <iostream>
-#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
 
-std::string PeachCompiler::generateCSource(const std::string& filename) {
-    // Read source file
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Cannot open file: " + filename);
+namespace {
+
+// Generated files are named after the source, "dir/prog.peach" -> "dir/prog.c"
+std::string baseNameOf(const std::string& filename) {
+    return filename.substr(0, filename.find_last_of('.'));
+}
+
+std::vector<std::unique_ptr<SourceFile>> openSources(const std::vector<std::string>& filenames) {
+    std::vector<std::unique_ptr<SourceFile>> files;
+    for (const auto& filename : filenames) {
+        files.push_back(std::make_unique<SourceFile>(filename));
+    }
+    return files;
+}
+
+SourceList sourceList(const std::vector<std::unique_ptr<SourceFile>>& files) {
+    SourceList sources;
+    for (const auto& file : files) {
+        sources.push_back(file.get());
+    }
+    return sources;
+}
+
+// Identity of this peachc build for cache keys: a digest of the running
+// executable, so entries written by any other build are never reused.
+// PEACH_VERSION and the build time stand in where the executable cannot be read.
+const std::string& compilerIdentity() {
+    static const std::string identity = [] {
+        try {
+            SourceFile executable("/proc/self/exe");
+            return ContentHasher().update(executable.view()).hexDigest();
+        } catch (const std::exception&) {
+            return std::string(PEACH_VERSION " " __DATE__ " " __TIME__);
+        }
+    }();
+    return identity;
+}
+
+bool sameType(TypeNode* a, TypeNode* b) {
+    auto* arrayA = nodeCast<ArrayTypeNode>(a);
+    auto* arrayB = nodeCast<ArrayTypeNode>(b);
+    if (arrayA || arrayB) {
+        auto* sizeA = arrayA ? nodeCast<IntLiteralNode>(arrayA->size.get()) : nullptr;
+        auto* sizeB = arrayB ? nodeCast<IntLiteralNode>(arrayB->size.get()) : nullptr;
+        return sizeA && sizeB && sizeA->value == sizeB->value &&
+               sameType(arrayA->elementType.get(), arrayB->elementType.get());
+    }
+    return a->toCType() == b->toCType();
+}
+
+bool sameFields(const std::vector<StructField>& a, const std::vector<StructField>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].name != b[i].name || !sameType(a[i].type.get(), b[i].type.get())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Def, typename Name>
+Def* findDefinition(std::vector<AstPtr<Def>>& definitions, const Name& name) {
+    for (auto& definition : definitions) {
+        if (definition->name == name) {
+            return definition.get();
+        }
+    }
+    return nullptr;
+}
+
+// Move the definitions of `from` into `into`. Files have no imports, so each
+// repeats the types it uses; identical copies are dropped. Functions, methods
+// and globals defined twice could not have been linked separately either.
+void mergeProgram(ProgramNode& into, ProgramNode& from) {
+    for (auto& structDef : from.structs) {
+        if (StructDefNode* existing = findDefinition(into.structs, structDef->name)) {
+            if (!sameFields(existing->fields, structDef->fields)) {
+                throw std::runtime_error("Struct '" + structDef->name + "' is defined differently in two source files");
+            }
+            continue;
+        }
+        into.structs.push_back(std::move(structDef));
+    }
+    
+    for (auto& unionDef : from.unions) {
+        if (UnionDefNode* existing = findDefinition(into.unions, unionDef->name)) {
+            if (!sameFields(existing->fields, unionDef->fields)) {
+                throw std::runtime_error("Union '" + unionDef->name + "' is defined differently in two source files");
+            }
+            continue;
+        }
+        into.unions.push_back(std::move(unionDef));
     }
     
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string source = buffer.str();
-    file.close();
+    for (auto& enumDef : from.enums) {
+        if (EnumDefNode* existing = findDefinition(into.enums, enumDef->name)) {
+            bool same = existing->members.size() == enumDef->members.size();
+            for (size_t i = 0; same && i < existing->members.size(); i++) {
+                same = existing->members[i].name == enumDef->members[i].name;
+            }
+            if (!same) {
+                throw std::runtime_error("Enum '" + enumDef->name + "' is defined differently in two source files");
+            }
+            continue;
+        }
+        into.enums.push_back(std::move(enumDef));
+    }
     
+    for (auto& decl : from.globalDeclarations) {
+        auto* varDecl = nodeCast<VarDeclNode>(decl.get());
+        for (auto& other : into.globalDeclarations) {
+            auto* otherDecl = nodeCast<VarDeclNode>(other.get());
+            if (varDecl && otherDecl && otherDecl->name == varDecl->name) {
+                throw std::runtime_error("Global '" + varDecl->name.str() + "' is defined in two source files");
+            }
+        }
+        into.globalDeclarations.push_back(std::move(decl));
+    }
+    
+    for (auto& implBlock : from.implBlocks) {
+        for (auto& method : implBlock->methods) {
+            for (auto& other : into.implBlocks) {
+                if (other->structName == implBlock->structName &&
+                    findDefinition(other->methods, method->name)) {
+                    throw std::runtime_error("Method '" + implBlock->structName + "." + method->name.str() +
+                                             "' is defined in two source files");
+                }
+            }
+        }
+        into.implBlocks.push_back(std::move(implBlock));
+    }
+    
+    for (auto& function : from.functions) {
+        if (findDefinition(into.functions, function->name)) {
+            throw std::runtime_error("Function '" + function->name.str() + "' is defined in two source files");
+        }
+        into.functions.push_back(std::move(function));
+    }
+}
+
+} // namespace
+
+std::string PeachCompiler::generateCSource(const std::string& filename, std::ostream& log) {
+    // Map the source file; tokens slice it in place
+    SourceFile source(filename);
+    return translate({&source}, baseNameOf(filename), log);
+}
+
+std::string PeachCompiler::generateAmalgamatedSource(const std::vector<std::string>& filenames, std::ostream& log) {
+    auto files = openSources(filenames);
+    return translate(sourceList(files), baseNameOf(filenames.front()), log);
+}
+
+std::vector<std::string> PeachCompiler::cFlags() const {
+    // Passing 32-byte vectors to the SIMD helpers only draws ABI notes
+    std::vector<std::string> flags = {"-std=c11", "-Wno-psabi"};
+    std::vector<std::string> codegen = codegenFlags();
+    flags.insert(flags.end(), codegen.begin(), codegen.end());
+    return flags;
+}
+
+std::vector<std::string> PeachCompiler::codegenFlags() const {
+    // The link step needs these too: LTO optimizes there, and an
+    // instrumented program links against gcov
+    std::vector<std::string> flags = {"-O" + std::to_string(optimizationLevel)};
+    flags.insert(flags.end(), targetFlags.begin(), targetFlags.end());
+    
+    if (profileMode == ProfileMode::Generate) {
+        flags.push_back("-fprofile-generate=" + profileDir);
+        flags.push_back("-fprofile-update=prefer-atomic"); // par for workers share the counters
+    } else if (profileMode == ProfileMode::Use) {
+        flags.push_back("-fprofile-use=" + profileDir);
+    }
+    return flags;
+}
+
+bool PeachCompiler::cachesObjects() const {
+    // The profile is an input the cache key does not cover
+    return cache.isEnabled() && profileMode != ProfileMode::Use;
+}
+
+std::string PeachCompiler::cacheKey(const SourceList& sources, const std::string& artifact) const {
+    // Everything that can change the artifact for the same source bytes
+    ContentHasher hasher;
+    hasher.update(compilerIdentity()).update(artifact);
+    if (artifact == "o") {
+        for (const auto& flag : cFlags()) {
+            hasher.update(flag);
+        }
+    }
+    if (amalgamate) {
+        hasher.update("amalgamate");
+    }
+    if (separateUnits) {
+        hasher.update("separate"); // keeps every function
+    }
+    if (bufferedOutput) {
+        hasher.update("buffered-output");
+    }
+    for (const SourceFile* source : sources) {
+        // Lengths keep file boundaries apart
+        hasher.update(std::to_string(source->view().size())).update(source->view());
+    }
+    return hasher.hexDigest();
+}
+
+std::string PeachCompiler::translate(const SourceList& sources, const std::string& baseName, std::ostream& log) {
+    std::string cFilename = baseName + ".c";
+    
+    // A cache hit skips the frontend entirely
+    std::string key;
+    if (cache.isEnabled()) {
+        key = cacheKey(sources, "c");
+        if (cache.fetch(key, ".c", cFilename)) {
+            if (verbose) {
+                log << "  Cache hit: " << cFilename << "\n";
+            }
+            return cFilename;
+        }
+    }
+    
+    // Write C code to a new file. An old one may still be a hard link to a
+    // cache entry made by an earlier peachc.
+    generateCode(sources, log, [&](const OutputBuffer& cCode) {
+        std::remove(cFilename.c_str());
+        int fd = open(cFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot write file: " + cFilename);
+        }
+        bool written = cCode.writeTo(fd);
+        if (close(fd) != 0 || !written) {
+            std::remove(cFilename.c_str());
+            throw std::runtime_error("Cannot write file: " + cFilename);
+        }
+    });
+    
+    cache.store(key, ".c", cFilename);
+    
+    return cFilename;
+}
+
+void PeachCompiler::generateCode(const SourceList& sources, std::ostream& log,
+                                 const std::function<void(const OutputBuffer&)>& consume) {
     if (verbose) {
-        std::cout << "  Lexical analysis...\n";
+        log << "  Lexing and parsing...\n";
     }
     
-    // Lexical analysis
-    Lexer lexer(source);
-    auto tokens = lexer.tokenize();
+    // The parser pulls tokens from the lexer on demand. The arena must
+    // outlive the AST, so it is declared first. Further sources are merged
+    // into the program of the first.
+    auto parseStart = std::chrono::steady_clock::now();
+    AstArena arena;
+    AstPtr<ProgramNode> ast;
+    size_t tokenCount = 0;
+    for (const SourceFile* source : sources) {
+        Lexer lexer(source->view());
+        Parser parser(lexer, arena);
+        auto program = parser.parse();
+        tokenCount += parser.getTokenCount();
+        if (!ast) {
+            ast = std::move(program);
+        } else {
+            mergeProgram(*ast, *program);
+        }
+    }
     
     if (verbose) {
-        std::cout << "  Parsing...\n";
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - parseStart;
+        if (sources.size() > 1) {
+            log << "  Amalgamated " << sources.size() << " source files\n";
+        }
+        log << "  Parsed " << tokenCount << " tokens in "
+            << static_cast<long>(elapsed.count() * 1000) << "ms ("
+            << static_cast<long>(tokenCount / std::max(elapsed.count(), 1e-9))
+            << " tokens/s)\n";
+        log << "  AST: " << arena.getNodeCount() << " nodes, "
+            << arena.getBytesUsed() / 1024 << " KiB in "
+            << arena.getChunkCount() << " arena chunks\n";
     }
     
-    // Parsing
-    Parser parser(tokens);
-    auto ast = parser.parse();
+    // Evaluate constant expressions before lowering
+    ConstantFolder folder(arena);
+    folder.fold(ast.get());
+    
+    // Reject uses of pointers into an arena after its reset() or release()
+    ArenaSafetyChecker arenaSafety;
+    arenaSafety.check(ast.get());
+    
+    // Drop functions, methods and types the program cannot reach
+    DeadCodeEliminator deadCode(separateUnits);
+    deadCode.eliminate(ast.get());
+    
+    // Find parameters that can be lowered with restrict
+    AliasAnalyzer aliases;
+    aliases.analyze(ast.get());
+    
+    // Pass read-only struct parameters by pointer
+    EscapeAnalyzer escapes;
+    escapes.analyze(ast.get());
+    
+    // Pick small functions to inline into their callers
+    InlineAnalyzer inliner;
+    inliner.analyze(ast.get());
     
     if (verbose) {
-        std::cout << "  Code generation...\n";
+        log << "  Folded " << folder.getFoldCount() << " constant expressions\n";
+        log << "  Removed " << deadCode.getRemovedFunctionCount() << " unreachable functions and "
+            << deadCode.getRemovedTypeCount() << " types\n";
+        log << "  Inferred restrict for " << aliases.getRestrictCount() << " parameters\n";
+        log << "  Passing " << escapes.getReferenceCount() << " struct parameters by const pointer\n";
+        log << "  Inlining " << inliner.getInlineCount() << " functions\n";
+        log << "  Code generation...\n";
     }
     
     // Code generation
+    auto codegenStart = std::chrono::steady_clock::now();
     CodeGenerator codegen;
-    std::string cCode = codegen.generate(ast);
+    codegen.setWholeProgram(amalgamate);
+    codegen.setBufferedOutput(bufferedOutput);
+    const OutputBuffer& cCode = codegen.generate(ast);
     
-    // Write C code to file
-    std::string cFilename = filename.substr(0, filename.find_last_of('.')) + ".c";
-    std::ofstream cFile(cFilename);
-    cFile << cCode;
-    cFile.close();
+    if (verbose) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - codegenStart;
+        log << "  Generated " << cCode.size() / 1024 << " KiB of C in "
+            << static_cast<long>(elapsed.count() * 1000) << "ms ("
+            << static_cast<long>(cCode.size() / std::max(elapsed.count(), 1e-9) / (1024 * 1024))
+            << " MiB/s)\n";
+    }
     
-    return cFilename;
+    // Hand the buffer over while the generator that owns it is alive
+    consume(cCode);
 }
 
-std::string PeachCompiler::compileToObject(const std::string& filename) {
+std::string PeachCompiler::compileToObject(const std::string& filename, std::ostream& log) {
+    SourceFile source(filename);
+    return compileSources({&source}, baseNameOf(filename), log);
+}
+
+std::string PeachCompiler::compileAmalgamated(const std::vector<std::string>& filenames, std::ostream& log) {
+    auto files = openSources(filenames);
+    return compileSources(sourceList(files), baseNameOf(filenames.front()), log);
+}
+
+std::string PeachCompiler::compileSources(const SourceList& sources, const std::string& baseName, std::ostream& log) {
+    std::string objFilename = baseName + ".o";
+    
+    // A cache hit skips both the frontend and gcc
+    std::string key;
+    if (cachesObjects()) {
+        key = cacheKey(sources, "o");
+        if (cache.fetch(key, ".o", objFilename)) {
+            if (verbose) {
+                log << "  Cache hit: " << objFilename << "\n";
+            }
+            return objFilename;
+        }
+    }
+    
+    std::vector<std::string> command = {"gcc"};
+    std::vector<std::string> flags = cFlags();
+    command.insert(command.end(), flags.begin(), flags.end());
+    
+    if (pipeToGcc) {
+        compileThroughPipe(sources, command, objFilename, log);
+        cache.store(key, ".o", objFilename);
+        return objFilename;
+    }
+    
     // First generate C source
-    std::string cFilename = generateCSource(filename);
+    std::string cFilename = translate(sources, baseName, log);
     
     // Compile C to object file
-    std::string objFilename = filename.substr(0, filename.find_last_of('.')) + ".o";
-    std::string command = "gcc -std=c11 -c -o " + objFilename + " " + cFilename;
+    command.insert(command.end(), {"-c", "-o", objFilename, cFilename});
     
     if (verbose) {
-        std::cout << "  Running: " << command << "\n";
+        log << "  Running: " << formatCommand(command) << "\n";
     }
     
-    int result = std::system(command.c_str());
-    if (result != 0) {
-        // Clean up C file
+    int result;
+    try {
+        result = runProcess(command);
+    } catch (...) {
         std::remove(cFilename.c_str());
-        throw std::runtime_error("GCC compilation failed");
+        throw;
     }
     
     // Clean up C file
     std::remove(cFilename.c_str());
     
+    if (result != 0) {
+        throw std::runtime_error("GCC compilation failed");
+    }
+    
+    cache.store(key, ".o", objFilename);
+    
     return objFilename;
 }
 
+void PeachCompiler::compileThroughPipe(const SourceList& sources, std::vector<std::string> command,
+                                      const std::string& objFilename, std::ostream& log) {
+    // gcc starts up while the frontend runs and reads the C from stdin
+    command.insert(command.end(), {"-x", "c", "-c", "-o", objFilename, "-"});
+    
+    if (verbose) {
+        log << "  Running: " << formatCommand(command) << " (C piped to stdin)\n";
+    }
+    
+    int input;
+    pid_t pid = spawnProcessWithInput(command, input);
+    
+    bool written = false;
+    try {
+        generateCode(sources, log, [&](const OutputBuffer& cCode) {
+            written = cCode.writeTo(input);
+        });
+    } catch (...) {
+        // gcc sees an empty unit; drop whatever it produced
+        close(input);
+        waitProcess(pid);
+        std::remove(objFilename.c_str());
+        throw;
+    }
+    
+    close(input);
+    int result = waitProcess(pid);
+    
+    if (!written || result != 0) {
+        std::remove(objFilename.c_str());
+        throw std::runtime_error("GCC compilation failed");
+    }
+}
+
 void PeachCompiler::compile(const std::string& filename) {
-    // Generate C source
-    std::string cFilename = generateCSource(filename);
+    // Translate and compile to an object right away
+    std::string objFilename = compileToObject(filename);
+    
+    // Keep track of object files for linking
+    objectFiles.push_back(objFilename);
+}
+
+void PeachCompiler::compileAll(const std::vector<std::string>& filenames) {
+    if (amalgamate) {
+        if (verbose) std::cout << "Compiling " << filenames.size() << " files as one unit...\n";
+        objectFiles.push_back(compileAmalgamated(filenames));
+        return;
+    }
+    
+    // Each worker runs the frontend and then its own gcc -c, so the C
+    // compiler for one file overlaps with the translation of the next.
+    // Slots keep link order stable.
+    std::vector<std::string> objects(filenames.size());
+    try {
+        forEachFile(filenames.size(), [&](size_t i, std::ostream& log) {
+            if (verbose) log << "Compiling " << filenames[i] << "...\n";
+            objects[i] = compileToObject(filenames[i], log);
+        });
+    } catch (...) {
+        for (const auto& object : objects) {
+            if (!object.empty()) {
+                std::remove(object.c_str());
+            }
+        }
+        throw;
+    }
+    
+    objectFiles.insert(objectFiles.end(), objects.begin(), objects.end());
+}
+
+void PeachCompiler::forEachFile(size_t count, const std::function<void(size_t, std::ostream&)>& task) {
+    size_t workerCount = std::min(static_cast<size_t>(std::max(jobs, 1)), count);
+    
+    if (workerCount <= 1) {
+        // Serial mode: log directly and stop at the first failure
+        for (size_t i = 0; i < count; i++) {
+            task(i, std::cout);
+        }
+        return;
+    }
+    
+    std::vector<std::ostringstream> logs(count);
+    std::vector<std::exception_ptr> errors(count);
+    std::atomic<size_t> nextIndex(0);
+    
+    auto worker = [&]() {
+        for (size_t i = nextIndex++; i < count; i = nextIndex++) {
+            try {
+                task(i, logs[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < workerCount; t++) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
     
-    // Keep track of generated C files for linking
-    generatedCFiles.push_back(cFilename);
+    // Replay in input order, as the serial loop would have printed it
+    for (size_t i = 0; i < count; i++) {
+        std::cout << logs[i].str();
+        if (errors[i]) {
+            std::rethrow_exception(errors[i]);
+        }
+    }
 }
 
 void PeachCompiler::generateExecutable(const std::string& outputName) {
-    if (generatedCFiles.empty()) {
+    if (objectFiles.empty()) {
         throw std::runtime_error("No source files compiled");
     }
     
-    // Build gcc command with C11 standard
-    std::string command = "gcc -std=c11 -o " + outputName;
-    for (const auto& cFile : generatedCFiles) {
-        command += " " + cFile;
-    }
+    // Link the object files
+    std::vector<std::string> command = {"gcc"};
+    std::vector<std::string> flags = codegenFlags();
+    command.insert(command.end(), flags.begin(), flags.end());
+    command.insert(command.end(), {"-o", outputName});
+    command.insert(command.end(), objectFiles.begin(), objectFiles.end());
+    command.push_back("-pthread"); // runtime of par for loops
     
     if (verbose) {
-        std::cout << "Linking: " << command << "\n";
+        std::cout << "Linking: " << formatCommand(command) << "\n";
     }
     
-    // Execute gcc
-    int result = std::system(command.c_str());
-    if (result != 0) {
-        throw std::runtime_error("GCC compilation failed");
+    int result = runProcess(command);
+    
+    // Clean up object files
+    for (const auto& object : objectFiles) {
+        std::remove(object.c_str());
     }
     
-    // Clean up generated C files
-    for (const auto& cFile : generatedCFiles) {
-        std::remove(cFile.c_str());
+    if (result != 0) {
+        throw std::runtime_error("GCC linking failed");
     }
-}
\ No newline at end of file
+}
@@ -2,21 +2,91 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <functional>
+#include <iostream>
 #include "lexer.h"
 #include "parser.h"
 #include "codegen.h"
+#include "build_cache.h"
+
+class SourceFile;
+
+// Sources translated together into one C unit; a single file unless amalgamating
+using SourceList = std::vector<const SourceFile*>;
+
+// Phase of a profile-guided build
+enum class ProfileMode {
+    None,
+    Generate, // instrument; running the program writes .gcda files
+    Use       // optimize with the .gcda files of a Generate run
+};
 
 class PeachCompiler {
 private:
-    std::vector<std::string> generatedCFiles;
+    std::vector<std::string> objectFiles;
     bool verbose;
+    int jobs;
+    bool pipeToGcc;
+    bool amalgamate;
+    bool separateUnits; // sources are linked with other units, see setSeparateUnits
+    bool bufferedOutput;
+    int optimizationLevel;
+    std::vector<std::string> targetFlags; // -m and -f options for gcc
+    ProfileMode profileMode;
+    std::string profileDir;
+    BuildCache cache;
+    
+    void generateCode(const SourceList& sources, std::ostream& log,
+                      const std::function<void(const OutputBuffer&)>& consume);
+    std::string translate(const SourceList& sources, const std::string& baseName, std::ostream& log);
+    std::string compileSources(const SourceList& sources, const std::string& baseName, std::ostream& log);
+    void compileThroughPipe(const SourceList& sources, std::vector<std::string> command,
+                            const std::string& objFilename, std::ostream& log);
+    std::vector<std::string> cFlags() const;
+    std::vector<std::string> codegenFlags() const; // shared by compiling and linking
+    bool cachesObjects() const;
+    std::string cacheKey(const SourceList& sources, const std::string& artifact) const;
     
 public:
-    PeachCompiler() : verbose(false) {}
+    PeachCompiler()
+        : verbose(false), jobs(1), pipeToGcc(false), amalgamate(false), separateUnits(false),
+          bufferedOutput(false), optimizationLevel(0),
+          profileMode(ProfileMode::None) {}
     
     void setVerbose(bool v) { verbose = v; }
+    void setJobs(int j) { jobs = j; }
+    void setPipeToGcc(bool p) { pipeToGcc = p; }
+    
+    // Whole-program mode: compileAll merges every source into one C unit
+    // named after the first, so gcc sees all functions at once
+    void setAmalgamate(bool a) { amalgamate = a; }
+    
+    // Each unit is linked with others that may call any of its functions,
+    // so only methods and types are pruned from it, see DeadCodeEliminator
+    void setSeparateUnits(bool s) { separateUnits = s; }
+    
+    // Program output is buffered per thread and flushed with write(2) when
+    // full, on flush(), around par for loops and at exit
+    void setBufferedOutput(bool b) { bufferedOutput = b; }
+    
+    void setOptimizationLevel(int level) { optimizationLevel = level; }
+    void addTargetFlag(const std::string& flag) { targetFlags.push_back(flag); }
+    
+    // Profiles live in dir, one .gcda per object named after the object's
+    // path, so both phases must build the same sources to the same objects
+    void setProfile(ProfileMode mode, const std::string& dir) { profileMode = mode; profileDir = dir; }
+    void setCacheDir(const std::string& dir) { cache = BuildCache(dir); }
     void compile(const std::string& filename);
-    std::string generateCSource(const std::string& filename);
-    std::string compileToObject(const std::string& filename);
+    void compileAll(const std::vector<std::string>& filenames);
+    std::string generateCSource(const std::string& filename, std::ostream& log = std::cout);
+    std::string compileToObject(const std::string& filename, std::ostream& log = std::cout);
+    std::string generateAmalgamatedSource(const std::vector<std::string>& filenames, std::ostream& log = std::cout);
+    std::string compileAmalgamated(const std::vector<std::string>& filenames, std::ostream& log = std::cout);
     void generateExecutable(const std::string& outputName);
+    
+    // Run task(i, log) for i in [0, count) on up to `jobs` threads. Each
+    // task gets its own log stream which is replayed in index order, and the
+    // first failure in index order is rethrown, so output does not depend on
+    // scheduling.
+    void forEachFile(size_t count, const std::function<void(size_t, std::ostream&)>& task);
 };
\ No newline at end of file
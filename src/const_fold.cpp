@@ -0,0 +1,407 @@
+#include "const_fold.h"
+#include <climits>
+
+namespace {
+
+// Usual arithmetic conversions, restricted to the types folded here
+ConstantValue::Type commonType(ConstantValue::Type a, ConstantValue::Type b) {
+    if (a == ConstantValue::Long || b == ConstantValue::Long) {
+        return ConstantValue::Long;
+    }
+    return ConstantValue::Int;
+}
+
+// Whether value is representable as a literal of the given type. The most
+// negative value is rejected because C spells it as a negated literal that
+// does not fit its own type.
+bool fits(long value, ConstantValue::Type type) {
+    if (type == ConstantValue::Int) {
+        return value > INT_MIN && value <= INT_MAX;
+    }
+    return value > LONG_MIN;
+}
+
+std::optional<ConstantValue> evaluateArithmetic(const std::string& op, ConstantValue left, ConstantValue right) {
+    ConstantValue::Type type = commonType(left.type, right.type);
+    long a = left.value;
+    long b = right.value;
+    long result;
+    
+    if (op == "+") {
+        if (__builtin_add_overflow(a, b, &result)) return std::nullopt;
+    } else if (op == "-") {
+        if (__builtin_sub_overflow(a, b, &result)) return std::nullopt;
+    } else if (op == "*") {
+        if (__builtin_mul_overflow(a, b, &result)) return std::nullopt;
+    } else if (op == "/" || op == "%") {
+        if (b == 0 || (b == -1 && a == (type == ConstantValue::Int ? INT_MIN : LONG_MIN))) {
+            return std::nullopt;
+        }
+        result = (op == "/") ? a / b : a % b;
+    } else {
+        return std::nullopt;
+    }
+    
+    // Int arithmetic that leaves the int range overflows in C
+    if (!fits(result, type)) {
+        return std::nullopt;
+    }
+    return ConstantValue{type, result};
+}
+
+std::optional<ConstantValue> evaluateBinary(const std::string& op, ConstantValue left, ConstantValue right) {
+    long a = left.value;
+    long b = right.value;
+    
+    if (op == "==") return ConstantValue{ConstantValue::Bool, a == b};
+    if (op == "!=") return ConstantValue{ConstantValue::Bool, a != b};
+    if (op == "<") return ConstantValue{ConstantValue::Bool, a < b};
+    if (op == "<=") return ConstantValue{ConstantValue::Bool, a <= b};
+    if (op == ">") return ConstantValue{ConstantValue::Bool, a > b};
+    if (op == ">=") return ConstantValue{ConstantValue::Bool, a >= b};
+    if (op == "&&") return ConstantValue{ConstantValue::Bool, a && b};
+    if (op == "||") return ConstantValue{ConstantValue::Bool, a || b};
+    
+    return evaluateArithmetic(op, left, right);
+}
+
+// Convert a constant to a declared `val` type, as the C initialization would
+std::optional<ConstantValue> convertTo(TypeNode* type, ConstantValue constant) {
+    if (!type) {
+        return constant;
+    }
+    auto* basic = nodeCast<BasicTypeNode>(type);
+    if (!basic) {
+        return std::nullopt;
+    }
+    if (basic->typeName == "long") {
+        return ConstantValue{ConstantValue::Long, constant.value};
+    }
+    if (basic->typeName == "int" && fits(constant.value, ConstantValue::Int)) {
+        return ConstantValue{ConstantValue::Int, constant.value};
+    }
+    if (basic->typeName == "bool") {
+        return ConstantValue{ConstantValue::Bool, constant.value != 0};
+    }
+    return std::nullopt;
+}
+
+} // namespace
+
+void ConstantFolder::fold(ProgramNode* program) {
+    pushScope();
+    
+    // Enum members and global vals are visible everywhere, including in
+    // the array sizes of struct fields
+    for (auto& enumDef : program->enums) {
+        foldEnum(enumDef.get());
+    }
+    for (auto& decl : program->globalDeclarations) {
+        StmtVisitor::visit(decl.get());
+    }
+    for (auto& structDef : program->structs) {
+        foldFields(structDef->fields);
+    }
+    for (auto& unionDef : program->unions) {
+        foldFields(unionDef->fields);
+    }
+    for (auto& implBlock : program->implBlocks) {
+        visitImplBlock(implBlock.get());
+    }
+    for (auto& function : program->functions) {
+        foldFunction(function.get());
+    }
+    
+    popScope();
+}
+
+ConstantFolder::Value ConstantFolder::lookup(Symbol name) const {
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+        auto it = scope->find(name);
+        if (it != scope->end()) {
+            return it->second;
+        }
+    }
+    return std::nullopt;
+}
+
+ConstantFolder::Value ConstantFolder::foldExpr(ExprNodePtr& slot) {
+    if (!slot) {
+        return std::nullopt;
+    }
+    
+    Value value = ExprVisitor::visit(slot.get());
+    if (!value) {
+        return std::nullopt;
+    }
+    
+    // Literals already are what they would be replaced with
+    NodeKind kind = slot->kind;
+    if (kind != NodeKind::IntLiteral && kind != NodeKind::LongLiteral && kind != NodeKind::BoolLiteral) {
+        slot = makeLiteral(*value);
+        foldCount++;
+    }
+    return value;
+}
+
+void ConstantFolder::foldType(TypeNode* type) {
+    while (type) {
+        if (auto* arrayType = nodeCast<ArrayTypeNode>(type)) {
+            foldExpr(arrayType->size);
+            type = arrayType->elementType.get();
+        } else if (auto* pointerType = nodeCast<PointerTypeNode>(type)) {
+            type = pointerType->baseType.get();
+        } else if (auto* sliceType = nodeCast<SliceTypeNode>(type)) {
+            type = sliceType->elementType.get();
+        } else if (auto* vecType = nodeCast<VecTypeNode>(type)) {
+            type = vecType->elementType.get();
+        } else if (auto* mapType = nodeCast<MapTypeNode>(type)) {
+            type = mapType->valueType.get();
+        } else {
+            break;
+        }
+    }
+}
+
+void ConstantFolder::foldFunction(FunctionNode* function) {
+    for (auto& param : function->parameters) {
+        foldType(param.second.get());
+    }
+    foldType(function->returnType.get());
+    
+    // Parameters shadow outer constants
+    pushScope();
+    for (auto& param : function->parameters) {
+        declare(param.first, std::nullopt);
+    }
+    if (function->body) {
+        StmtVisitor::visit(function->body.get());
+    }
+    popScope();
+}
+
+void ConstantFolder::foldEnum(EnumDefNode* enumDef) {
+    // Members without a value continue from the previous one
+    Value next = ConstantValue{ConstantValue::Int, 0};
+    
+    for (auto& member : enumDef->members) {
+        Value value = next;
+        if (member.value) {
+            value = foldExpr(member.value);
+        }
+        
+        Symbol name(member.name);
+        if (value && fits(value->value, ConstantValue::Int)) {
+            declare(name, ConstantValue{ConstantValue::Int, value->value});
+            next = evaluateArithmetic("+", *value, ConstantValue{ConstantValue::Int, 1});
+        } else {
+            declare(name, std::nullopt);
+            next = std::nullopt;
+        }
+    }
+}
+
+void ConstantFolder::foldFields(std::vector<StructField>& fields) {
+    for (auto& field : fields) {
+        foldType(field.type.get());
+    }
+}
+
+ExprNodePtr ConstantFolder::makeLiteral(const ConstantValue& constant) {
+    switch (constant.type) {
+        case ConstantValue::Bool:
+            return arena.make<BoolLiteralNode>(constant.value != 0);
+        case ConstantValue::Int:
+            return arena.make<IntLiteralNode>(static_cast<int>(constant.value));
+        case ConstantValue::Long:
+        default:
+            return arena.make<LongLiteralNode>(constant.value);
+    }
+}
+
+ConstantFolder::Value ConstantFolder::visitIntLiteral(IntLiteralNode* node) {
+    return ConstantValue{ConstantValue::Int, node->value};
+}
+
+ConstantFolder::Value ConstantFolder::visitLongLiteral(LongLiteralNode* node) {
+    return ConstantValue{ConstantValue::Long, node->value};
+}
+
+ConstantFolder::Value ConstantFolder::visitBoolLiteral(BoolLiteralNode* node) {
+    return ConstantValue{ConstantValue::Bool, node->value};
+}
+
+ConstantFolder::Value ConstantFolder::visitIdentifier(IdentifierNode* node) {
+    return lookup(node->name);
+}
+
+ConstantFolder::Value ConstantFolder::visitBinaryOp(BinaryOpNode* node) {
+    if (node->op == "=") {
+        // The target keeps its name; only its subexpressions fold
+        ExprVisitor::visit(node->left.get());
+        foldExpr(node->right);
+        return std::nullopt;
+    }
+    
+    Value left = foldExpr(node->left);
+    Value right = foldExpr(node->right);
+    if (!left || !right) {
+        return std::nullopt;
+    }
+    return evaluateBinary(node->op, *left, *right);
+}
+
+ConstantFolder::Value ConstantFolder::visitUnaryOp(UnaryOpNode* node) {
+    Value operand = foldExpr(node->operand);
+    if (!operand) {
+        return std::nullopt;
+    }
+    
+    if (node->op == "!") {
+        return ConstantValue{ConstantValue::Bool, !operand->value};
+    }
+    if (node->op == "-") {
+        ConstantValue::Type type = commonType(operand->type, ConstantValue::Int);
+        if (!fits(operand->value, type) || !fits(-operand->value, type)) {
+            return std::nullopt;
+        }
+        return ConstantValue{type, -operand->value};
+    }
+    return std::nullopt;
+}
+
+ConstantFolder::Value ConstantFolder::visitArrayLiteral(ArrayLiteralNode* node) {
+    for (auto& element : node->elements) {
+        foldExpr(element);
+    }
+    return std::nullopt;
+}
+
+ConstantFolder::Value ConstantFolder::visitIndex(IndexNode* node) {
+    ExprVisitor::visit(node->array.get());
+    foldExpr(node->index);
+    return std::nullopt;
+}
+
+ConstantFolder::Value ConstantFolder::visitCall(CallNode* node) {
+    for (auto& arg : node->arguments) {
+        foldExpr(arg);
+    }
+    return std::nullopt;
+}
+
+ConstantFolder::Value ConstantFolder::visitAddressOf(AddressOfNode* node) {
+    // &N must keep naming the variable
+    ExprVisitor::visit(node->operand.get());
+    return std::nullopt;
+}
+
+ConstantFolder::Value ConstantFolder::visitDereference(DereferenceNode* node) {
+    foldExpr(node->operand);
+    return std::nullopt;
+}
+
+ConstantFolder::Value ConstantFolder::visitFieldAccess(FieldAccessNode* node) {
+    ExprVisitor::visit(node->object.get());
+    return std::nullopt;
+}
+
+ConstantFolder::Value ConstantFolder::visitStructInit(StructInitNode* node) {
+    for (auto& field : node->fields) {
+        foldExpr(field.second);
+    }
+    return std::nullopt;
+}
+
+ConstantFolder::Value ConstantFolder::visitUnionInit(UnionInitNode* node) {
+    foldExpr(node->value);
+    return std::nullopt;
+}
+
+ConstantFolder::Value ConstantFolder::visitMethodCall(MethodCallNode* node) {
+    // The receiver's name is needed to resolve the method
+    ExprVisitor::visit(node->receiver.get());
+    for (auto& arg : node->arguments) {
+        foldExpr(arg);
+    }
+    return std::nullopt;
+}
+
+void ConstantFolder::visitExprStmt(ExprStmtNode* node) {
+    foldExpr(node->expr);
+}
+
+void ConstantFolder::visitVarDecl(VarDeclNode* node) {
+    foldType(node->type.get());
+    Value initial = foldExpr(node->initializer);
+    
+    // Only vals with a constant initializer become constants; anything
+    // else hides an outer constant of the same name
+    Value value;
+    if (node->isConst && initial) {
+        value = convertTo(node->type.get(), *initial);
+    }
+    declare(node->name, value);
+}
+
+void ConstantFolder::visitAssignment(AssignmentNode* node) {
+    ExprVisitor::visit(node->target.get());
+    foldExpr(node->value);
+}
+
+void ConstantFolder::visitBlock(BlockNode* node) {
+    pushScope();
+    for (auto& stmt : node->statements) {
+        StmtVisitor::visit(stmt.get());
+    }
+    popScope();
+}
+
+void ConstantFolder::visitReturn(ReturnNode* node) {
+    foldExpr(node->value);
+}
+
+void ConstantFolder::visitIf(IfNode* node) {
+    foldExpr(node->condition);
+    StmtVisitor::visit(node->thenBranch.get());
+    if (node->elseBranch) {
+        StmtVisitor::visit(node->elseBranch.get());
+    }
+}
+
+void ConstantFolder::visitWhile(WhileNode* node) {
+    foldExpr(node->condition);
+    StmtVisitor::visit(node->body.get());
+}
+
+void ConstantFolder::visitFor(ForNode* node) {
+    // Range bounds fold like any other call arguments
+    foldExpr(node->collection);
+    
+    pushScope();
+    declare(node->iteratorName, std::nullopt);
+    StmtVisitor::visit(node->body.get());
+    popScope();
+}
+
+void ConstantFolder::visitStructDef(StructDefNode* node) {
+    foldFields(node->fields);
+}
+
+void ConstantFolder::visitUnionDef(UnionDefNode* node) {
+    foldFields(node->fields);
+}
+
+void ConstantFolder::visitEnumDef(EnumDefNode* node) {
+    foldEnum(node);
+}
+
+void ConstantFolder::visitImplBlock(ImplBlockNode* node) {
+    for (auto& method : node->methods) {
+        // Methods see their receiver as `self`
+        pushScope();
+        declare(Symbol("self"), std::nullopt);
+        foldFunction(method.get());
+        popScope();
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "ast_visitor.h"
+#include "arena.h"
+
+// Value of a folded integer or boolean expression. Bools take part in
+// arithmetic as 0/1, like the C they are lowered to.
+struct ConstantValue {
+    enum Type { Bool, Int, Long };
+    
+    Type type;
+    long value;
+};
+
+// Folding pass run between parsing and code generation. It evaluates integer
+// and boolean arithmetic, comparisons and logic on literals, substitutes
+// `val` constants whose initializer folds, and rewrites enum values and
+// array sizes to literals. Folded subtrees are replaced by new literal nodes
+// allocated in the unit's arena.
+//
+// Operations whose C result would be undefined or implementation-defined
+// (overflow, division by zero, shifts) are left for gcc, as is floating
+// point arithmetic.
+class ConstantFolder : public ExprVisitor<ConstantFolder, std::optional<ConstantValue>>,
+                       public StmtVisitor<ConstantFolder> {
+private:
+    friend class ExprVisitor<ConstantFolder, std::optional<ConstantValue>>;
+    friend class StmtVisitor<ConstantFolder>;
+    
+    using Value = std::optional<ConstantValue>;
+    
+    AstArena& arena;
+    size_t foldCount;
+    
+    // Innermost scope last. A name mapped to nullopt shadows outer constants.
+    std::vector<std::unordered_map<Symbol, Value>> scopes;
+    
+    void pushScope() { scopes.emplace_back(); }
+    void popScope() { scopes.pop_back(); }
+    void declare(Symbol name, Value value) { scopes.back()[name] = value; }
+    Value lookup(Symbol name) const;
+    
+    // Fold an expression in place, replacing it with a literal if it is
+    // constant. Returns the constant value, if any.
+    Value foldExpr(ExprNodePtr& slot);
+    // Fold array sizes inside a type
+    void foldType(TypeNode* type);
+    void foldFunction(FunctionNode* function);
+    void foldEnum(EnumDefNode* enumDef);
+    void foldFields(std::vector<StructField>& fields);
+    
+    ExprNodePtr makeLiteral(const ConstantValue& constant);
+    
+    // Expressions: fold children, return the node's value if constant
+    Value visitExpr(ExprNode*) { return std::nullopt; }
+    Value visitIntLiteral(IntLiteralNode* node);
+    Value visitLongLiteral(LongLiteralNode* node);
+    Value visitBoolLiteral(BoolLiteralNode* node);
+    Value visitIdentifier(IdentifierNode* node);
+    Value visitBinaryOp(BinaryOpNode* node);
+    Value visitUnaryOp(UnaryOpNode* node);
+    Value visitArrayLiteral(ArrayLiteralNode* node);
+    Value visitIndex(IndexNode* node);
+    Value visitCall(CallNode* node);
+    Value visitAddressOf(AddressOfNode* node);
+    Value visitDereference(DereferenceNode* node);
+    Value visitFieldAccess(FieldAccessNode* node);
+    Value visitStructInit(StructInitNode* node);
+    Value visitUnionInit(UnionInitNode* node);
+    Value visitMethodCall(MethodCallNode* node);
+    
+    // Statements
+    void visitExprStmt(ExprStmtNode* node);
+    void visitVarDecl(VarDeclNode* node);
+    void visitAssignment(AssignmentNode* node);
+    void visitBlock(BlockNode* node);
+    void visitReturn(ReturnNode* node);
+    void visitIf(IfNode* node);
+    void visitWhile(WhileNode* node);
+    void visitFor(ForNode* node);
+    void visitStructDef(StructDefNode* node);
+    void visitUnionDef(UnionDefNode* node);
+    void visitEnumDef(EnumDefNode* node);
+    void visitImplBlock(ImplBlockNode* node);
+    
+public:
+    explicit ConstantFolder(AstArena& a) : arena(a), foldCount(0) {}
+    
+    void fold(ProgramNode* program);
+    
+    // Number of subtrees replaced by literals
+    size_t getFoldCount() const { return foldCount; }
+};
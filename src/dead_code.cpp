@@ -0,0 +1,272 @@
+#include "dead_code.h"
+#include <algorithm>
+
+void DeadCodeEliminator::eliminate(ProgramNode* program) {
+    for (auto& function : program->functions) {
+        functions[function->name] = function.get();
+    }
+    for (auto& implBlock : program->implBlocks) {
+        for (auto& method : implBlock->methods) {
+            methods[method->name].push_back({method.get(), implBlock.get()});
+        }
+    }
+    for (auto& structDef : program->structs) {
+        structs[structDef->name] = structDef.get();
+    }
+    for (auto& unionDef : program->unions) {
+        unions[unionDef->name] = unionDef.get();
+    }
+    for (auto& enumDef : program->enums) {
+        enums[enumDef->name] = enumDef.get();
+        for (const auto& member : enumDef->members) {
+            enumMembers[member.name] = enumDef.get();
+        }
+    }
+    
+    static const Symbol main("main");
+    bool keepAll = linksOtherUnits || !functions.count(main);
+    for (auto& function : program->functions) {
+        if (keepAll || function->name == main || function->isExported) {
+            markFunction(function.get());
+        }
+    }
+    for (auto& implBlock : program->implBlocks) {
+        for (auto& method : implBlock->methods) {
+            if (keepAll || method->isExported) {
+                markFunction(method.get());
+                markType(implBlock->structName);
+            }
+        }
+    }
+    for (auto& decl : program->globalDeclarations) {
+        StmtVisitor::visit(decl.get());
+    }
+    
+    while (!worklist.empty()) {
+        FunctionNode* function = worklist.back();
+        worklist.pop_back();
+        for (auto& param : function->parameters) {
+            markType(param.second.get());
+        }
+        markType(function->returnType.get());
+        if (function->body) {
+            StmtVisitor::visit(function->body.get());
+        }
+    }
+    
+    // Remove what was never reached, keeping program order
+    auto unreached = [&](const AstPtr<FunctionNode>& function) {
+        return !reached.count(function.get());
+    };
+    for (auto& implBlock : program->implBlocks) {
+        auto& blockMethods = implBlock->methods;
+        removedFunctions += std::count_if(blockMethods.begin(), blockMethods.end(), unreached);
+        blockMethods.erase(std::remove_if(blockMethods.begin(), blockMethods.end(), unreached), blockMethods.end());
+    }
+    program->implBlocks.erase(std::remove_if(program->implBlocks.begin(), program->implBlocks.end(),
+                                             [](const AstPtr<ImplBlockNode>& implBlock) {
+                                                 return implBlock->methods.empty();
+                                             }),
+                              program->implBlocks.end());
+    
+    removedFunctions += std::count_if(program->functions.begin(), program->functions.end(), unreached);
+    program->functions.erase(std::remove_if(program->functions.begin(), program->functions.end(), unreached),
+                             program->functions.end());
+    
+    removeUnreached(program->structs);
+    removeUnreached(program->unions);
+    removeUnreached(program->enums);
+}
+
+template<typename Def>
+void DeadCodeEliminator::removeUnreached(std::vector<AstPtr<Def>>& defs) {
+    auto unreached = [&](const AstPtr<Def>& def) {
+        return !liveTypes.count(def->name);
+    };
+    removedTypes += std::count_if(defs.begin(), defs.end(), unreached);
+    defs.erase(std::remove_if(defs.begin(), defs.end(), unreached), defs.end());
+}
+
+void DeadCodeEliminator::markFunction(FunctionNode* function) {
+    if (reached.insert(function).second) {
+        worklist.push_back(function);
+    }
+}
+
+void DeadCodeEliminator::markType(const std::string& name) {
+    if (!liveTypes.insert(name).second) {
+        return;
+    }
+    
+    // Field types and enum values are needed with the definition
+    if (auto it = structs.find(name); it != structs.end()) {
+        for (const auto& field : it->second->fields) {
+            markType(field.type.get());
+        }
+    } else if (auto it = unions.find(name); it != unions.end()) {
+        for (const auto& field : it->second->fields) {
+            markType(field.type.get());
+        }
+    } else if (auto it = enums.find(name); it != enums.end()) {
+        for (const auto& member : it->second->members) {
+            if (member.value) {
+                ExprVisitor::visit(member.value.get());
+            }
+        }
+    }
+}
+
+void DeadCodeEliminator::markType(TypeNode* type) {
+    while (type) {
+        if (auto* pointerType = nodeCast<PointerTypeNode>(type)) {
+            type = pointerType->baseType.get();
+        } else if (auto* arrayType = nodeCast<ArrayTypeNode>(type)) {
+            if (arrayType->size) {
+                ExprVisitor::visit(arrayType->size.get());
+            }
+            type = arrayType->elementType.get();
+        } else if (auto* sliceType = nodeCast<SliceTypeNode>(type)) {
+            type = sliceType->elementType.get();
+        } else if (auto* vecType = nodeCast<VecTypeNode>(type)) {
+            type = vecType->elementType.get();
+        } else if (auto* mapType = nodeCast<MapTypeNode>(type)) {
+            type = mapType->valueType.get(); // keys are scalars or strings
+        } else {
+            if (auto* structType = nodeCast<StructTypeNode>(type)) {
+                markType(structType->structName); // enums and unions too
+            }
+            break;
+        }
+    }
+}
+
+void DeadCodeEliminator::markName(Symbol name) {
+    if (auto it = functions.find(name); it != functions.end()) {
+        markFunction(it->second);
+    }
+    if (auto it = enumMembers.find(name.str()); it != enumMembers.end()) {
+        markType(it->second->name);
+    }
+    const std::string& text = name.str();
+    if (structs.count(text) || unions.count(text) || enums.count(text)) {
+        markType(text); // e.g. sizeof(Point)
+    }
+}
+
+void DeadCodeEliminator::visitIdentifier(IdentifierNode* node) {
+    markName(node->name);
+}
+
+void DeadCodeEliminator::visitBinaryOp(BinaryOpNode* node) {
+    ExprVisitor::visit(node->left.get());
+    ExprVisitor::visit(node->right.get());
+}
+
+void DeadCodeEliminator::visitUnaryOp(UnaryOpNode* node) {
+    ExprVisitor::visit(node->operand.get());
+}
+
+void DeadCodeEliminator::visitArrayLiteral(ArrayLiteralNode* node) {
+    for (auto& element : node->elements) {
+        ExprVisitor::visit(element.get());
+    }
+}
+
+void DeadCodeEliminator::visitIndex(IndexNode* node) {
+    ExprVisitor::visit(node->array.get());
+    ExprVisitor::visit(node->index.get());
+}
+
+void DeadCodeEliminator::visitCall(CallNode* node) {
+    markName(node->functionName);
+    for (auto& typeArgument : node->typeArguments) {
+        markType(typeArgument.get());
+    }
+    for (auto& arg : node->arguments) {
+        ExprVisitor::visit(arg.get());
+    }
+}
+
+void DeadCodeEliminator::visitAddressOf(AddressOfNode* node) {
+    ExprVisitor::visit(node->operand.get());
+}
+
+void DeadCodeEliminator::visitDereference(DereferenceNode* node) {
+    ExprVisitor::visit(node->operand.get());
+}
+
+void DeadCodeEliminator::visitFieldAccess(FieldAccessNode* node) {
+    ExprVisitor::visit(node->object.get());
+}
+
+void DeadCodeEliminator::visitStructInit(StructInitNode* node) {
+    markType(node->structName);
+    for (auto& field : node->fields) {
+        ExprVisitor::visit(field.second.get());
+    }
+}
+
+void DeadCodeEliminator::visitUnionInit(UnionInitNode* node) {
+    markType(node->unionName);
+    ExprVisitor::visit(node->value.get());
+}
+
+void DeadCodeEliminator::visitMethodCall(MethodCallNode* node) {
+    if (auto it = methods.find(node->methodName); it != methods.end()) {
+        for (const auto& [method, implBlock] : it->second) {
+            markFunction(method);
+            markType(implBlock->structName);
+        }
+    }
+    markType(node->typeArgument.get());
+    ExprVisitor::visit(node->receiver.get());
+    for (auto& arg : node->arguments) {
+        ExprVisitor::visit(arg.get());
+    }
+}
+
+void DeadCodeEliminator::visitExprStmt(ExprStmtNode* node) {
+    ExprVisitor::visit(node->expr.get());
+}
+
+void DeadCodeEliminator::visitVarDecl(VarDeclNode* node) {
+    markType(node->type.get());
+    if (node->initializer) {
+        ExprVisitor::visit(node->initializer.get());
+    }
+}
+
+void DeadCodeEliminator::visitAssignment(AssignmentNode* node) {
+    ExprVisitor::visit(node->target.get());
+    ExprVisitor::visit(node->value.get());
+}
+
+void DeadCodeEliminator::visitBlock(BlockNode* node) {
+    for (auto& stmt : node->statements) {
+        StmtVisitor::visit(stmt.get());
+    }
+}
+
+void DeadCodeEliminator::visitReturn(ReturnNode* node) {
+    if (node->value) {
+        ExprVisitor::visit(node->value.get());
+    }
+}
+
+void DeadCodeEliminator::visitIf(IfNode* node) {
+    ExprVisitor::visit(node->condition.get());
+    StmtVisitor::visit(node->thenBranch.get());
+    if (node->elseBranch) {
+        StmtVisitor::visit(node->elseBranch.get());
+    }
+}
+
+void DeadCodeEliminator::visitWhile(WhileNode* node) {
+    ExprVisitor::visit(node->condition.get());
+    StmtVisitor::visit(node->body.get());
+}
+
+void DeadCodeEliminator::visitFor(ForNode* node) {
+    ExprVisitor::visit(node->collection.get());
+    StmtVisitor::visit(node->body.get());
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+#include "ast_visitor.h"
+
+// Dead code elimination, run right after constant folding so later passes
+// and code generation only see what the program can use. Starting from the
+// roots it follows calls, method calls and type references, then removes
+// the functions, methods, structs, unions and enums it never reached.
+//
+// Roots are main and @export functions and methods, or every function and
+// method when the unit has no main or is linked with separately compiled
+// units, which may call any of them. Global declarations are always kept.
+// Method calls are matched by name since receivers are not typed here, so a
+// call keeps every method of that name; an identifier that names a function
+// or type keeps it too.
+class DeadCodeEliminator : public ExprVisitor<DeadCodeEliminator>, public StmtVisitor<DeadCodeEliminator> {
+private:
+    friend class ExprVisitor<DeadCodeEliminator>;
+    friend class StmtVisitor<DeadCodeEliminator>;
+    
+    bool linksOtherUnits;
+    size_t removedFunctions;
+    size_t removedTypes;
+    
+    std::unordered_map<Symbol, FunctionNode*> functions;
+    std::unordered_map<Symbol, std::vector<std::pair<FunctionNode*, const ImplBlockNode*>>> methods;
+    std::unordered_map<std::string, StructDefNode*> structs;
+    std::unordered_map<std::string, UnionDefNode*> unions;
+    std::unordered_map<std::string, EnumDefNode*> enums;
+    std::unordered_map<std::string, EnumDefNode*> enumMembers; // member name -> its enum
+    
+    std::unordered_set<FunctionNode*> reached;
+    std::unordered_set<std::string> liveTypes;
+    std::vector<FunctionNode*> worklist;
+    
+    void markFunction(FunctionNode* function);
+    void markType(const std::string& name);
+    void markType(TypeNode* type);
+    void markName(Symbol name); // identifier that may name a function, type or enum member
+    
+    template<typename Def>
+    void removeUnreached(std::vector<AstPtr<Def>>& defs);
+    
+    // Expressions
+    void visitIdentifier(IdentifierNode* node);
+    void visitBinaryOp(BinaryOpNode* node);
+    void visitUnaryOp(UnaryOpNode* node);
+    void visitArrayLiteral(ArrayLiteralNode* node);
+    void visitIndex(IndexNode* node);
+    void visitCall(CallNode* node);
+    void visitAddressOf(AddressOfNode* node);
+    void visitDereference(DereferenceNode* node);
+    void visitFieldAccess(FieldAccessNode* node);
+    void visitStructInit(StructInitNode* node);
+    void visitUnionInit(UnionInitNode* node);
+    void visitMethodCall(MethodCallNode* node);
+    
+    // Statements
+    void visitExprStmt(ExprStmtNode* node);
+    void visitVarDecl(VarDeclNode* node);
+    void visitAssignment(AssignmentNode* node);
+    void visitBlock(BlockNode* node);
+    void visitReturn(ReturnNode* node);
+    void visitIf(IfNode* node);
+    void visitWhile(WhileNode* node);
+    void visitFor(ForNode* node);
+    
+public:
+    explicit DeadCodeEliminator(bool linksOtherUnits)
+        : linksOtherUnits(linksOtherUnits), removedFunctions(0), removedTypes(0) {}
+    
+    void eliminate(ProgramNode* program);
+    
+    // Functions and methods, and structs, unions and enums, removed
+    size_t getRemovedFunctionCount() const { return removedFunctions; }
+    size_t getRemovedTypeCount() const { return removedTypes; }
+};
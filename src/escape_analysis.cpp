@@ -0,0 +1,358 @@
+#include "escape_analysis.h"
+#include "vector_types.h"
+#include <algorithm>
+
+namespace {
+
+// Structs up to this size are passed in registers by the x86-64 and AArch64 ABIs
+constexpr size_t REGISTER_PASS_LIMIT = 16;
+
+// Nested struct types deeper than this are not sized
+constexpr int MAX_SIZE_DEPTH = 16;
+
+} // namespace
+
+void EscapeAnalyzer::analyze(ProgramNode* program) {
+    for (auto& structDef : program->structs) {
+        structs[structDef->name] = structDef.get();
+    }
+    for (auto& unionDef : program->unions) {
+        unions[unionDef->name] = unionDef.get();
+    }
+    // Vec, Map and Arena methods modify the receiver too, e.g. s.items.push(x)
+    for (const char* name : {"push", "pop", "reserve", "clear", "release", "remove", "alloc", "reset"}) {
+        mutatingMethods.insert(Symbol(name));
+    }
+    for (auto& implBlock : program->implBlocks) {
+        if (implBlock->receiverType != ReceiverType::Value) {
+            for (auto& method : implBlock->methods) {
+                mutatingMethods.insert(method->name);
+            }
+        }
+    }
+    
+    for (auto& implBlock : program->implBlocks) {
+        for (auto& method : implBlock->methods) {
+            analyzeFunction(method.get(), implBlock.get());
+        }
+    }
+    
+    for (auto& function : program->functions) {
+        analyzeFunction(function.get(), nullptr);
+    }
+}
+
+void EscapeAnalyzer::analyzeFunction(FunctionNode* function, const ImplBlockNode* impl) {
+    modified.clear();
+    addressTaken.clear();
+    parallelDepth = 0;
+    
+    structParameters.clear();
+    if (impl && impl->receiverType == ReceiverType::Value) {
+        structParameters[Symbol("self")] = impl->structName;
+    }
+    for (auto& param : function->parameters) {
+        if (auto* structType = nodeCast<StructTypeNode>(param.second.get())) {
+            structParameters[param.first] = structType->structName;
+        }
+    }
+    
+    if (function->body) {
+        StmtVisitor::visit(function->body.get());
+    }
+    
+    // Array parameters are pointers to the caller's elements
+    for (auto& param : function->parameters) {
+        if (nodeCast<ArrayTypeNode>(param.second.get())) {
+            addressTaken.insert(param.first);
+        }
+    }
+    function->addressTaken.assign(addressTaken.begin(), addressTaken.end());
+    
+    if (impl && impl->receiverType == ReceiverType::Value) {
+        static const Symbol self("self");
+        if (!modified.count(self) && structSize(impl->structName, 0) > REGISTER_PASS_LIMIT) {
+            function->receiverByReference = true;
+            referenceCount++;
+        }
+    }
+    
+    for (auto& param : function->parameters) {
+        auto* structType = nodeCast<StructTypeNode>(param.second.get());
+        if (structType && structs.count(structType->structName) && !modified.count(param.first) &&
+            structSize(structType->structName, 0) > REGISTER_PASS_LIMIT) {
+            structType->isReadOnlyReference = true;
+            referenceCount++;
+        }
+    }
+}
+
+size_t EscapeAnalyzer::sizeOf(TypeNode* type, int depth) const {
+    if (auto* basicType = nodeCast<BasicTypeNode>(type)) {
+        const std::string& name = basicType->typeName;
+        if (name == "int" || name == "float" || name == "bool") {
+            return 4;
+        }
+        if (name == "long" || name == "double" || name == "string") {
+            return 8;
+        }
+        if (const VectorType* vector = findVectorType(name)) {
+            size_t lane = (vector->elementType == "float" || vector->elementType == "int") ? 4 : 8;
+            return lane * vector->lanes;
+        }
+        return 0;
+    }
+    if (nodeCast<PointerTypeNode>(type)) {
+        return 8;
+    }
+    if (nodeCast<SliceTypeNode>(type)) {
+        return 16;
+    }
+    if (nodeCast<VecTypeNode>(type)) {
+        return 24;
+    }
+    if (nodeCast<MapTypeNode>(type)) {
+        return 48;
+    }
+    if (auto* arrayType = nodeCast<ArrayTypeNode>(type)) {
+        auto* size = nodeCast<IntLiteralNode>(arrayType->size.get());
+        return size ? size->value * sizeOf(arrayType->elementType.get(), depth) : 0;
+    }
+    if (auto* structType = nodeCast<StructTypeNode>(type)) {
+        return structSize(structType->structName, depth + 1);
+    }
+    return 0;
+}
+
+size_t EscapeAnalyzer::structSize(const std::string& name, int depth) const {
+    if (depth > MAX_SIZE_DEPTH) {
+        return 0;
+    }
+    
+    // Padding is ignored, the estimate only has to clear the register limit
+    size_t size = 0;
+    if (auto it = structs.find(name); it != structs.end()) {
+        for (const auto& field : it->second->fields) {
+            size += sizeOf(field.type.get(), depth);
+        }
+    } else if (auto it = unions.find(name); it != unions.end()) {
+        for (const auto& field : it->second->fields) {
+            size = std::max(size, sizeOf(field.type.get(), depth));
+        }
+    } else {
+        size = 4; // enum
+    }
+    return size;
+}
+
+Symbol EscapeAnalyzer::rootName(ExprNode* expr) {
+    while (true) {
+        if (auto* index = nodeCast<IndexNode>(expr)) {
+            expr = index->array.get();
+        } else if (auto* fieldAccess = nodeCast<FieldAccessNode>(expr)) {
+            expr = fieldAccess->object.get();
+        } else if (auto* ident = nodeCast<IdentifierNode>(expr)) {
+            return ident->name;
+        } else {
+            return Symbol(); // through a pointer or a temporary
+        }
+    }
+}
+
+TypeNode* EscapeAnalyzer::accessType(ExprNode* expr) const {
+    if (auto* fieldAccess = nodeCast<FieldAccessNode>(expr)) {
+        std::string structName;
+        if (auto* ident = nodeCast<IdentifierNode>(fieldAccess->object.get())) {
+            auto it = structParameters.find(ident->name);
+            if (it == structParameters.end()) {
+                return nullptr;
+            }
+            structName = it->second;
+        } else if (auto* structType = nodeCast<StructTypeNode>(accessType(fieldAccess->object.get()))) {
+            structName = structType->structName;
+        }
+        
+        const std::vector<StructField>* fields = nullptr;
+        if (auto it = structs.find(structName); it != structs.end()) {
+            fields = &it->second->fields;
+        } else if (auto it = unions.find(structName); it != unions.end()) {
+            fields = &it->second->fields;
+        }
+        if (fields) {
+            for (const auto& field : *fields) {
+                if (field.name == fieldAccess->fieldName) {
+                    return field.type.get();
+                }
+            }
+        }
+        return nullptr;
+    }
+    if (auto* index = nodeCast<IndexNode>(expr)) {
+        auto* arrayType = nodeCast<ArrayTypeNode>(accessType(index->array.get()));
+        return arrayType ? arrayType->elementType.get() : nullptr;
+    }
+    return nullptr;
+}
+
+void EscapeAnalyzer::recordDecayedArgument(ExprNode* arg) {
+    // An array field passed on decays to a pointer into the parameter,
+    // directly or inside a slice. Unknown types count as arrays.
+    if (!nodeCast<FieldAccessNode>(arg) && !nodeCast<IndexNode>(arg)) {
+        return;
+    }
+    Symbol root = rootName(arg);
+    if (root.empty() || !structParameters.count(root)) {
+        return;
+    }
+    TypeNode* type = accessType(arg);
+    if (!type || nodeCast<ArrayTypeNode>(type)) {
+        modified.insert(root);
+    }
+}
+
+void EscapeAnalyzer::recordModified(ExprNode* target) {
+    Symbol root = rootName(target);
+    if (!root.empty()) {
+        modified.insert(root);
+    }
+}
+
+void EscapeAnalyzer::visitIdentifier(IdentifierNode* node) {
+    // Workers of a par for reach the variable through its address
+    if (parallelDepth > 0) {
+        addressTaken.insert(node->name);
+    }
+}
+
+void EscapeAnalyzer::visitBinaryOp(BinaryOpNode* node) {
+    if (node->op == "=") {
+        recordModified(node->left.get());
+    }
+    ExprVisitor::visit(node->left.get());
+    ExprVisitor::visit(node->right.get());
+}
+
+void EscapeAnalyzer::visitUnaryOp(UnaryOpNode* node) {
+    ExprVisitor::visit(node->operand.get());
+}
+
+void EscapeAnalyzer::visitArrayLiteral(ArrayLiteralNode* node) {
+    for (auto& element : node->elements) {
+        ExprVisitor::visit(element.get());
+    }
+}
+
+void EscapeAnalyzer::visitIndex(IndexNode* node) {
+    ExprVisitor::visit(node->array.get());
+    ExprVisitor::visit(node->index.get());
+}
+
+void EscapeAnalyzer::visitCall(CallNode* node) {
+    // Arguments are copies, or borrowed only when nothing else can reach
+    // them. Arrays are the exception, len() only reads their bound.
+    static const Symbol len("len");
+    for (auto& arg : node->arguments) {
+        if (node->functionName != len) {
+            recordDecayedArgument(arg.get());
+        }
+        ExprVisitor::visit(arg.get());
+    }
+}
+
+void EscapeAnalyzer::visitAddressOf(AddressOfNode* node) {
+    Symbol root = rootName(node->operand.get());
+    if (!root.empty()) {
+        modified.insert(root);
+        addressTaken.insert(root);
+    }
+    ExprVisitor::visit(node->operand.get());
+}
+
+void EscapeAnalyzer::visitDereference(DereferenceNode* node) {
+    ExprVisitor::visit(node->operand.get());
+}
+
+void EscapeAnalyzer::visitFieldAccess(FieldAccessNode* node) {
+    ExprVisitor::visit(node->object.get());
+}
+
+void EscapeAnalyzer::visitStructInit(StructInitNode* node) {
+    for (auto& field : node->fields) {
+        ExprVisitor::visit(field.second.get());
+    }
+}
+
+void EscapeAnalyzer::visitUnionInit(UnionInitNode* node) {
+    ExprVisitor::visit(node->value.get());
+}
+
+void EscapeAnalyzer::visitMethodCall(MethodCallNode* node) {
+    // A pointer receiver may modify the receiver and keep its address
+    if (mutatingMethods.count(node->methodName)) {
+        Symbol root = rootName(node->receiver.get());
+        if (!root.empty()) {
+            modified.insert(root);
+            addressTaken.insert(root);
+        }
+    }
+    ExprVisitor::visit(node->receiver.get());
+    for (auto& arg : node->arguments) {
+        recordDecayedArgument(arg.get());
+        ExprVisitor::visit(arg.get());
+    }
+}
+
+void EscapeAnalyzer::visitExprStmt(ExprStmtNode* node) {
+    ExprVisitor::visit(node->expr.get());
+}
+
+void EscapeAnalyzer::visitVarDecl(VarDeclNode* node) {
+    modified.insert(node->name); // shadows a parameter of the same name
+    if (node->initializer) {
+        ExprVisitor::visit(node->initializer.get());
+    }
+}
+
+void EscapeAnalyzer::visitAssignment(AssignmentNode* node) {
+    recordModified(node->target.get());
+    ExprVisitor::visit(node->target.get());
+    ExprVisitor::visit(node->value.get());
+}
+
+void EscapeAnalyzer::visitBlock(BlockNode* node) {
+    for (auto& stmt : node->statements) {
+        StmtVisitor::visit(stmt.get());
+    }
+}
+
+void EscapeAnalyzer::visitReturn(ReturnNode* node) {
+    if (node->value) {
+        ExprVisitor::visit(node->value.get());
+    }
+}
+
+void EscapeAnalyzer::visitIf(IfNode* node) {
+    ExprVisitor::visit(node->condition.get());
+    StmtVisitor::visit(node->thenBranch.get());
+    if (node->elseBranch) {
+        StmtVisitor::visit(node->elseBranch.get());
+    }
+}
+
+void EscapeAnalyzer::visitWhile(WhileNode* node) {
+    ExprVisitor::visit(node->condition.get());
+    StmtVisitor::visit(node->body.get());
+}
+
+void EscapeAnalyzer::visitFor(ForNode* node) {
+    modified.insert(node->iteratorName);
+    ExprVisitor::visit(node->collection.get());
+    
+    if (node->isParallel) {
+        parallelDepth++;
+    }
+    StmtVisitor::visit(node->body.get());
+    if (node->isParallel) {
+        parallelDepth--;
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "ast.h"
+#include "ast_visitor.h"
+
+// Escape analysis run after alias analysis. Struct parameters and value
+// receivers are copied on every call; this pass lowers the ones a function
+// only reads to `const struct X*`. A parameter qualifies when:
+//  - its struct is larger than 16 bytes, smaller ones travel in registers;
+//  - nothing is assigned to it, its fields or its elements;
+//  - none of its array fields is passed on, arrays decay to pointers;
+//  - its address is not taken and no pointer-receiver method is called on it;
+//  - no local of the same name shadows it.
+//
+// Value semantics then depend on the caller: it passes the address of its
+// argument only when nothing else can reach the argument during the call,
+// otherwise a copy. For that the pass records, per function, the locals
+// whose address is taken or that a par for body shares.
+class EscapeAnalyzer : public ExprVisitor<EscapeAnalyzer>, public StmtVisitor<EscapeAnalyzer> {
+private:
+    friend class ExprVisitor<EscapeAnalyzer>;
+    friend class StmtVisitor<EscapeAnalyzer>;
+    
+    std::unordered_map<std::string, StructDefNode*> structs;
+    std::unordered_map<std::string, UnionDefNode*> unions;
+    std::unordered_set<Symbol> mutatingMethods; // methods with pointer or reference receivers
+    size_t referenceCount;
+    
+    // Per-function state
+    std::unordered_set<Symbol> modified; // written, address taken or shadowed
+    std::unordered_set<Symbol> addressTaken;
+    std::unordered_map<Symbol, std::string> structParameters; // name -> struct, self included
+    int parallelDepth;
+    
+    void analyzeFunction(FunctionNode* function, const ImplBlockNode* impl);
+    
+    // Estimated C size in bytes, 0 when unknown
+    size_t sizeOf(TypeNode* type, int depth) const;
+    size_t structSize(const std::string& name, int depth) const;
+    
+    // Variable a field or element access starts from, empty otherwise
+    static Symbol rootName(ExprNode* expr);
+    void recordModified(ExprNode* target);
+    
+    // Declared type of a field or element access into a struct parameter,
+    // nullptr when unknown
+    TypeNode* accessType(ExprNode* expr) const;
+    void recordDecayedArgument(ExprNode* arg);
+    
+    // Expressions
+    void visitIdentifier(IdentifierNode* node);
+    void visitBinaryOp(BinaryOpNode* node);
+    void visitUnaryOp(UnaryOpNode* node);
+    void visitArrayLiteral(ArrayLiteralNode* node);
+    void visitIndex(IndexNode* node);
+    void visitCall(CallNode* node);
+    void visitAddressOf(AddressOfNode* node);
+    void visitDereference(DereferenceNode* node);
+    void visitFieldAccess(FieldAccessNode* node);
+    void visitStructInit(StructInitNode* node);
+    void visitUnionInit(UnionInitNode* node);
+    void visitMethodCall(MethodCallNode* node);
+    
+    // Statements
+    void visitExprStmt(ExprStmtNode* node);
+    void visitVarDecl(VarDeclNode* node);
+    void visitAssignment(AssignmentNode* node);
+    void visitBlock(BlockNode* node);
+    void visitReturn(ReturnNode* node);
+    void visitIf(IfNode* node);
+    void visitWhile(WhileNode* node);
+    void visitFor(ForNode* node);
+    
+public:
+    EscapeAnalyzer() : referenceCount(0), parallelDepth(0) {}
+    
+    void analyze(ProgramNode* program);
+    
+    // Number of parameters and receivers lowered to const pointers
+    size_t getReferenceCount() const { return referenceCount; }
+};
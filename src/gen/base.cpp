@@ -1,16 +1,7 @@
 #include "base.h"
 
-void CodeGenBase::indent() {
-    for (int i = 0; i < indentLevel; i++) {
-        output << "    ";
-    }
-}
-
-void CodeGenBase::emit(const std::string& code) {
-    output << code;
-}
-
-void CodeGenBase::emitLine(const std::string& line) {
+void CodeGenBase::emitLine(std::string_view line) {
     indent();
-    output << line << "\n";
+    output.append(line);
+    output.append('\n');
 }
\ No newline at end of file
@@ -1,19 +1,21 @@
 #pragma once
 #include <string>
-#include <sstream>
+#include <string_view>
+#include "output_buffer.h"
 
 // Base class for all code generators
 class CodeGenBase {
 protected:
-    std::stringstream& output;
+    OutputBuffer& output;
     int& indentLevel;
     
-    void indent();
-    void emit(const std::string& code);
-    void emitLine(const std::string& line);
+    void indent() { output.appendIndent(indentLevel); }
+    void emit(std::string_view code) { output.append(code); }
+    void emit(Symbol name) { output << name; }
+    void emitLine(std::string_view line);
     
 public:
-    CodeGenBase(std::stringstream& out, int& indent) 
+    CodeGenBase(OutputBuffer& out, int& indent) 
         : output(out), indentLevel(indent) {}
     virtual ~CodeGenBase() = default;
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "builtin.h"
+#include "../vector_types.h"
 #include <vector>
 
 void BuiltinGenerator::generateAll() {
@@ -8,7 +9,8 @@ void BuiltinGenerator::generateAll() {
         generateRangeStructs();
     }
     
-    if (usage.isPrintUsed()) {
+    // Parallel workers flush the shared output buffers, so they need them
+    if (usage.isPrintUsed() || (bufferedOutput && usage.isParallelUsed())) {
         generatePrintFunctions();
     }
     
@@ -16,6 +18,30 @@ void BuiltinGenerator::generateAll() {
         generateUtilityMacros();
     }
     
+    if (usage.isInliningUsed()) {
+        generateInlineMacros();
+    }
+    
+    if (usage.isParallelUsed()) {
+        generateParallelRuntime();
+    }
+    
+    if (usage.isVectorUsed()) {
+        generateVectorTypes();
+    }
+    
+    if (usage.isArenaUsed()) {
+        generateArenaRuntime();
+    }
+    
+    if (usage.isVecUsed()) {
+        generateVecRuntime();
+    }
+    
+    if (usage.isMapUsed()) {
+        generateMapRuntime();
+    }
+    
 }
 
 void BuiltinGenerator::generateIncludes() {
@@ -56,67 +82,211 @@ void BuiltinGenerator::generateRangeStructs() {
 }
 
 void BuiltinGenerator::generatePrintFunctions() {
-    emitLine("// Print functions for different types");
-    
-    // Generate specific print functions for each type
     const auto& types = usage.getUsedTypes();
     
-    // Always generate print_int as it's used as default
-    emitLine("static void print_int(int x) { printf(\"%d\\n\", x); }");
-    if (types.find("long") != types.end()) {
-        emitLine("static void print_long(long x) { printf(\"%ld\\n\", x); }");
-    }
-    if (types.find("float") != types.end()) {
-        emitLine("static void print_float(float x) { printf(\"%.6f\\n\", x); }");
-    }
-    // Always generate print_double for struct fields
-    emitLine("static void print_double(double x) { printf(\"%.6f\\n\", x); }");
-    if (types.find("string") != types.end() || types.empty()) {
-        emitLine("static void print_string(const char* x) { printf(\"%s\\n\", x); }");
-    }
-    if (types.find("bool") != types.end()) {
-        emitLine("static void print_bool(_Bool x) { printf(\"%s\\n\", x ? \"true\" : \"false\"); }");
+    if (bufferedOutput) {
+        generateBufferedOutput();
+    } else {
+        emitLine("// print runtime. Each value is formatted into a per-thread line buffer");
+        emitLine("// without parsing a format string and ends with a newline; each print");
+        emitLine("// statement reaches stdio in one fwrite.");
+        emitLine("#define PEACH_PRINT_MAX 4096");
+        emitLine("");
+        emitLine("static _Thread_local char peach_print_buf[PEACH_PRINT_MAX];");
+        emitLine("static _Thread_local size_t peach_print_len;");
+        emitLine("");
+        emitLine("static void peach_print_write(const char* data, size_t n) {");
+        emitLine("    fwrite(data, 1, n, stdout);");
+        emitLine("}");
+        emitLine("");
+        emitLine("static void peach_print_flush(void) {");
+        emitLine("    peach_print_write(peach_print_buf, peach_print_len);");
+        emitLine("    peach_print_len = 0;");
+        emitLine("}");
+        emitLine("");
+        emitLine("static void peach_print_end(void) {");
+        emitLine("    peach_print_flush();");
+        emitLine("}");
+        emitLine("");
+        if (usage.isFlushUsed()) {
+            emitLine("static void peach_flush(void) {");
+            emitLine("    fflush(stdout);");
+            emitLine("}");
+            emitLine("");
+        }
+        emitLine("static char* peach_print_reserve(size_t n) {");
+        emitLine("    if (peach_print_len + n > PEACH_PRINT_MAX) {");
+        emitLine("        peach_print_flush();");
+        emitLine("    }");
+        emitLine("    return peach_print_buf + peach_print_len;");
+        emitLine("}");
+        emitLine("");
     }
+    emitLine("static void peach_print_newline(void) {");
+    emitLine("    *peach_print_reserve(1) = '\\n';");
+    emitLine("    peach_print_len++;");
+    emitLine("}");
     emitLine("");
-    
-    // Generic print macro using C11 _Generic
-    emitLine("// Generic print macro using _Generic (C11)");
-    emitLine("#define print(x) _Generic((x), \\");
-    
-    const auto& allTypes = usage.getUsedTypes();
-    std::vector<std::string> entries;
-    
-    // Always include int in the macro
-    entries.push_back("    int: print_int");
-    if (allTypes.find("long") != allTypes.end()) {
-        entries.push_back("    long: print_long");
-    }
-    if (allTypes.find("float") != allTypes.end()) {
-        entries.push_back("    float: print_float");
-    }
-    // Always include double in the macro
-    entries.push_back("    double: print_double");
-    if (allTypes.find("string") != allTypes.end() || allTypes.empty()) {
-        entries.push_back("    char*: print_string");
-        entries.push_back("    const char*: print_string");
-    }
-    if (allTypes.find("bool") != allTypes.end()) {
-        entries.push_back("    _Bool: print_bool");
+    emitLine("// Digits of x, most significant first, without a sign");
+    emitLine("static char* peach_format_digits(char* p, unsigned long x, int min_digits) {");
+    emitLine("    char digits[20];");
+    emitLine("    int n = 0;");
+    emitLine("    do {");
+    emitLine("        digits[n++] = (char)('0' + x % 10);");
+    emitLine("        x /= 10;");
+    emitLine("    } while (x || n < min_digits);");
+    emitLine("    while (n) {");
+    emitLine("        *p++ = digits[--n];");
+    emitLine("    }");
+    emitLine("    return p;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static void peach_print_long(long x) {");
+    emitLine("    char* start = peach_print_reserve(22);");
+    emitLine("    char* p = start;");
+    emitLine("    if (x < 0) {");
+    emitLine("        *p++ = '-';");
+    emitLine("    }");
+    emitLine("    p = peach_format_digits(p, x < 0 ? -(unsigned long)x : (unsigned long)x, 1);");
+    emitLine("    *p++ = '\\n';");
+    emitLine("    peach_print_len += (size_t)(p - start);");
+    emitLine("}");
+    emitLine("");
+    emitLine("// Same text as printf(\"%.6f\\n\"). The fraction below the integer part is");
+    emitLine("// exact and its millionths are off by less than 1e-10, so they round like");
+    emitLine("// the exact value unless within 1e-4 of a tie; those, zeros, values from");
+    emitLine("// 1e18, inf and nan take the snprintf path.");
+    emitLine("static void peach_print_double(double x) {");
+    emitLine("    double magnitude = x < 0 ? -x : x;");
+    emitLine("    if (magnitude < 1e18 && x != 0) {");
+    emitLine("        unsigned long whole = (unsigned long)magnitude;");
+    emitLine("        double scaled = (magnitude - (double)whole) * 1e6;");
+    emitLine("        unsigned long millionths = (unsigned long)scaled;");
+    emitLine("        double rest = scaled - (double)millionths;");
+    emitLine("        if (rest < 0.4999 || rest > 0.5001) {");
+    emitLine("            millionths += rest > 0.5;");
+    emitLine("            if (millionths == 1000000) {");
+    emitLine("                whole++;");
+    emitLine("                millionths = 0;");
+    emitLine("            }");
+    emitLine("            char* start = peach_print_reserve(28);");
+    emitLine("            char* p = start;");
+    emitLine("            if (x < 0) {");
+    emitLine("                *p++ = '-';");
+    emitLine("            }");
+    emitLine("            p = peach_format_digits(p, whole, 1);");
+    emitLine("            *p++ = '.';");
+    emitLine("            p = peach_format_digits(p, millionths, 6);");
+    emitLine("            *p++ = '\\n';");
+    emitLine("            peach_print_len += (size_t)(p - start);");
+    emitLine("            return;");
+    emitLine("        }");
+    emitLine("    }");
+    emitLine("    char* p = peach_print_reserve(330); // -DBL_MAX takes 318 with the newline");
+    emitLine("    peach_print_len += (size_t)snprintf(p, 330, \"%.6f\\n\", x);");
+    emitLine("}");
+    emitLine("");
+    emitLine("static void peach_print_string(const char* x) {");
+    emitLine("    size_t n = strlen(x);");
+    emitLine("    if (n >= PEACH_PRINT_MAX) {");
+    emitLine("        peach_print_flush();");
+    emitLine("        peach_print_write(x, n);");
+    emitLine("    } else {");
+    emitLine("        memcpy(peach_print_reserve(n), x, n);");
+    emitLine("        peach_print_len += n;");
+    emitLine("    }");
+    emitLine("    peach_print_newline();");
+    emitLine("}");
+    emitLine("");
+    if (types.find("bool") != types.end()) {
+        emitLine("static void peach_print_bool(_Bool x) {");
+        emitLine("    const char* text = x ? \"true\\n\" : \"false\\n\";");
+        emitLine("    size_t n = x ? 5 : 6;");
+        emitLine("    memcpy(peach_print_reserve(n), text, n);");
+        emitLine("    peach_print_len += n;");
+        emitLine("}");
+        emitLine("");
     }
     
-    // Generate macro entries
-    for (size_t i = 0; i < entries.size(); i++) {
-        if (i < entries.size() - 1) {
-            emitLine(entries[i] + ", \\");
-        } else {
-            emitLine(entries[i] + ", \\");
-        }
+    // Arguments whose type inference could not pin down pick their
+    // formatter at C compile time
+    emitLine("#define peach_print(x) _Generic((x), \\");
+    emitLine("    double: peach_print_double, \\");
+    emitLine("    float: peach_print_double, \\");
+    emitLine("    char*: peach_print_string, \\");
+    emitLine("    const char*: peach_print_string, \\");
+    if (types.find("bool") != types.end()) {
+        emitLine("    _Bool: peach_print_bool, \\");
     }
-    emitLine("    default: print_int \\");
+    emitLine("    default: peach_print_long \\");
     emitLine(")(x)");
     emitLine("");
 }
 
+void BuiltinGenerator::generateBufferedOutput() {
+    emitLine("#include <unistd.h>");
+    emitLine("#include <errno.h>");
+    emitLine("");
+    emitLine("// Buffered output runtime. print formats into a per-thread buffer of");
+    emitLine("// PEACH_OUTPUT_SIZE bytes, allocated on first use, that goes to fd 1 with");
+    emitLine("// write(2) when it fills up, on flush(), when a par for starts (the calling");
+    emitLine("// thread) or ends (each worker) and at exit. The state is weak so that all");
+    emitLine("// units of a program share it and their output stays in order.");
+    emitLine("#ifndef PEACH_OUTPUT_SIZE");
+    emitLine("#define PEACH_OUTPUT_SIZE (1 << 20)");
+    emitLine("#endif");
+    emitLine("#define PEACH_PRINT_MAX PEACH_OUTPUT_SIZE");
+    emitLine("#define PEACH_OUTPUT_BUFFERED 1");
+    emitLine("");
+    emitLine("__attribute__((weak)) _Thread_local char* peach_print_buf;");
+    emitLine("__attribute__((weak)) _Thread_local size_t peach_print_len;");
+    emitLine("");
+    emitLine("// Output that cannot be written, e.g. to a closed pipe, is dropped");
+    emitLine("__attribute__((weak)) void peach_print_write(const char* data, size_t n) {");
+    emitLine("    while (n > 0) {");
+    emitLine("        ssize_t written = write(1, data, n);");
+    emitLine("        if (written < 0 && errno == EINTR) {");
+    emitLine("            continue;");
+    emitLine("        }");
+    emitLine("        if (written <= 0) {");
+    emitLine("            return;");
+    emitLine("        }");
+    emitLine("        data += written;");
+    emitLine("        n -= (size_t)written;");
+    emitLine("    }");
+    emitLine("}");
+    emitLine("");
+    emitLine("__attribute__((weak)) void peach_print_flush(void) {");
+    emitLine("    peach_print_write(peach_print_buf, peach_print_len);");
+    emitLine("    peach_print_len = 0;");
+    emitLine("}");
+    emitLine("");
+    emitLine("// Runs when main returns or exit() is called, in the exiting thread");
+    emitLine("__attribute__((weak, destructor)) void peach_print_exit(void) {");
+    emitLine("    peach_print_flush();");
+    emitLine("}");
+    emitLine("");
+    emitLine("static void peach_print_end(void) {}");
+    emitLine("");
+    if (usage.isFlushUsed()) {
+        emitLine("static void peach_flush(void) {");
+        emitLine("    peach_print_flush();");
+        emitLine("}");
+        emitLine("");
+    }
+    emitLine("static char* peach_print_reserve(size_t n) {");
+    emitLine("    if (peach_print_len + n > PEACH_PRINT_MAX) {");
+    emitLine("        peach_print_flush();");
+    emitLine("    }");
+    emitLine("    if (!peach_print_buf && !(peach_print_buf = malloc(PEACH_PRINT_MAX))) {");
+    emitLine("        fputs(\"peach: cannot allocate the output buffer\\n\", stderr);");
+    emitLine("        abort();");
+    emitLine("    }");
+    emitLine("    return peach_print_buf + peach_print_len;");
+    emitLine("}");
+    emitLine("");
+}
+
 void BuiltinGenerator::generateUtilityMacros() {
     if (usage.isLenUsed()) {
         emitLine("// Array length macro");
@@ -125,3 +295,790 @@ void BuiltinGenerator::generateUtilityMacros() {
     }
 }
 
+void BuiltinGenerator::generateInlineMacros() {
+    // With -std=c11, extern inline is an external definition: callers in
+    // other units still link, callers in this one inline it even at -O0.
+    // A whole program has no other units.
+    emitLine("// Function inlining");
+    if (wholeProgram) {
+        emitLine("#define PEACH_INLINE static inline __attribute__((always_inline))");
+    } else {
+        emitLine("#define PEACH_INLINE extern inline __attribute__((always_inline))");
+    }
+    emitLine("#define PEACH_NOINLINE __attribute__((noinline))");
+    emitLine("");
+}
+
+void BuiltinGenerator::generateParallelRuntime() {
+    emitLine("#include <pthread.h>");
+    emitLine("#include <unistd.h>");
+    emitLine("#include <limits.h>");
+    emitLine("#include <math.h>");
+    emitLine("");
+    
+    emitLine("// Parallel loop runtime. A pool of pthreads is started on first use; the");
+    emitLine("// calling thread takes part as worker 0. Each worker owns a range of");
+    emitLine("// iterations and takes chunks from its front. When its range runs dry it");
+    emitLine("// steals the back half of another worker's range. Loops started from");
+    emitLine("// inside a parallel body run inline. The definitions are weak so that all");
+    emitLine("// units of a program share one pool.");
+    emitLine("typedef struct {");
+    emitLine("    void (*body)(void* env, long begin, long end, void* acc);");
+    emitLine("    void (*init)(void* acc);");
+    emitLine("    void (*combine)(void* acc, const void* other);");
+    emitLine("    size_t accSize;");
+    emitLine("} peach_par_loop;");
+    emitLine("");
+    emitLine("typedef struct {");
+    emitLine("    pthread_mutex_t lock;");
+    emitLine("    long next;");
+    emitLine("    long end;");
+    emitLine("    char pad[64];");
+    emitLine("} peach_par_range;");
+    emitLine("");
+    emitLine("typedef struct {");
+    emitLine("    pthread_mutex_t lock;");
+    emitLine("    pthread_cond_t start;");
+    emitLine("    pthread_cond_t done;");
+    emitLine("    int threads;");
+    emitLine("    int running;");
+    emitLine("    unsigned long generation;");
+    emitLine("    const peach_par_loop* loop;");
+    emitLine("    void* env;");
+    emitLine("    char* accs;");
+    emitLine("    size_t accStride;");
+    emitLine("    long grain;");
+    emitLine("    peach_par_range* ranges;");
+    emitLine("} peach_par_pool;");
+    emitLine("");
+    emitLine("__attribute__((weak)) peach_par_pool peach_par_state;");
+    emitLine("__attribute__((weak)) pthread_once_t peach_par_once = PTHREAD_ONCE_INIT;");
+    emitLine("__attribute__((weak)) _Thread_local int peach_par_active;");
+    emitLine("");
+    emitLine("__attribute__((weak)) void peach_par_run(peach_par_pool* pool, int self) {");
+    emitLine("    const peach_par_loop* loop = pool->loop;");
+    emitLine("    void* acc = loop->accSize ? pool->accs + self * pool->accStride : NULL;");
+    emitLine("    peach_par_range* own = &pool->ranges[self];");
+    emitLine("    for (;;) {");
+    emitLine("        pthread_mutex_lock(&own->lock);");
+    emitLine("        long begin = own->next;");
+    emitLine("        long end = own->end - begin > pool->grain ? begin + pool->grain : own->end;");
+    emitLine("        own->next = end;");
+    emitLine("        pthread_mutex_unlock(&own->lock);");
+    emitLine("        if (begin < end) {");
+    emitLine("            loop->body(pool->env, begin, end, acc);");
+    emitLine("            continue;");
+    emitLine("        }");
+    emitLine("        int stolen = 0;");
+    emitLine("        for (int k = 1; k < pool->threads && !stolen; k++) {");
+    emitLine("            peach_par_range* victim = &pool->ranges[(self + k) % pool->threads];");
+    emitLine("            pthread_mutex_lock(&victim->lock);");
+    emitLine("            long left = victim->end - victim->next;");
+    emitLine("            if (left > 0) {");
+    emitLine("                begin = victim->next + left / 2;");
+    emitLine("                end = victim->end;");
+    emitLine("                victim->end = begin;");
+    emitLine("                stolen = 1;");
+    emitLine("            }");
+    emitLine("            pthread_mutex_unlock(&victim->lock);");
+    emitLine("        }");
+    emitLine("        if (!stolen) {");
+    emitLine("            return;");
+    emitLine("        }");
+    emitLine("        pthread_mutex_lock(&own->lock);");
+    emitLine("        own->next = begin;");
+    emitLine("        own->end = end;");
+    emitLine("        pthread_mutex_unlock(&own->lock);");
+    emitLine("    }");
+    emitLine("}");
+    emitLine("");
+    emitLine("__attribute__((weak)) void* peach_par_thread(void* arg) {");
+    emitLine("    peach_par_pool* pool = &peach_par_state;");
+    emitLine("    int self = (int)(long)arg;");
+    emitLine("    unsigned long seen = 0;");
+    emitLine("    peach_par_active = 1;");
+    emitLine("    for (;;) {");
+    emitLine("        pthread_mutex_lock(&pool->lock);");
+    emitLine("        while (pool->generation == seen) {");
+    emitLine("            pthread_cond_wait(&pool->start, &pool->lock);");
+    emitLine("        }");
+    emitLine("        seen = pool->generation;");
+    emitLine("        pthread_mutex_unlock(&pool->lock);");
+    emitLine("        peach_par_run(pool, self);");
+    emitLine("#ifdef PEACH_OUTPUT_BUFFERED");
+    emitLine("        peach_print_flush(); // before the caller goes on");
+    emitLine("#endif");
+    emitLine("        pthread_mutex_lock(&pool->lock);");
+    emitLine("        if (--pool->running == 0) {");
+    emitLine("            pthread_cond_signal(&pool->done);");
+    emitLine("        }");
+    emitLine("        pthread_mutex_unlock(&pool->lock);");
+    emitLine("    }");
+    emitLine("    return NULL;");
+    emitLine("}");
+    emitLine("");
+    emitLine("__attribute__((weak)) void peach_par_start(void) {");
+    emitLine("    peach_par_pool* pool = &peach_par_state;");
+    emitLine("    long count = sysconf(_SC_NPROCESSORS_ONLN);");
+    emitLine("    const char* requested = getenv(\"PEACH_THREADS\");");
+    emitLine("    if (requested && atoi(requested) > 0) {");
+    emitLine("        count = atoi(requested);");
+    emitLine("    }");
+    emitLine("    if (count < 1) {");
+    emitLine("        count = 1;");
+    emitLine("    }");
+    emitLine("    pthread_mutex_init(&pool->lock, NULL);");
+    emitLine("    pthread_cond_init(&pool->start, NULL);");
+    emitLine("    pthread_cond_init(&pool->done, NULL);");
+    emitLine("    pool->ranges = calloc(count, sizeof(peach_par_range));");
+    emitLine("    if (!pool->ranges) {");
+    emitLine("        pool->threads = 1;");
+    emitLine("        return;");
+    emitLine("    }");
+    emitLine("    for (long w = 0; w < count; w++) {");
+    emitLine("        pthread_mutex_init(&pool->ranges[w].lock, NULL);");
+    emitLine("    }");
+    emitLine("    pool->threads = 1;");
+    emitLine("    for (long w = 1; w < count; w++) {");
+    emitLine("        pthread_t thread;");
+    emitLine("        if (pthread_create(&thread, NULL, peach_par_thread, (void*)w) != 0) {");
+    emitLine("            break;");
+    emitLine("        }");
+    emitLine("        pthread_detach(thread);");
+    emitLine("        pool->threads++;");
+    emitLine("    }");
+    emitLine("}");
+    emitLine("");
+    emitLine("__attribute__((weak)) void peach_par_for(const peach_par_loop* loop, void* env, long begin, long end, void* result) {");
+    emitLine("    peach_par_pool* pool = &peach_par_state;");
+    emitLine("    if (!peach_par_active) {");
+    emitLine("        pthread_once(&peach_par_once, peach_par_start);");
+    emitLine("    }");
+    emitLine("    if (loop->accSize) {");
+    emitLine("        loop->init(result);");
+    emitLine("    }");
+    emitLine("    if (end <= begin) {");
+    emitLine("        return;");
+    emitLine("    }");
+    emitLine("    size_t stride = (loop->accSize + 63) & ~(size_t)63;");
+    emitLine("    char* accs = NULL;");
+    emitLine("    if (loop->accSize && !peach_par_active && pool->threads > 1) {");
+    emitLine("        accs = aligned_alloc(64, stride * pool->threads);");
+    emitLine("    }");
+    emitLine("    if (peach_par_active || pool->threads == 1 || (loop->accSize && !accs)) {");
+    emitLine("        loop->body(env, begin, end, result);");
+    emitLine("        return;");
+    emitLine("    }");
+    emitLine("    long count = end - begin;");
+    emitLine("    for (int w = 0; w < pool->threads; w++) {");
+    emitLine("        long share = count / pool->threads, extra = count % pool->threads;");
+    emitLine("        pool->ranges[w].next = begin + share * w + (w < extra ? w : extra);");
+    emitLine("        pool->ranges[w].end = pool->ranges[w].next + share + (w < extra ? 1 : 0);");
+    emitLine("        if (accs) {");
+    emitLine("            loop->init(accs + w * stride);");
+    emitLine("        }");
+    emitLine("    }");
+    emitLine("#ifdef PEACH_OUTPUT_BUFFERED");
+    emitLine("    peach_print_flush(); // output before the loop comes first");
+    emitLine("#endif");
+    emitLine("    pthread_mutex_lock(&pool->lock);");
+    emitLine("    pool->loop = loop;");
+    emitLine("    pool->env = env;");
+    emitLine("    pool->accs = accs;");
+    emitLine("    pool->accStride = stride;");
+    emitLine("    pool->grain = count / (pool->threads * 16) > 1 ? count / (pool->threads * 16) : 1;");
+    emitLine("    pool->running = pool->threads - 1;");
+    emitLine("    pool->generation++;");
+    emitLine("    pthread_cond_broadcast(&pool->start);");
+    emitLine("    pthread_mutex_unlock(&pool->lock);");
+    emitLine("    peach_par_active = 1;");
+    emitLine("    peach_par_run(pool, 0);");
+    emitLine("    peach_par_active = 0;");
+    emitLine("    pthread_mutex_lock(&pool->lock);");
+    emitLine("    while (pool->running > 0) {");
+    emitLine("        pthread_cond_wait(&pool->done, &pool->lock);");
+    emitLine("    }");
+    emitLine("    pthread_mutex_unlock(&pool->lock);");
+    emitLine("    for (int w = 0; accs && w < pool->threads; w++) {");
+    emitLine("        loop->combine(result, accs + w * stride);");
+    emitLine("    }");
+    emitLine("    free(accs);");
+    emitLine("}");
+    emitLine("");
+}
+
+void BuiltinGenerator::generateVectorTypes() {
+    emitLine("// SIMD vector types. GCC-compatible compilers get vector extensions, so");
+    emitLine("// the operators below compile to vector instructions; elsewhere, or with");
+    emitLine("// PEACH_SCALAR_VECTORS defined, a vector is a struct handled lane by lane.");
+    emitLine("#if defined(__GNUC__) && !defined(PEACH_SCALAR_VECTORS)");
+    emitLine("#define PEACH_VECTOR_EXT 1");
+    emitLine("#define peach_lane(v, i) ((v)[i])");
+    emitLine("#pragma GCC diagnostic ignored \"-Wpsabi\"");
+    emitLine("#else");
+    emitLine("#define PEACH_VECTOR_EXT 0");
+    emitLine("#define peach_lane(v, i) ((v).lane[i])");
+    emitLine("#endif");
+    emitLine("");
+    
+    static const std::pair<const char*, const char*> operators[] = {
+        {"add", "+"}, {"sub", "-"}, {"mul", "*"}, {"div", "/"}
+    };
+    
+    for (const auto& name : usage.getUsedVectors()) {
+        const VectorType* vector = findVectorType(name);
+        std::string type = vector->cType();
+        std::string element(vector->elementType);
+        std::string lanes = std::to_string(vector->lanes);
+        
+        emitLine("#if PEACH_VECTOR_EXT");
+        emitLine("typedef " + element + " " + type + " __attribute__((vector_size(" + lanes + " * sizeof(" + element + "))));");
+        emitLine("#else");
+        emitLine("typedef struct { " + element + " lane[" + lanes + "]; } " + type + ";");
+        emitLine("#endif");
+        emitLine("");
+        
+        emitLine("static inline " + type + " " + type + "_splat(" + element + " x) {");
+        emitLine("    " + type + " v;");
+        emitLine("    for (int i = 0; i < " + lanes + "; i++) peach_lane(v, i) = x;");
+        emitLine("    return v;");
+        emitLine("}");
+        emitLine("static inline " + type + " " + type + "_load(const " + element + "* p) {");
+        emitLine("    " + type + " v;");
+        emitLine("    memcpy(&v, p, sizeof(v));");
+        emitLine("    return v;");
+        emitLine("}");
+        emitLine("static inline void " + type + "_store(" + element + "* p, " + type + " v) {");
+        emitLine("    memcpy(p, &v, sizeof(v));");
+        emitLine("}");
+        
+        for (const auto& op : operators) {
+            emitLine("static inline " + type + " " + type + "_" + op.first + "(" + type + " a, " + type + " b) {");
+            emitLine("#if PEACH_VECTOR_EXT");
+            emitLine(std::string("    return a ") + op.second + " b;");
+            emitLine("#else");
+            emitLine("    for (int i = 0; i < " + lanes + "; i++) peach_lane(a, i) " + op.second + "= peach_lane(b, i);");
+            emitLine("    return a;");
+            emitLine("#endif");
+            emitLine("}");
+        }
+        
+        // Horizontal reductions
+        emitLine("static inline " + element + " " + type + "_hsum(" + type + " v) {");
+        emitLine("    " + element + " r = peach_lane(v, 0);");
+        emitLine("    for (int i = 1; i < " + lanes + "; i++) r += peach_lane(v, i);");
+        emitLine("    return r;");
+        emitLine("}");
+        emitLine("static inline " + element + " " + type + "_hmin(" + type + " v) {");
+        emitLine("    " + element + " r = peach_lane(v, 0);");
+        emitLine("    for (int i = 1; i < " + lanes + "; i++) r = peach_lane(v, i) < r ? peach_lane(v, i) : r;");
+        emitLine("    return r;");
+        emitLine("}");
+        emitLine("static inline " + element + " " + type + "_hmax(" + type + " v) {");
+        emitLine("    " + element + " r = peach_lane(v, 0);");
+        emitLine("    for (int i = 1; i < " + lanes + "; i++) r = peach_lane(v, i) > r ? peach_lane(v, i) : r;");
+        emitLine("    return r;");
+        emitLine("}");
+        emitLine("");
+    }
+}
+
+void BuiltinGenerator::generateArenaRuntime() {
+    emitLine("#include <stdint.h>");
+    emitLine("");
+    emitLine("// Arena allocator. Allocations bump a pointer through a chain of malloc'd");
+    emitLine("// chunks and are aligned by address, so any power-of-two alignment works.");
+    emitLine("// reset() rewinds to the first chunk and reuses the chain, so a steady");
+    emitLine("// workload stops calling malloc; release() frees the chain.");
+    emitLine("#define PEACH_ARENA_CHUNK 65536");
+    emitLine("");
+    emitLine("typedef struct peach_arena_chunk {");
+    emitLine("    struct peach_arena_chunk* next;");
+    emitLine("    size_t size;");
+    emitLine("    size_t used;");
+    emitLine("    unsigned char data[];");
+    emitLine("} peach_arena_chunk;");
+    emitLine("");
+    emitLine("typedef struct {");
+    emitLine("    peach_arena_chunk* first;");
+    emitLine("    peach_arena_chunk* current; // chunks after it are free");
+    emitLine("    size_t chunk_size;          // 0 = PEACH_ARENA_CHUNK");
+    emitLine("} peach_arena;");
+    emitLine("");
+    emitLine("static void* peach_arena_bump(peach_arena_chunk* chunk, size_t size, size_t align) {");
+    emitLine("    uintptr_t base = (uintptr_t)chunk->data;");
+    emitLine("    size_t offset = ((base + chunk->used + align - 1) & ~(uintptr_t)(align - 1)) - base;");
+    emitLine("    if (offset > chunk->size || size > chunk->size - offset) {");
+    emitLine("        return NULL;");
+    emitLine("    }");
+    emitLine("    chunk->used = offset + size;");
+    emitLine("    return chunk->data + offset;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static void* peach_arena_alloc(peach_arena* arena, size_t size, size_t align) {");
+    emitLine("    void* p;");
+    emitLine("    if (arena->current) {");
+    emitLine("        if ((p = peach_arena_bump(arena->current, size, align))) {");
+    emitLine("            return p;");
+    emitLine("        }");
+    emitLine("        while (arena->current->next) {");
+    emitLine("            arena->current = arena->current->next;");
+    emitLine("            arena->current->used = 0;");
+    emitLine("            if ((p = peach_arena_bump(arena->current, size, align))) {");
+    emitLine("                return p;");
+    emitLine("            }");
+    emitLine("        }");
+    emitLine("    }");
+    emitLine("    size_t capacity = arena->chunk_size ? arena->chunk_size : PEACH_ARENA_CHUNK;");
+    emitLine("    if (capacity < size + align) {");
+    emitLine("        capacity = size + align; // oversized requests get a chunk of their own");
+    emitLine("    }");
+    emitLine("    peach_arena_chunk* chunk = malloc(sizeof(peach_arena_chunk) + capacity);");
+    emitLine("    if (!chunk) {");
+    emitLine("        fputs(\"peach: arena out of memory\\n\", stderr);");
+    emitLine("        abort();");
+    emitLine("    }");
+    emitLine("    chunk->next = NULL;");
+    emitLine("    chunk->size = capacity;");
+    emitLine("    chunk->used = 0;");
+    emitLine("    if (arena->current) {");
+    emitLine("        arena->current->next = chunk;");
+    emitLine("    } else {");
+    emitLine("        arena->first = chunk;");
+    emitLine("    }");
+    emitLine("    arena->current = chunk;");
+    emitLine("    return peach_arena_bump(chunk, size, align);");
+    emitLine("}");
+    emitLine("");
+    emitLine("static void peach_arena_reset(peach_arena* arena) {");
+    emitLine("    arena->current = arena->first;");
+    emitLine("    if (arena->first) {");
+    emitLine("        arena->first->used = 0;");
+    emitLine("    }");
+    emitLine("}");
+    emitLine("");
+    emitLine("static void peach_arena_release(peach_arena* arena) {");
+    emitLine("    peach_arena_chunk* chunk = arena->first;");
+    emitLine("    while (chunk) {");
+    emitLine("        peach_arena_chunk* next = chunk->next;");
+    emitLine("        free(chunk);");
+    emitLine("        chunk = next;");
+    emitLine("    }");
+    emitLine("    arena->first = arena->current = NULL;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static long peach_arena_used(const peach_arena* arena) {");
+    emitLine("    long total = 0;");
+    emitLine("    for (peach_arena_chunk* chunk = arena->first; chunk; chunk = chunk->next) {");
+    emitLine("        total += (long)chunk->used;");
+    emitLine("        if (chunk == arena->current) {");
+    emitLine("            break;");
+    emitLine("        }");
+    emitLine("    }");
+    emitLine("    return total;");
+    emitLine("}");
+    emitLine("");
+}
+
+void BuiltinGenerator::generateVecRuntime() {
+    emitLine("#include <stddef.h>");
+    emitLine("#include <stdint.h>");
+    emitLine("");
+    emitLine("// Vec runtime. Each Vec[T] is a struct of data, len and cap with functions");
+    emitLine("// specialized for T. Growth at least doubles the capacity, so n pushes copy");
+    emitLine("// O(n) elements in total, and goes through this one out-of-line helper so");
+    emitLine("// the inlined push stays a compare and a store.");
+    emitLine("#define PEACH_VEC_MIN 8");
+    emitLine("");
+    emitLine("static void* peach_vec_grow(void* data, long len, long* cap, long need, size_t size, size_t align) {");
+    emitLine("    long capacity = *cap < PEACH_VEC_MIN / 2 ? PEACH_VEC_MIN : *cap * 2;");
+    emitLine("    if (capacity < need) {");
+    emitLine("        capacity = need;");
+    emitLine("    }");
+    emitLine("    void* grown = NULL;");
+    emitLine("    if ((size_t)capacity <= SIZE_MAX / size) {");
+    emitLine("        if (align <= _Alignof(max_align_t)) {");
+    emitLine("            grown = realloc(data, (size_t)capacity * size);");
+    emitLine("        } else {");
+    emitLine("            // Over-aligned elements such as SIMD vectors, realloc would not keep them aligned");
+    emitLine("            grown = aligned_alloc(align, ((size_t)capacity * size + align - 1) / align * align);");
+    emitLine("            if (grown && data) {");
+    emitLine("                memcpy(grown, data, (size_t)len * size);");
+    emitLine("                free(data);");
+    emitLine("            }");
+    emitLine("        }");
+    emitLine("    }");
+    emitLine("    if (!grown) {");
+    emitLine("        fputs(\"peach: Vec out of memory\\n\", stderr);");
+    emitLine("        abort();");
+    emitLine("    }");
+    emitLine("    *cap = capacity;");
+    emitLine("    return grown;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static void peach_vec_empty(void) {");
+    emitLine("    fputs(\"peach: pop from an empty Vec\\n\", stderr);");
+    emitLine("    abort();");
+    emitLine("}");
+    emitLine("");
+}
+
+void BuiltinGenerator::generateVecType(const std::string& vecType, const std::string& elementType) {
+    emitLine("struct " + vecType + " {");
+    emitLine("    " + elementType + "* data;");
+    emitLine("    long len;");
+    emitLine("    long cap;");
+    emitLine("};");
+    emitLine("");
+}
+
+void BuiltinGenerator::generateVecFunctions(const std::string& vecType, const std::string& elementType) {
+    const std::string& v = vecType;
+    const std::string& t = elementType;
+    std::string grow = "peach_vec_grow(v->data, v->len, &v->cap, ";
+    std::string layout = ", sizeof(" + t + "), _Alignof(" + t + "))";
+    
+    emitLine("static inline void " + v + "_reserve(" + v + "* v, long n) {");
+    emitLine("    if (n > v->cap) {");
+    emitLine("        v->data = " + grow + "n" + layout + ";");
+    emitLine("    }");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline " + v + " " + v + "_new(long n) {");
+    emitLine("    " + v + " v = {0};");
+    emitLine("    " + v + "_reserve(&v, n);");
+    emitLine("    return v;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline void " + v + "_push(" + v + "* v, " + t + " x) {");
+    emitLine("    if (v->len == v->cap) {");
+    emitLine("        v->data = " + grow + "v->len + 1" + layout + ";");
+    emitLine("    }");
+    emitLine("    v->data[v->len++] = x;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline " + t + " " + v + "_pop(" + v + "* v) {");
+    emitLine("    if (v->len == 0) {");
+    emitLine("        peach_vec_empty();");
+    emitLine("    }");
+    emitLine("    return v->data[--v->len];");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline void " + v + "_clear(" + v + "* v) {");
+    emitLine("    v->len = 0;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline void " + v + "_release(" + v + "* v) {");
+    emitLine("    free(v->data);");
+    emitLine("    v->data = NULL;");
+    emitLine("    v->len = v->cap = 0;");
+    emitLine("}");
+    emitLine("");
+}
+
+void BuiltinGenerator::generateMapRuntime() {
+    emitLine("#include <limits.h>");
+    emitLine("#include <stddef.h>");
+    emitLine("#include <stdint.h>");
+    emitLine("");
+    emitLine("// Map runtime. Each Map[K, V] is an open-addressing hash table laid out");
+    emitLine("// like a Swiss table: one control byte per slot holds 7 bits of the key's");
+    emitLine("// hash, or marks the slot empty or deleted, and a probe compares a whole");
+    emitLine("// group of control bytes at once, with SSE2 where available and as one");
+    emitLine("// 64-bit word otherwise. Keys are only compared on a control byte match.");
+    emitLine("// Groups are probed quadratically; at most 7/8 of the slots are used.");
+    emitLine("#define PEACH_MAP_EMPTY ((signed char)-128)");
+    emitLine("#define PEACH_MAP_DELETED ((signed char)-2)");
+    emitLine("");
+    emitLine("#if defined(__SSE2__)");
+    emitLine("#include <emmintrin.h>");
+    emitLine("#define PEACH_MAP_GROUP 16");
+    emitLine("typedef uint32_t peach_map_mask; // bit i set for a matching slot i");
+    emitLine("");
+    emitLine("static inline peach_map_mask peach_map_match(const signed char* ctrl, signed char h2) {");
+    emitLine("    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);");
+    emitLine("    return (peach_map_mask)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(h2)));");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline peach_map_mask peach_map_match_empty(const signed char* ctrl) {");
+    emitLine("    return peach_map_match(ctrl, PEACH_MAP_EMPTY);");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline peach_map_mask peach_map_match_free(const signed char* ctrl) {");
+    emitLine("    return (peach_map_mask)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl)); // empty or deleted");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline int peach_map_lowest(peach_map_mask mask) {");
+    emitLine("    return __builtin_ctz(mask);");
+    emitLine("}");
+    emitLine("#else");
+    emitLine("#define PEACH_MAP_GROUP 8");
+    emitLine("#define PEACH_MAP_LSBS 0x0101010101010101ULL");
+    emitLine("#define PEACH_MAP_MSBS 0x8080808080808080ULL");
+    emitLine("typedef uint64_t peach_map_mask; // high bit of byte i set for a matching slot i");
+    emitLine("");
+    emitLine("static inline uint64_t peach_map_load(const signed char* ctrl) {");
+    emitLine("    uint64_t word;");
+    emitLine("    memcpy(&word, ctrl, sizeof(word));");
+    emitLine("#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__");
+    emitLine("    word = __builtin_bswap64(word); // slot 0 in the low byte");
+    emitLine("#endif");
+    emitLine("    return word;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline peach_map_mask peach_map_match(const signed char* ctrl, signed char h2) {");
+    emitLine("    // Zero bytes of x; may also flag a full slot right above a match,");
+    emitLine("    // which the key comparison then rejects");
+    emitLine("    uint64_t x = peach_map_load(ctrl) ^ (PEACH_MAP_LSBS * (unsigned char)h2);");
+    emitLine("    return (x - PEACH_MAP_LSBS) & ~x & PEACH_MAP_MSBS;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline peach_map_mask peach_map_match_empty(const signed char* ctrl) {");
+    emitLine("    uint64_t word = peach_map_load(ctrl);");
+    emitLine("    return word & ~(word << 6) & PEACH_MAP_MSBS; // deleted has bit 1 set, empty does not");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline peach_map_mask peach_map_match_free(const signed char* ctrl) {");
+    emitLine("    return peach_map_load(ctrl) & PEACH_MAP_MSBS;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline int peach_map_lowest(peach_map_mask mask) {");
+    emitLine("#if defined(__GNUC__)");
+    emitLine("    return __builtin_ctzll(mask) >> 3;");
+    emitLine("#else");
+    emitLine("    int slot = 0;");
+    emitLine("    while (!(mask & 0x80)) {");
+    emitLine("        mask >>= 8;");
+    emitLine("        slot++;");
+    emitLine("    }");
+    emitLine("    return slot;");
+    emitLine("#endif");
+    emitLine("}");
+    emitLine("#endif");
+    emitLine("");
+    emitLine("static inline uint64_t peach_map_hash_long(uint64_t x) {");
+    emitLine("    x ^= x >> 33;");
+    emitLine("    x *= 0xff51afd7ed558ccdULL;");
+    emitLine("    x ^= x >> 33;");
+    emitLine("    x *= 0xc4ceb9fe1a85ec53ULL;");
+    emitLine("    x ^= x >> 33;");
+    emitLine("    return x;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline uint64_t peach_map_hash_string(const char* s) {");
+    emitLine("    size_t len = strlen(s);");
+    emitLine("    uint64_t h = len * 0x9e3779b97f4a7c15ULL;");
+    emitLine("    uint64_t word;");
+    emitLine("    for (; len >= 8; s += 8, len -= 8) {");
+    emitLine("        memcpy(&word, s, 8);");
+    emitLine("        h = (h ^ word) * 0x100000001b3ULL;");
+    emitLine("        h ^= h >> 29;");
+    emitLine("    }");
+    emitLine("    word = 0;");
+    emitLine("    memcpy(&word, s, len);");
+    emitLine("    return peach_map_hash_long(h ^ word);");
+    emitLine("}");
+    emitLine("");
+    emitLine("// First empty or deleted slot on the probe sequence of hash h");
+    emitLine("static inline long peach_map_probe_free(const signed char* ctrl, long cap, uint64_t h) {");
+    emitLine("    size_t groups = (size_t)cap / PEACH_MAP_GROUP - 1;");
+    emitLine("    size_t g = (size_t)(h >> 7) & groups;");
+    emitLine("    for (size_t step = 1;; step++) {");
+    emitLine("        peach_map_mask slots = peach_map_match_free(ctrl + g * PEACH_MAP_GROUP);");
+    emitLine("        if (slots) {");
+    emitLine("            return (long)(g * PEACH_MAP_GROUP) + peach_map_lowest(slots);");
+    emitLine("        }");
+    emitLine("        g = (g + step) & groups;");
+    emitLine("    }");
+    emitLine("}");
+    emitLine("");
+    emitLine("// Smallest table that holds n entries, a power of two");
+    emitLine("static long peach_map_capacity(long n) {");
+    emitLine("    long cap = PEACH_MAP_GROUP;");
+    emitLine("    while (cap - cap / 8 < n) {");
+    emitLine("        if (cap > LONG_MAX / 2) {");
+    emitLine("            fputs(\"peach: Map too large\\n\", stderr);");
+    emitLine("            abort();");
+    emitLine("        }");
+    emitLine("        cap *= 2;");
+    emitLine("    }");
+    emitLine("    return cap;");
+    emitLine("}");
+    emitLine("");
+    emitLine("// One block: control bytes, then the entries");
+    emitLine("static signed char* peach_map_alloc(long cap, size_t entry_size, size_t entry_align, void** entries) {");
+    emitLine("    size_t n = (size_t)cap;");
+    emitLine("    size_t offset = (n + entry_align - 1) / entry_align * entry_align;");
+    emitLine("    void* block = NULL;");
+    emitLine("    if (n <= (SIZE_MAX / 2 - offset) / entry_size) {");
+    emitLine("        size_t size = offset + n * entry_size;");
+    emitLine("        if (entry_align <= _Alignof(max_align_t)) {");
+    emitLine("            block = malloc(size);");
+    emitLine("        } else {");
+    emitLine("            block = aligned_alloc(entry_align, (size + entry_align - 1) / entry_align * entry_align);");
+    emitLine("        }");
+    emitLine("    }");
+    emitLine("    if (!block) {");
+    emitLine("        fputs(\"peach: Map out of memory\\n\", stderr);");
+    emitLine("        abort();");
+    emitLine("    }");
+    emitLine("    memset(block, PEACH_MAP_EMPTY, n);");
+    emitLine("    *entries = (char*)block + offset;");
+    emitLine("    return block;");
+    emitLine("}");
+    emitLine("");
+}
+
+void BuiltinGenerator::generateMapType(const std::string& mapType) {
+    emitLine("struct " + mapType + " {");
+    emitLine("    signed char* ctrl;");
+    emitLine("    struct " + mapType + "_entry* entries; // key and value, so a hit reads one line");
+    emitLine("    long len;");
+    emitLine("    long cap;");
+    emitLine("    long growth_left; // empty slots that may still be filled");
+    emitLine("};");
+    emitLine("");
+}
+
+void BuiltinGenerator::generateMapFunctions(const std::string& mapType, const std::string& keyType,
+                                            const std::string& valueType) {
+    const std::string& m = mapType;
+    const std::string& k = keyType;
+    const std::string& v = valueType;
+    
+    // Strings are compared by content; the map keeps the pointers
+    bool stringKeys = k == "char*";
+    auto hash = [&](const std::string& key) {
+        return stringKeys ? "peach_map_hash_string(" + key + ")" : "peach_map_hash_long((uint64_t)" + key + ")";
+    };
+    std::string equal = stringKeys ? "strcmp(m->entries[i].key, key) == 0" : "m->entries[i].key == key";
+    std::string entry = "struct " + m + "_entry";
+    
+    emitLine(entry + " {");
+    emitLine("    " + k + " key;");
+    emitLine("    " + v + " value;");
+    emitLine("};");
+    emitLine("");
+    
+    emitLine("static inline long " + m + "_find(const " + m + "* m, " + k + " key, uint64_t h) {");
+    emitLine("    if (m->cap == 0) {");
+    emitLine("        return -1;");
+    emitLine("    }");
+    emitLine("    size_t groups = (size_t)m->cap / PEACH_MAP_GROUP - 1;");
+    emitLine("    size_t g = (size_t)(h >> 7) & groups;");
+    emitLine("    signed char h2 = (signed char)(h & 0x7f);");
+    emitLine("    for (size_t step = 1;; step++) {");
+    emitLine("        const signed char* ctrl = m->ctrl + g * PEACH_MAP_GROUP;");
+    emitLine("        for (peach_map_mask match = peach_map_match(ctrl, h2); match; match &= match - 1) {");
+    emitLine("            long i = (long)(g * PEACH_MAP_GROUP) + peach_map_lowest(match);");
+    emitLine("            if (" + equal + ") {");
+    emitLine("                return i;");
+    emitLine("            }");
+    emitLine("        }");
+    emitLine("        if (peach_map_match_empty(ctrl)) {");
+    emitLine("            return -1;");
+    emitLine("        }");
+    emitLine("        g = (g + step) & groups;");
+    emitLine("    }");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline void " + m + "_rehash(" + m + "* m, long cap) {");
+    emitLine("    " + m + " table = {0};");
+    emitLine("    void* entries;");
+    emitLine("    table.ctrl = peach_map_alloc(cap, sizeof(" + entry + "), _Alignof(" + entry + "), &entries);");
+    emitLine("    table.entries = entries;");
+    emitLine("    table.len = m->len;");
+    emitLine("    table.cap = cap;");
+    emitLine("    table.growth_left = cap - cap / 8 - m->len;");
+    emitLine("    for (long i = 0; i < m->cap; i++) {");
+    emitLine("        if (m->ctrl[i] >= 0) {");
+    emitLine("            uint64_t h = " + hash("m->entries[i].key") + ";");
+    emitLine("            long j = peach_map_probe_free(table.ctrl, cap, h);");
+    emitLine("            table.ctrl[j] = (signed char)(h & 0x7f);");
+    emitLine("            table.entries[j] = m->entries[i];");
+    emitLine("        }");
+    emitLine("    }");
+    emitLine("    free(m->ctrl);");
+    emitLine("    *m = table;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline void " + m + "_reserve(" + m + "* m, long n) {");
+    emitLine("    if (n > m->len + m->growth_left) {");
+    emitLine("        " + m + "_rehash(m, peach_map_capacity(n));");
+    emitLine("    }");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline " + m + " " + m + "_new(long n) {");
+    emitLine("    " + m + " m = {0};");
+    emitLine("    " + m + "_reserve(&m, n);");
+    emitLine("    return m;");
+    emitLine("}");
+    emitLine("");
+    emitLine("// The value of key, inserted as zero when missing");
+    emitLine("static inline " + v + "* " + m + "_slot(" + m + "* m, " + k + " key) {");
+    emitLine("    uint64_t h = " + hash("key") + ";");
+    emitLine("    long i = " + m + "_find(m, key, h);");
+    emitLine("    if (i >= 0) {");
+    emitLine("        return &m->entries[i].value;");
+    emitLine("    }");
+    emitLine("    if (m->growth_left == 0) {");
+    emitLine("        // Mostly deleted slots: same size again, otherwise twice the size");
+    emitLine("        " + m + "_rehash(m, m->len * 16 < m->cap * 7 ? m->cap : m->cap ? m->cap * 2 : PEACH_MAP_GROUP);");
+    emitLine("    }");
+    emitLine("    i = peach_map_probe_free(m->ctrl, m->cap, h);");
+    emitLine("    m->growth_left -= m->ctrl[i] == PEACH_MAP_EMPTY;");
+    emitLine("    m->ctrl[i] = (signed char)(h & 0x7f);");
+    emitLine("    m->entries[i].key = key;");
+    emitLine("    memset(&m->entries[i].value, 0, sizeof(" + v + "));");
+    emitLine("    m->len++;");
+    emitLine("    return &m->entries[i].value;");
+    emitLine("}");
+    emitLine("");
+    emitLine("// The value of key in place, or a zero value when missing");
+    emitLine("static inline " + v + " const* " + m + "_at(const " + m + "* m, " + k + " key) {");
+    emitLine("    static " + v + " const zero;");
+    emitLine("    long i = " + m + "_find(m, key, " + hash("key") + ");");
+    emitLine("    return i >= 0 ? &m->entries[i].value : &zero;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline " + v + " " + m + "_get(const " + m + "* m, " + k + " key) {");
+    emitLine("    return *" + m + "_at(m, key);");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline int " + m + "_has(const " + m + "* m, " + k + " key) {");
+    emitLine("    return " + m + "_find(m, key, " + hash("key") + ") >= 0;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline int " + m + "_remove(" + m + "* m, " + k + " key) {");
+    emitLine("    long i = " + m + "_find(m, key, " + hash("key") + ");");
+    emitLine("    if (i < 0) {");
+    emitLine("        return 0;");
+    emitLine("    }");
+    emitLine("    // A group that still has an empty slot was never full, so no probe");
+    emitLine("    // went past it and the slot can be empty again");
+    emitLine("    if (peach_map_match_empty(m->ctrl + (i & -(long)PEACH_MAP_GROUP))) {");
+    emitLine("        m->ctrl[i] = PEACH_MAP_EMPTY;");
+    emitLine("        m->growth_left++;");
+    emitLine("    } else {");
+    emitLine("        m->ctrl[i] = PEACH_MAP_DELETED;");
+    emitLine("    }");
+    emitLine("    m->len--;");
+    emitLine("    return 1;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline void " + m + "_clear(" + m + "* m) {");
+    emitLine("    if (m->cap) {");
+    emitLine("        memset(m->ctrl, PEACH_MAP_EMPTY, (size_t)m->cap);");
+    emitLine("    }");
+    emitLine("    m->len = 0;");
+    emitLine("    m->growth_left = m->cap - m->cap / 8;");
+    emitLine("}");
+    emitLine("");
+    emitLine("static inline void " + m + "_release(" + m + "* m) {");
+    emitLine("    free(m->ctrl);");
+    emitLine("    m->ctrl = NULL;");
+    emitLine("    m->entries = NULL;");
+    emitLine("    m->len = m->cap = m->growth_left = 0;");
+    emitLine("}");
+    emitLine("");
+}
@@ -5,16 +5,36 @@
 class BuiltinGenerator : public CodeGenBase {
 private:
     const UsageTracker& usage;
+    bool wholeProgram; // the program is the only unit
+    bool bufferedOutput;
     
 public:
-    BuiltinGenerator(std::stringstream& out, int& indent, const UsageTracker& tracker) 
-        : CodeGenBase(out, indent), usage(tracker) {}
+    BuiltinGenerator(OutputBuffer& out, int& indent, const UsageTracker& tracker, bool whole = false,
+                     bool buffered = false)
+        : CodeGenBase(out, indent), usage(tracker), wholeProgram(whole), bufferedOutput(buffered) {}
     
     void generateAll();
     
+    // One Vec[T]: the struct goes before user structs, which may hold it, the
+    // functions after them, since they need the element type complete. The
+    // typedef of its name comes first.
+    void generateVecType(const std::string& vecType, const std::string& elementType);
+    void generateVecFunctions(const std::string& vecType, const std::string& elementType);
+    
+    // One Map[K, V], placed like a Vec; its entry struct goes with the functions
+    void generateMapType(const std::string& mapType);
+    void generateMapFunctions(const std::string& mapType, const std::string& keyType, const std::string& valueType);
+    
 private:
     void generateIncludes();
     void generateRangeStructs();
     void generatePrintFunctions();
+    void generateBufferedOutput();
     void generateUtilityMacros();
+    void generateInlineMacros();
+    void generateParallelRuntime();
+    void generateVectorTypes();
+    void generateArenaRuntime();
+    void generateVecRuntime();
+    void generateMapRuntime();
 };
\ No newline at end of file
@@ -1,63 +1,103 @@
 #include "expr.h"
+#include "type.h"
 #include <stdexcept>
 
-void ExprGenerator::generate(ExprNode* node) {
-    if (auto* intLit = dynamic_cast<IntLiteralNode*>(node)) {
-        generateIntLiteral(intLit);
-    } else if (auto* longLit = dynamic_cast<LongLiteralNode*>(node)) {
-        generateLongLiteral(longLit);
-    } else if (auto* floatLit = dynamic_cast<FloatLiteralNode*>(node)) {
-        generateFloatLiteral(floatLit);
-    } else if (auto* doubleLit = dynamic_cast<DoubleLiteralNode*>(node)) {
-        generateDoubleLiteral(doubleLit);
-    } else if (auto* stringLit = dynamic_cast<StringLiteralNode*>(node)) {
-        generateStringLiteral(stringLit);
-    } else if (auto* boolLit = dynamic_cast<BoolLiteralNode*>(node)) {
-        generateBoolLiteral(boolLit);
-    } else if (auto* ident = dynamic_cast<IdentifierNode*>(node)) {
-        generateIdentifier(ident);
-    } else if (auto* arrayLit = dynamic_cast<ArrayLiteralNode*>(node)) {
-        generateArrayLiteral(arrayLit);
-    } else if (auto* indexNode = dynamic_cast<IndexNode*>(node)) {
-        generateIndex(indexNode);
-    } else if (auto* binOp = dynamic_cast<BinaryOpNode*>(node)) {
-        generateBinaryOp(binOp);
-    } else if (auto* unaryOp = dynamic_cast<UnaryOpNode*>(node)) {
-        generateUnaryOp(unaryOp);
-    } else if (auto* call = dynamic_cast<CallNode*>(node)) {
-        generateCall(call);
-    } else if (auto* addrOf = dynamic_cast<AddressOfNode*>(node)) {
-        generateAddressOf(addrOf);
-    } else if (auto* deref = dynamic_cast<DereferenceNode*>(node)) {
-        generateDereference(deref);
-    } else if (auto* fieldAccess = dynamic_cast<FieldAccessNode*>(node)) {
-        generateFieldAccess(fieldAccess);
-    } else if (auto* structInit = dynamic_cast<StructInitNode*>(node)) {
-        generateStructInit(structInit);
-    } else if (auto* unionInit = dynamic_cast<UnionInitNode*>(node)) {
-        generateUnionInit(unionInit);
-    } else if (auto* methodCall = dynamic_cast<MethodCallNode*>(node)) {
-        generateMethodCall(methodCall);
-    }
-}
-
-void ExprGenerator::generateIntLiteral(IntLiteralNode* node) {
-    emit(std::to_string(node->value));
+namespace {
+
+// Outermost bound of a sized array type "T[N]...", empty for anything else
+std::string_view arrayBound(const std::string& type) {
+    if (type.empty() || type.back() != ']') {
+        return {};
+    }
+    size_t open = type.find('[');
+    return std::string_view(type).substr(open + 1, type.find(']', open) - open - 1);
 }
 
-void ExprGenerator::generateLongLiteral(LongLiteralNode* node) {
-    emit(std::to_string(node->value) + "L");
+// Variable a field or element access starts from, empty otherwise
+Symbol rootName(ExprNode* expr) {
+    while (true) {
+        if (auto* index = nodeCast<IndexNode>(expr)) {
+            expr = index->array.get();
+        } else if (auto* fieldAccess = nodeCast<FieldAccessNode>(expr)) {
+            expr = fieldAccess->object.get();
+        } else if (auto* ident = nodeCast<IdentifierNode>(expr)) {
+            return ident->name;
+        } else {
+            return Symbol();
+        }
+    }
 }
 
-void ExprGenerator::generateFloatLiteral(FloatLiteralNode* node) {
-    emit(std::to_string(node->value) + "f");
+// Same variable, field or literal, e.g. the key of m[k] on both sides of m[k] = m[k] + 1
+bool sameOperand(ExprNode* a, ExprNode* b) {
+    if (auto* identifier = nodeCast<IdentifierNode>(a)) {
+        auto* other = nodeCast<IdentifierNode>(b);
+        return other && other->name == identifier->name;
+    }
+    if (auto* literal = nodeCast<IntLiteralNode>(a)) {
+        auto* other = nodeCast<IntLiteralNode>(b);
+        return other && other->value == literal->value;
+    }
+    if (auto* literal = nodeCast<LongLiteralNode>(a)) {
+        auto* other = nodeCast<LongLiteralNode>(b);
+        return other && other->value == literal->value;
+    }
+    if (auto* literal = nodeCast<StringLiteralNode>(a)) {
+        auto* other = nodeCast<StringLiteralNode>(b);
+        return other && other->value == literal->value;
+    }
+    if (auto* fieldAccess = nodeCast<FieldAccessNode>(a)) {
+        auto* other = nodeCast<FieldAccessNode>(b);
+        return other && other->fieldName == fieldAccess->fieldName &&
+               sameOperand(fieldAccess->object.get(), other->object.get());
+    }
+    return false;
 }
 
-void ExprGenerator::generateDoubleLiteral(DoubleLiteralNode* node) {
+// Calls nothing and assigns nothing, so evaluating it cannot insert into a Map
+bool isPlainRead(ExprNode* node) {
+    if (nodeCast<IdentifierNode>(node) || nodeCast<IntLiteralNode>(node) || nodeCast<LongLiteralNode>(node) ||
+        nodeCast<FloatLiteralNode>(node) || nodeCast<DoubleLiteralNode>(node) || nodeCast<BoolLiteralNode>(node) ||
+        nodeCast<StringLiteralNode>(node)) {
+        return true;
+    }
+    if (auto* index = nodeCast<IndexNode>(node)) {
+        return isPlainRead(index->array.get()) && isPlainRead(index->index.get());
+    }
+    if (auto* binaryOp = nodeCast<BinaryOpNode>(node)) {
+        return binaryOp->op != "=" && isPlainRead(binaryOp->left.get()) && isPlainRead(binaryOp->right.get());
+    }
+    if (auto* unaryOp = nodeCast<UnaryOpNode>(node)) {
+        return isPlainRead(unaryOp->operand.get());
+    }
+    if (auto* fieldAccess = nodeCast<FieldAccessNode>(node)) {
+        return isPlainRead(fieldAccess->object.get());
+    }
+    if (auto* dereference = nodeCast<DereferenceNode>(node)) {
+        return isPlainRead(dereference->operand.get());
+    }
+    return false;
+}
+
+} // namespace
+
+void ExprGenerator::visitIntLiteral(IntLiteralNode* node) {
+    output << node->value;
+}
+
+void ExprGenerator::visitLongLiteral(LongLiteralNode* node) {
+    output << node->value << "L";
+}
+
+void ExprGenerator::visitFloatLiteral(FloatLiteralNode* node) {
+    output << std::to_string(node->value) << "f";
+}
+
+void ExprGenerator::visitDoubleLiteral(DoubleLiteralNode* node) {
     emit(std::to_string(node->value));
 }
 
-void ExprGenerator::generateStringLiteral(StringLiteralNode* node) {
+void ExprGenerator::visitStringLiteral(StringLiteralNode* node) {
     emit("\"");
     for (char c : node->value) {
         switch (c) {
@@ -72,15 +112,21 @@ void ExprGenerator::generateStringLiteral(StringLiteralNode* node) {
     emit("\"");
 }
 
-void ExprGenerator::generateBoolLiteral(BoolLiteralNode* node) {
+void ExprGenerator::visitBoolLiteral(BoolLiteralNode* node) {
     emit(node->value ? "1" : "0");
 }
 
-void ExprGenerator::generateIdentifier(IdentifierNode* node) {
+void ExprGenerator::visitIdentifier(IdentifierNode* node) {
+    if (symbolTable) {
+        if (const std::string* alias = symbolTable->getAlias(node->name)) {
+            emit(*alias);
+            return;
+        }
+    }
     emit(node->name);
 }
 
-void ExprGenerator::generateArrayLiteral(ArrayLiteralNode* node) {
+void ExprGenerator::visitArrayLiteral(ArrayLiteralNode* node) {
     emit("{");
     for (size_t i = 0; i < node->elements.size(); i++) {
         if (i > 0) emit(", ");
@@ -89,16 +135,57 @@ void ExprGenerator::generateArrayLiteral(ArrayLiteralNode* node) {
     emit("}");
 }
 
-void ExprGenerator::generateIndex(IndexNode* node) {
-    generate(node->array.get());
+void ExprGenerator::visitIndex(IndexNode* node) {
+    std::string arrayType = typeRegistry ? typeOf(node->array.get()) : "";
+    if (const MapInfo* map = typeRegistry ? typeRegistry->getMap(arrayType) : nullptr) {
+        generateMapIndex(node, *map);
+        return;
+    }
+    
+    if (typeRegistry && typeRegistry->usesVectors() && findVectorType(arrayType)) {
+        // Lane of a vector
+        emit("peach_lane(");
+        generate(node->array.get());
+        emit(", ");
+        generate(node->index.get());
+        emit(")");
+        return;
+    }
+    
+    // The array is a target along with its element
+    if (typeRegistry && !typeRegistry->getVecElementType(arrayType).empty()) {
+        emit("(");
+        visit(node->array.get());
+        emit(").data[");
+        generate(node->index.get());
+        emit("]");
+        return;
+    }
+    
+    visit(node->array.get());
+    if (typeRegistry && !typeRegistry->getSliceElementType(arrayType).empty()) {
+        emit(".ptr");
+    }
     emit("[");
     generate(node->index.get());
     emit("]");
 }
 
-void ExprGenerator::generateBinaryOp(BinaryOpNode* node) {
+void ExprGenerator::visitBinaryOp(BinaryOpNode* node) {
+    if (typeRegistry && typeRegistry->usesVectors() && generateVectorOp(node)) {
+        return;
+    }
+    
+    if (node->op == "=" && generateMapUpdate(node)) {
+        return;
+    }
+    
     emit("(");
-    generate(node->left.get());
+    if (node->op == "=") {
+        generateTarget(node->left.get());
+    } else {
+        generate(node->left.get());
+    }
     emit(" ");
     emit(node->op);
     emit(" ");
@@ -106,37 +193,180 @@ void ExprGenerator::generateBinaryOp(BinaryOpNode* node) {
     emit(")");
 }
 
-void ExprGenerator::generateUnaryOp(UnaryOpNode* node) {
+bool ExprGenerator::generateVectorOp(BinaryOpNode* node) {
+    static const std::pair<std::string_view, std::string_view> operations[] = {
+        {"+", "add"}, {"-", "sub"}, {"*", "mul"}, {"/", "div"}
+    };
+    
+    std::string_view operation;
+    for (const auto& entry : operations) {
+        if (node->op == entry.first) {
+            operation = entry.second;
+        }
+    }
+    if (operation.empty()) {
+        return false;
+    }
+    
+    const VectorType* leftVector = findVectorType(typeOf(node->left.get()));
+    const VectorType* rightVector = findVectorType(typeOf(node->right.get()));
+    if (!leftVector && !rightVector) {
+        return false;
+    }
+    if (leftVector && rightVector && leftVector != rightVector) {
+        throw std::runtime_error("Cannot apply '" + node->op + "' to " + std::string(leftVector->name) +
+                                 " and " + std::string(rightVector->name));
+    }
+    
+    // Elementwise, a scalar operand is broadcast to every lane
+    std::string type = (leftVector ? leftVector : rightVector)->cType();
+    auto generateOperand = [&](ExprNode* operand, const VectorType* vector) {
+        if (vector) {
+            generate(operand);
+        } else {
+            output << type << "_splat(";
+            generate(operand);
+            emit(")");
+        }
+    };
+    
+    output << type << "_" << operation << "(";
+    generateOperand(node->left.get(), leftVector);
+    emit(", ");
+    generateOperand(node->right.get(), rightVector);
+    emit(")");
+    return true;
+}
+
+void ExprGenerator::generateElementAddress(ExprNode* array, ExprNode* index, const VectorType& vector) {
+    // Lanes are copied from the elements, which must have the lane type
+    std::string arrayType = typeOf(array);
+    std::string elementType = typeRegistry->getSliceElementType(arrayType);
+    bool isSlice = !elementType.empty();
+    if (!isSlice && !arrayType.empty() && arrayType.back() == ']' &&
+        arrayType.find('[') == arrayType.rfind('[')) {
+        elementType = arrayType.substr(0, arrayType.find('['));
+    } else if (!isSlice && !arrayType.empty() && arrayType.back() == '*') {
+        elementType = arrayType.substr(0, arrayType.size() - 1);
+    }
+    if (!elementType.empty() && elementType != vector.elementType) {
+        throw std::runtime_error("Cannot access " + std::string(vector.name) + " lanes in elements of type '" +
+                                 elementType + "'");
+    }
+    
+    emit("(");
+    generate(array);
+    emit(")");
+    if (isSlice) {
+        emit(".ptr");
+    }
+    emit(" + (");
+    generate(index);
+    emit(")");
+}
+
+bool ExprGenerator::generateVectorBuiltin(CallNode* node) {
+    static const Symbol store("store"), hsum("hsum"), hmin("hmin"), hmax("hmax");
+    const auto& args = node->arguments;
+    
+    // Typed constructors: f32x8_splat(x), f32x8_load(xs, i)
+    std::string_view operation;
+    if (const VectorType* vector = findVectorBuiltin(node->functionName.str(), operation)) {
+        if (operation == "splat" && args.size() == 1) {
+            output << vector->cType() << "_splat(";
+            generate(args[0].get());
+            emit(")");
+            return true;
+        }
+        if (operation == "load" && args.size() == 2) {
+            output << vector->cType() << "_load(";
+            generateElementAddress(args[0].get(), args[1].get(), *vector);
+            emit(")");
+            return true;
+        }
+        return false;
+    }
+    
+    // Generic consumers, typed by their vector argument
+    if (node->functionName == store && args.size() == 3) {
+        if (const VectorType* vector = findVectorType(typeOf(args[2].get()))) {
+            output << vector->cType() << "_store(";
+            generateElementAddress(args[0].get(), args[1].get(), *vector);
+            emit(", ");
+            generate(args[2].get());
+            emit(")");
+            return true;
+        }
+    } else if ((node->functionName == hsum || node->functionName == hmin || node->functionName == hmax) &&
+               args.size() == 1) {
+        if (const VectorType* vector = findVectorType(typeOf(args[0].get()))) {
+            output << vector->cType() << "_" << node->functionName << "(";
+            generate(args[0].get());
+            emit(")");
+            return true;
+        }
+    }
+    return false;
+}
+
+void ExprGenerator::visitUnaryOp(UnaryOpNode* node) {
     emit(node->op);
     emit("(");
     generate(node->operand.get());
     emit(")");
 }
 
-void ExprGenerator::generateCall(CallNode* node) {
-    // Special handling for print function
-    if (node->functionName == "print") {
-        if (node->arguments.size() == 1) {
-            emit("print(");
+void ExprGenerator::visitCall(CallNode* node) {
+    static const Symbol print("print"), flush("flush"), range("range"), len("len"), arenaName("Arena");
+    static const Symbol vecName("Vec"), mapName("Map");
+    
+    if (node->functionName == arenaName) {
+        generateArenaCall(node);
+        return;
+    }
+    if (node->functionName == vecName) {
+        generateVecCall(node);
+        return;
+    }
+    if (node->functionName == mapName) {
+        generateMapCall(node);
+        return;
+    }
+    
+    if (node->functionName == print) {
+        generatePrint(node);
+        return;
+    }
+    if (node->functionName == flush) {
+        if (!node->arguments.empty()) {
+            throw std::runtime_error("flush() takes no arguments");
+        }
+        emit("peach_flush()");
+        return;
+    }
+    
+    if (typeRegistry && typeRegistry->usesVectors() && generateVectorBuiltin(node)) {
+        return;
+    }
+    
+    // len() of a slice, Vec, Map or sized array parameter is known without sizeof
+    if (node->functionName == len && node->arguments.size() == 1) {
+        std::string argType = typeOf(node->arguments[0].get());
+        if (typeRegistry && (!typeRegistry->getSliceElementType(argType).empty() ||
+                             !typeRegistry->getVecElementType(argType).empty() || typeRegistry->getMap(argType))) {
+            emit("(");
             generate(node->arguments[0].get());
-            emit(")");
-            return;
-        } else if (node->arguments.size() == 0) {
-            emit("printf(\"\\n\")");
+            emit(").len");
             return;
         }
-        // For multiple arguments, print each separately
-        for (size_t i = 0; i < node->arguments.size(); i++) {
-            if (i > 0) emit("; ");
-            emit("print(");
-            generate(node->arguments[i].get());
-            emit(")");
+        if (!arrayBound(argType).empty()) {
+            emit(arrayBound(argType));
+            return;
         }
-        return;
     }
     
     // Handle range function with different arities
-    if (node->functionName == "range") {
+    if (node->functionName == range) {
         if (node->arguments.size() == 1) {
             emit("range1");
         } else if (node->arguments.size() == 2) {
@@ -151,33 +381,179 @@ void ExprGenerator::generateCall(CallNode* node) {
     }
     
     emit("(");
-    for (size_t i = 0; i < node->arguments.size(); i++) {
-        if (i > 0) emit(", ");
-        generate(node->arguments[i].get());
-    }
+    const std::vector<std::string>* parameterTypes =
+        typeRegistry ? typeRegistry->getFunctionParameterTypes(node->functionName) : nullptr;
+    std::unordered_set<Symbol> outerRoots = std::move(sharedRoots);
+    sharedRoots = collectSharedRoots(node->arguments);
+    generateArguments(node->arguments, parameterTypes, false);
+    sharedRoots = std::move(outerRoots);
     emit(")");
 }
 
-void ExprGenerator::generateAddressOf(AddressOfNode* node) {
+void ExprGenerator::generateAs(ExprNode* node, bool target) {
+    bool outer = isTarget;
+    isTarget = target;
+    visit(node);
+    isTarget = outer;
+}
+
+std::string ExprGenerator::typeOf(ExprNode* node) {
+    TypeGenerator typeGen(output, indentLevel, symbolTable, typeRegistry);
+    return typeGen.inferType(node);
+}
+
+void ExprGenerator::generateArguments(const std::vector<ExprNodePtr>& arguments,
+                                      const std::vector<std::string>* parameterTypes, bool leadingComma) {
+    for (size_t i = 0; i < arguments.size(); i++) {
+        if (i > 0 || leadingComma) emit(", ");
+        
+        // Arrays passed to a slice parameter are wrapped with their length
+        if (parameterTypes && i < parameterTypes->size()) {
+            const std::string& paramType = (*parameterTypes)[i];
+            if (paramType.compare(0, 13, "const struct ") == 0 && paramType.back() == '*') {
+                generateReadOnlyReference(arguments[i].get(), paramType.substr(6, paramType.size() - 7));
+                continue;
+            }
+            std::string elementType = typeRegistry->getSliceElementType(paramType);
+            if (!elementType.empty()) {
+                generateSliceArgument(arguments[i].get(), paramType, elementType);
+                continue;
+            }
+        }
+        generate(arguments[i].get());
+    }
+}
+
+std::unordered_set<Symbol> ExprGenerator::collectSharedRoots(const std::vector<ExprNodePtr>& arguments) {
+    // An array argument decays to a pointer, directly or inside a slice,
+    // so the callee can write to whatever it belongs to
+    std::unordered_set<Symbol> roots;
+    for (const auto& arg : arguments) {
+        std::string argType = typeOf(arg.get());
+        if (!argType.empty() && argType.back() == ']') {
+            Symbol root = rootName(arg.get());
+            if (!root.empty()) {
+                roots.insert(root);
+            }
+        }
+    }
+    return roots;
+}
+
+bool ExprGenerator::isBorrowable(ExprNode* node) {
+    if (auto* ident = nodeCast<IdentifierNode>(node)) {
+        // Locals and parameters, not globals
+        return symbolTable && symbolTable->hasSymbol(ident->name) &&
+               !symbolTable->isAddressTaken(ident->name) && !sharedRoots.count(ident->name);
+    }
+    if (auto* fieldAccess = nodeCast<FieldAccessNode>(node)) {
+        // Not through a pointer, the pointee may be reachable from anywhere
+        std::string objectType = typeOf(fieldAccess->object.get());
+        return !objectType.empty() && objectType.back() != '*' && isBorrowable(fieldAccess->object.get());
+    }
+    if (auto* index = nodeCast<IndexNode>(node)) {
+        // Elements of the function's own arrays, not of pointers or slices
+        std::string arrayType = typeOf(index->array.get());
+        return !arrayType.empty() && arrayType.back() == ']' && isBorrowable(index->array.get());
+    }
+    return false;
+}
+
+void ExprGenerator::generateReadOnlyReference(ExprNode* node, const std::string& structType) {
+    if (isBorrowable(node)) {
+        // Nothing else can reach the argument while the callee reads it
+        emit("&(");
+        generate(node);
+        emit(")");
+    } else {
+        // A copy the callee can point to, alive until the end of the enclosing block
+        output << "(const " << structType << "[]){";
+        generate(node);
+        emit("}");
+    }
+}
+
+void ExprGenerator::generateSliceArgument(ExprNode* node, const std::string& sliceType,
+                                          const std::string& elementType) {
+    if (auto* arrayLit = nodeCast<ArrayLiteralNode>(node)) {
+        // Compound literal array, lives until the end of the enclosing block
+        output << "(" << sliceType << "){(" << elementType << "[])";
+        generate(arrayLit);
+        output << ", " << arrayLit->elements.size() << "}";
+        return;
+    }
+    
+    std::string argType = typeOf(node);
+    if (argType == sliceType) {
+        generate(node);
+        return;
+    }
+    
+    if (typeRegistry->getSliceElementType(argType) == elementType) {
+        // Same elements, other qualification (plain vs restrict)
+        output << "(" << sliceType << "){(";
+        generate(node);
+        emit(").ptr, (");
+        generate(node);
+        emit(").len}");
+        return;
+    }
+    
+    if (typeRegistry->getVecElementType(argType) == elementType) {
+        // A view of the Vec's elements, valid until it grows or is released
+        output << "(" << sliceType << "){(";
+        generate(node);
+        emit(").data, (size_t)(");
+        generate(node);
+        emit(").len}");
+        return;
+    }
+    
+    output << "(" << sliceType << "){";
+    generate(node);
+    emit(", ");
+    if (!arrayBound(argType).empty()) {
+        // Sized array, the bound is part of its type
+        emit(arrayBound(argType));
+    } else if (!argType.empty() && argType.back() == '*') {
+        throw std::runtime_error("Cannot pass pointer of type '" + argType +
+                                 "' as " + sliceType + ": its length is unknown");
+    } else {
+        // Local or global array
+        emit("sizeof(");
+        generate(node);
+        emit(") / sizeof((");
+        generate(node);
+        emit(")[0])");
+    }
+    emit("}");
+}
+
+void ExprGenerator::visitAddressOf(AddressOfNode* node) {
     emit("&(");
-    generate(node->operand.get());
+    generateTarget(node->operand.get());
     emit(")");
 }
 
-void ExprGenerator::generateDereference(DereferenceNode* node) {
+void ExprGenerator::visitDereference(DereferenceNode* node) {
     emit("*(");
     generate(node->operand.get());
     emit(")");
 }
 
-void ExprGenerator::generateFieldAccess(FieldAccessNode* node) {
-    generate(node->object.get());
-    emit(".");
+void ExprGenerator::visitFieldAccess(FieldAccessNode* node) {
+    // Fields are reached through struct pointers too, e.g. nodes from an Arena
+    std::string objectType = typeOf(node->object.get());
+    bool throughPointer = !objectType.empty() && objectType.back() == '*' &&
+                          (objectType.compare(0, 7, "struct ") == 0 || objectType.compare(0, 6, "union ") == 0) &&
+                          objectType.find('*') == objectType.size() - 1;
+    visit(node->object.get()); // a target if the field is
+    emit(throughPointer ? "->" : ".");
     emit(node->fieldName);
 }
 
-void ExprGenerator::generateStructInit(StructInitNode* node) {
-    emit("(struct " + node->structName + "){");
+void ExprGenerator::visitStructInit(StructInitNode* node) {
+    output << "(struct " << node->structName << "){";
     
     for (size_t i = 0; i < node->fields.size(); i++) {
         if (i > 0) emit(", ");
@@ -185,7 +561,7 @@ void ExprGenerator::generateStructInit(StructInitNode* node) {
         const auto& field = node->fields[i];
         if (!field.first.empty()) {
             // Named field initialization: .fieldName = value
-            emit("." + field.first + " = ");
+            output << "." << field.first << " = ";
         }
         generate(field.second.get());
     }
@@ -193,11 +569,29 @@ void ExprGenerator::generateStructInit(StructInitNode* node) {
     emit("}");
 }
 
-void ExprGenerator::generateMethodCall(MethodCallNode* node) {
+void ExprGenerator::visitMethodCall(MethodCallNode* node) {
+    std::string receiverType = typeOf(node->receiver.get());
+    if (TypeGenerator::isArenaType(receiverType)) {
+        generateArenaMethod(node, receiverType.back() == '*');
+        return;
+    }
+    
+    // Vecs and Maps are reached through pointers too, e.g. a *Vec[int] parameter
+    bool throughPointer = !receiverType.empty() && receiverType.back() == '*';
+    std::string vecType = throughPointer ? receiverType.substr(0, receiverType.size() - 1) : receiverType;
+    if (typeRegistry && !typeRegistry->getVecElementType(vecType).empty()) {
+        generateVecMethod(node, vecType, throughPointer);
+        return;
+    }
+    if (const MapInfo* map = typeRegistry ? typeRegistry->getMap(vecType) : nullptr) {
+        generateMapMethod(node, *map, throughPointer);
+        return;
+    }
+    
     // Try to determine the struct type of the receiver
     std::string structName;
     
-    if (auto* ident = dynamic_cast<IdentifierNode*>(node->receiver.get())) {
+    if (auto* ident = nodeCast<IdentifierNode>(node->receiver.get())) {
         // Look up variable type from symbol table or type registry
         if (symbolTable && symbolTable->hasSymbol(ident->name)) {
             std::string varType = symbolTable->getSymbolType(ident->name);
@@ -211,9 +605,9 @@ void ExprGenerator::generateMethodCall(MethodCallNode* node) {
                 structName = varType.substr(7);
             }
         }
-    } else if (auto* fieldAccess = dynamic_cast<FieldAccessNode*>(node->receiver.get())) {
+    } else if (auto* fieldAccess = nodeCast<FieldAccessNode>(node->receiver.get())) {
         // Handle nested field access like c1.center.magnitude()
-        if (auto* baseIdent = dynamic_cast<IdentifierNode*>(fieldAccess->object.get())) {
+        if (auto* baseIdent = nodeCast<IdentifierNode>(fieldAccess->object.get())) {
             std::string baseType;
             if (symbolTable && symbolTable->hasSymbol(baseIdent->name)) {
                 baseType = symbolTable->getSymbolType(baseIdent->name);
@@ -237,8 +631,8 @@ void ExprGenerator::generateMethodCall(MethodCallNode* node) {
     // If we couldn't determine the struct type, use a fallback
     if (structName.empty()) {
         // Debug: emit a comment to help diagnose type resolution issues
-        if (auto* id = dynamic_cast<IdentifierNode*>(node->receiver.get())) {
-            emit("/* ERROR: Could not determine struct type for " + id->name + " */ ");
+        if (auto* id = nodeCast<IdentifierNode>(node->receiver.get())) {
+            output << "/* ERROR: Could not determine struct type for " << id->name << " */ ";
         } else {
             emit("/* ERROR: Could not determine struct type for receiver */ ");
         }
@@ -246,20 +640,291 @@ void ExprGenerator::generateMethodCall(MethodCallNode* node) {
     }
     
     // Generate function call: __StructName_methodName(receiver, args...)
-    emit("__" + structName + "_" + node->methodName + "(");
-    generate(node->receiver.get());
+    output << "__" << structName << "_" << node->methodName << "(";
+    const MethodInfo* method = typeRegistry ? typeRegistry->getMethod(structName, node->methodName) : nullptr;
+    std::unordered_set<Symbol> outerRoots = std::move(sharedRoots);
+    sharedRoots = collectSharedRoots(node->arguments);
+    if (method && method->isReceiverByReference) {
+        generateReadOnlyReference(node->receiver.get(), "struct " + structName);
+    } else {
+        generate(node->receiver.get());
+    }
+    
+    generateArguments(node->arguments, method ? &method->parameterTypes : nullptr, true);
+    sharedRoots = std::move(outerRoots);
+    
+    emit(")");
+}
+
+void ExprGenerator::visitUnionInit(UnionInitNode* node) {
+    output << "(union " << node->unionName << "){." << node->activeMember << " = ";
+    generate(node->value.get());
+    emit("}");
+}
+
+void ExprGenerator::generatePrint(CallNode* node) {
+    // A formatter per argument by its inferred type, then one write for the
+    // statement. "int" is also what inference falls back to, so those go
+    // through peach_print and let the C compiler pick.
+    emit("(");
+    for (const auto& arg : node->arguments) {
+        std::string type = typeOf(arg.get());
+        if (type == "long") {
+            emit("peach_print_long(");
+        } else if (type == "double" || type == "float") {
+            emit("peach_print_double(");
+        } else if (type == "char*" || type == "const char*") {
+            emit("peach_print_string(");
+        } else {
+            emit("peach_print(");
+        }
+        generate(arg.get());
+        emit("), ");
+    }
+    if (node->arguments.empty()) {
+        emit("peach_print_newline(), ");
+    }
+    emit("peach_print_end())");
+}
+
+void ExprGenerator::generateArenaCall(CallNode* node) {
+    // Chunks are allocated on first use; Arena(n) sets their size in bytes
+    if (node->arguments.empty()) {
+        emit("((peach_arena){0})");
+        return;
+    }
+    if (node->arguments.size() != 1) {
+        throw std::runtime_error("Arena() takes at most one argument, the chunk size");
+    }
+    emit("((peach_arena){.chunk_size = (size_t)(");
+    generate(node->arguments[0].get());
+    emit(")})");
+}
+
+void ExprGenerator::generateArenaMethod(MethodCallNode* node, bool throughPointer) {
+    static const Symbol alloc("alloc"), reset("reset"), release("release"), used("used");
+    
+    auto generateArena = [&]() {
+        if (!throughPointer) {
+            emit("&");
+        }
+        emit("(");
+        generate(node->receiver.get());
+        emit(")");
+    };
+    
+    if (node->methodName == alloc) {
+        if (!node->typeArgument || node->arguments.size() > 1) {
+            throw std::runtime_error("Arena allocation takes a type and a count: alloc[T](n)");
+        }
+        std::string elementType = node->typeArgument->toCType();
+        output << "((" << elementType << "*)peach_arena_alloc(";
+        generateArena();
+        output << ", sizeof(" << elementType << ")";
+        if (!node->arguments.empty()) {
+            emit(" * (size_t)(");
+            generate(node->arguments[0].get());
+            emit(")");
+        }
+        output << ", _Alignof(" << elementType << ")))";
+        return;
+    }
+    
+    if ((node->methodName == reset || node->methodName == release || node->methodName == used) &&
+        node->arguments.empty() && !node->typeArgument) {
+        output << "peach_arena_" << node->methodName.str() << "(";
+        generateArena();
+        emit(")");
+        return;
+    }
     
+    throw std::runtime_error("Unknown Arena method: " + node->methodName.str());
+}
+
+void ExprGenerator::generateVecCall(CallNode* node) {
+    // Vec[T]() starts empty without allocating; Vec[T](n) reserves n elements
+    if (node->typeArguments.size() != 1) {
+        throw std::runtime_error("Vec needs an element type: Vec[T]()");
+    }
+    if (node->arguments.size() > 1) {
+        throw std::runtime_error("Vec[T]() takes at most one argument, the capacity");
+    }
+    std::string vecType = VecTypeNode::cTypeFor(node->typeArguments[0]->toCType());
+    if (node->arguments.empty()) {
+        output << "((" << vecType << "){0})";
+        return;
+    }
+    output << vecType << "_new(";
+    generate(node->arguments[0].get());
+    emit(")");
+}
+
+void ExprGenerator::generateVecMethod(MethodCallNode* node, const std::string& vecType, bool throughPointer) {
+    static const Symbol push("push"), pop("pop"), reserve("reserve"), clear("clear"), release("release");
+    
+    size_t arity = node->methodName == push || node->methodName == reserve ? 1 : 0;
+    bool known = node->methodName == push || node->methodName == pop || node->methodName == reserve ||
+                 node->methodName == clear || node->methodName == release;
+    if (!known) {
+        throw std::runtime_error("Unknown Vec method: " + node->methodName.str());
+    }
+    if (node->arguments.size() != arity || node->typeArgument) {
+        throw std::runtime_error("Vec " + node->methodName.str() + "() takes " +
+                                 (arity ? "one argument" : "no arguments"));
+    }
+    
+    output << vecType << "_" << node->methodName.str() << "(";
+    if (!throughPointer) {
+        emit("&");
+    }
+    emit("(");
+    if (throughPointer) {
+        generate(node->receiver.get());
+    } else {
+        generateTarget(node->receiver.get()); // every method may change it
+    }
+    emit(")");
     for (auto& arg : node->arguments) {
         emit(", ");
         generate(arg.get());
     }
+    emit(")");
+}
+
+void ExprGenerator::generateMapCall(CallNode* node) {
+    // Map[K, V]() starts empty without allocating; Map[K, V](n) makes room for n entries
+    if (node->typeArguments.size() != 2) {
+        throw std::runtime_error("Map needs a key and a value type: Map[K, V]()");
+    }
+    if (node->arguments.size() > 1) {
+        throw std::runtime_error("Map[K, V]() takes at most one argument, the capacity");
+    }
+    std::string mapType = MapTypeNode::cTypeFor(node->typeArguments[0]->toCType(), node->typeArguments[1]->toCType());
+    if (node->arguments.empty()) {
+        output << "((" << mapType << "){0})";
+        return;
+    }
+    output << mapType << "_new(";
+    generate(node->arguments[0].get());
+    emit(")");
+}
+
+bool ExprGenerator::generateMapUpdate(BinaryOpNode* node) {
+    // m[k] = m[k] + e looks the key up once, as (*slot) += e. The operators
+    // have C compound forms that mean the same; e must not insert into the
+    // Map while the slot pointer is held.
+    auto* target = nodeCast<IndexNode>(node->left.get());
+    auto* update = nodeCast<BinaryOpNode>(node->right.get());
+    if (!target || !update || !typeRegistry) {
+        return false;
+    }
+    static const char* const operators[] = {"+", "-", "*", "/", "%"};
+    bool compound = false;
+    for (const char* op : operators) {
+        compound = compound || update->op == op;
+    }
+    auto* read = nodeCast<IndexNode>(update->left.get());
+    if (!compound || !read || !sameOperand(target->array.get(), read->array.get()) ||
+        !sameOperand(target->index.get(), read->index.get()) || !isPlainRead(update->right.get())) {
+        return false;
+    }
+    const MapInfo* map = typeRegistry->getMap(typeOf(target->array.get()));
+    if (!map || findVectorType(map->valueType)) {
+        return false; // vectors may be structs without compound operators
+    }
     
+    emit("(");
+    generateTarget(target);
+    output << " " << update->op << "= ";
+    generate(update->right.get());
     emit(")");
+    return true;
 }
 
-void ExprGenerator::generateUnionInit(UnionInitNode* node) {
-    emit("(union " + node->unionName + "){." + node->activeMember + " = ");
-    generate(node->value.get());
-    emit("}");
+void ExprGenerator::generateMapIndex(IndexNode* node, const MapInfo& map) {
+    // A read copies the value out, so it stays valid when an insert in the
+    // same expression grows the Map. A target is the element in place.
+    if (isTarget) {
+        output << "(*" << map.name << "_slot(&(";
+        visit(node->array.get());
+        emit("), ");
+        generate(node->index.get());
+        emit("))");
+        return;
+    }
+    output << map.name << "_get(";
+    generateMapAddress(node->array.get());
+    emit(", ");
+    generate(node->index.get());
+    emit(")");
+}
+
+bool ExprGenerator::readsMapElement(ExprNode* node) {
+    if (isTarget || !typeRegistry) {
+        return false;
+    }
+    if (auto* index = nodeCast<IndexNode>(node)) {
+        return typeRegistry->getMap(typeOf(index->array.get())) != nullptr;
+    }
+    if (auto* fieldAccess = nodeCast<FieldAccessNode>(node)) {
+        std::string objectType = typeOf(fieldAccess->object.get());
+        return (objectType.empty() || objectType.back() != '*') && readsMapElement(fieldAccess->object.get());
+    }
+    return false;
+}
+
+void ExprGenerator::generateMapAddress(ExprNode* node) {
+    // A Map read out of another Map has no address as a value, so it is
+    // reached in place, e.g. the inner Map of m[a][b]
+    if (!readsMapElement(node)) {
+        emit("&(");
+        visit(node);
+        emit(")");
+        return;
+    }
+    if (auto* index = nodeCast<IndexNode>(node)) {
+        output << typeRegistry->getMap(typeOf(index->array.get()))->name << "_at(";
+        generateMapAddress(index->array.get());
+        emit(", ");
+        generate(index->index.get());
+        emit(")");
+        return;
+    }
+    auto* fieldAccess = nodeCast<FieldAccessNode>(node);
+    emit("&((");
+    generateMapAddress(fieldAccess->object.get());
+    output << ")->" << fieldAccess->fieldName << ")";
 }
 
+void ExprGenerator::generateMapMethod(MethodCallNode* node, const MapInfo& map, bool throughPointer) {
+    static const Symbol has("has"), remove("remove"), reserve("reserve"), clear("clear"), release("release");
+    
+    size_t arity = node->methodName == clear || node->methodName == release ? 0 : 1;
+    bool known = node->methodName == has || node->methodName == remove || node->methodName == reserve ||
+                 node->methodName == clear || node->methodName == release;
+    if (!known) {
+        throw std::runtime_error("Unknown Map method: " + node->methodName.str());
+    }
+    if (node->arguments.size() != arity || node->typeArgument) {
+        throw std::runtime_error("Map " + node->methodName.str() + "() takes " +
+                                 (arity ? "one argument" : "no arguments"));
+    }
+    
+    output << map.name << "_" << node->methodName.str() << "(";
+    if (throughPointer) {
+        emit("(");
+        generate(node->receiver.get());
+        emit(")");
+    } else if (node->methodName == has) {
+        generateMapAddress(node->receiver.get());
+    } else {
+        emit("&(");
+        generateTarget(node->receiver.get());
+        emit(")");
+    }
+    for (auto& arg : node->arguments) {
+        emit(", ");
+        generate(arg.get());
+    }
+    emit(")");
+}
@@ -2,39 +2,89 @@
 #include "base.h"
 #include "symbol_table.h"
 #include "../ast.h"
+#include "../ast_visitor.h"
 #include "../type_registry.h"
+#include "../vector_types.h"
 
-class ExprGenerator : public CodeGenBase {
+class ExprGenerator : public CodeGenBase, public ExprVisitor<ExprGenerator> {
 private:
+    friend class ExprVisitor<ExprGenerator>;
+    
     SymbolTable* symbolTable;
     TypeRegistry* typeRegistry;
+    bool isTarget; // generating what is assigned to or modified, see generateTarget
+    std::unordered_set<Symbol> sharedRoots; // reached by an array argument of the current call
     
 public:
-    ExprGenerator(std::stringstream& out, int& indent) 
-        : CodeGenBase(out, indent), symbolTable(nullptr), typeRegistry(nullptr) {}
+    ExprGenerator(OutputBuffer& out, int& indent) 
+        : CodeGenBase(out, indent), symbolTable(nullptr), typeRegistry(nullptr), isTarget(false) {}
+    
+    ExprGenerator(OutputBuffer& out, int& indent, SymbolTable* symbols, TypeRegistry* types = nullptr) 
+        : CodeGenBase(out, indent), symbolTable(symbols), typeRegistry(types), isTarget(false) {}
     
-    ExprGenerator(std::stringstream& out, int& indent, SymbolTable* symbols, TypeRegistry* types = nullptr) 
-        : CodeGenBase(out, indent), symbolTable(symbols), typeRegistry(types) {}
+    void generate(ExprNode* node) { generateAs(node, false); }
     
-    void generate(ExprNode* node);
+    // An expression that is assigned to, has its address taken or is
+    // modified by a method. Map elements there insert their key, while
+    // reading one does not, e.g. m[k] = m[j] + 1. Index and field access
+    // pass this on to the expression they start from.
+    void generateTarget(ExprNode* node) { generateAs(node, true); }
     
 private:
-    void generateIntLiteral(IntLiteralNode* node);
-    void generateLongLiteral(LongLiteralNode* node);
-    void generateFloatLiteral(FloatLiteralNode* node);
-    void generateDoubleLiteral(DoubleLiteralNode* node);
-    void generateStringLiteral(StringLiteralNode* node);
-    void generateBoolLiteral(BoolLiteralNode* node);
-    void generateIdentifier(IdentifierNode* node);
-    void generateArrayLiteral(ArrayLiteralNode* node);
-    void generateIndex(IndexNode* node);
-    void generateBinaryOp(BinaryOpNode* node);
-    void generateUnaryOp(UnaryOpNode* node);
-    void generateCall(CallNode* node);
-    void generateAddressOf(AddressOfNode* node);
-    void generateDereference(DereferenceNode* node);
-    void generateFieldAccess(FieldAccessNode* node);
-    void generateStructInit(StructInitNode* node);
-    void generateUnionInit(UnionInitNode* node);
-    void generateMethodCall(MethodCallNode* node);
+    void visitIntLiteral(IntLiteralNode* node);
+    void visitLongLiteral(LongLiteralNode* node);
+    void visitFloatLiteral(FloatLiteralNode* node);
+    void visitDoubleLiteral(DoubleLiteralNode* node);
+    void visitStringLiteral(StringLiteralNode* node);
+    void visitBoolLiteral(BoolLiteralNode* node);
+    void visitIdentifier(IdentifierNode* node);
+    void visitArrayLiteral(ArrayLiteralNode* node);
+    void visitIndex(IndexNode* node);
+    void visitBinaryOp(BinaryOpNode* node);
+    void visitUnaryOp(UnaryOpNode* node);
+    void visitCall(CallNode* node);
+    void visitAddressOf(AddressOfNode* node);
+    void visitDereference(DereferenceNode* node);
+    void visitFieldAccess(FieldAccessNode* node);
+    void visitStructInit(StructInitNode* node);
+    void visitUnionInit(UnionInitNode* node);
+    void visitMethodCall(MethodCallNode* node);
+    
+    // Helpers
+    void generateAs(ExprNode* node, bool target);
+    std::string typeOf(ExprNode* node);
+    void generateArguments(const std::vector<ExprNodePtr>& arguments,
+                           const std::vector<std::string>* parameterTypes, bool leadingComma);
+    void generateSliceArgument(ExprNode* node, const std::string& sliceType, const std::string& elementType);
+    
+    // Argument for a `const struct X*` parameter: its address when nothing
+    // else can reach it during the call, otherwise the address of a copy
+    std::unordered_set<Symbol> collectSharedRoots(const std::vector<ExprNodePtr>& arguments);
+    bool isBorrowable(ExprNode* node);
+    void generateReadOnlyReference(ExprNode* node, const std::string& structType);
+    
+    // SIMD vectors: elementwise operators and vector builtins. Both return
+    // false when the node does not involve a vector.
+    bool generateVectorOp(BinaryOpNode* node);
+    bool generateVectorBuiltin(CallNode* node);
+    void generateElementAddress(ExprNode* array, ExprNode* index, const VectorType& vector);
+    
+    // print(a, b, ...) lowered to the print runtime, see BuiltinGenerator
+    void generatePrint(CallNode* node);
+    
+    // Arena construction and methods, lowered to the peach_arena runtime
+    void generateArenaCall(CallNode* node);
+    void generateArenaMethod(MethodCallNode* node, bool throughPointer);
+    
+    // Vec construction and methods, lowered to the functions of its C type
+    void generateVecCall(CallNode* node);
+    void generateVecMethod(MethodCallNode* node, const std::string& vecType, bool throughPointer);
+    
+    // Map construction, element access and methods, likewise
+    void generateMapCall(CallNode* node);
+    void generateMapIndex(IndexNode* node, const MapInfo& map);
+    bool generateMapUpdate(BinaryOpNode* node); // false when the assignment is not m[k] = m[k] op e
+    bool readsMapElement(ExprNode* node);
+    void generateMapAddress(ExprNode* node); // `const M*` for a Map expression that is read
+    void generateMapMethod(MethodCallNode* node, const MapInfo& map, bool throughPointer);
 };
\ No newline at end of file
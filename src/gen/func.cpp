@@ -3,12 +3,34 @@
 #include "symbol_table.h"
 
 void FuncGenerator::generate(FunctionNode* node) {
+    markFunctionStart();
     generateSignature(node);
     emit(" ");
     generateBody(node);
 }
 
+void FuncGenerator::generatePrototype(FunctionNode* node) {
+    generateSignature(node);
+    emit(";\n");
+}
+
+void FuncGenerator::generateSpecifiers(FunctionNode* node) {
+    static const Symbol main("main");
+    if (node->isInline && !(wholeProgram && node->isExported)) {
+        emit("PEACH_INLINE "); // carries its own linkage
+        return;
+    }
+    if (wholeProgram && node->name != main && !node->isExported) {
+        emit("static ");
+    }
+    if (node->inlineHint == InlineHint::Never) {
+        emit("PEACH_NOINLINE ");
+    }
+}
+
 void FuncGenerator::generateSignature(FunctionNode* node) {
+    generateSpecifiers(node);
+    
     // Generate return type
     if (node->returnType) {
         emit(node->returnType->toCType());
@@ -29,45 +51,52 @@ void FuncGenerator::generateSignature(FunctionNode* node) {
     emit(")");
 }
 
-void FuncGenerator::generateParameters(const std::vector<std::pair<std::string, TypeNodePtr>>& params) {
+void FuncGenerator::generateParameters(const std::vector<std::pair<Symbol, TypeNodePtr>>& params) {
     if (params.empty()) {
         emit("void");
     } else {
+        TypeGenerator typeGen(output, indentLevel);
         for (size_t i = 0; i < params.size(); i++) {
             if (i > 0) emit(", ");
-            std::string paramType = params[i].second->toCType();
-            // Convert array parameters to pointer parameters for C compatibility
-            if (paramType.find("[") != std::string::npos) {
-                // Extract element type from array type like "[5]int" -> "int*"
-                size_t closeBracketPos = paramType.find("]");
-                if (closeBracketPos != std::string::npos) {
-                    std::string elementType = paramType.substr(closeBracketPos + 1);
-                    paramType = elementType + "*";
-                }
-            }
-            emit(paramType);
-            emit(" ");
-            emit(params[i].first);
+            emit(typeGen.generateParameterDeclaration(params[i].second.get(), params[i].first.str()));
         }
     }
 }
 
-void FuncGenerator::generateBody(FunctionNode* node) {
+void FuncGenerator::generateBody(FunctionNode* node, const std::string& receiverType) {
     // Create symbol table for function scope
     SymbolTable functionScope;
+    if (!receiverType.empty()) {
+        static const Symbol self("self");
+        functionScope.addSymbol(self, receiverType);
+        if (node->receiverByReference) {
+            functionScope.addAlias(self, "(*self)");
+        }
+    }
     
-    // Add parameters to symbol table
+    // Add parameters to symbol table. Read-only struct parameters arrive
+    // as pointers but keep their struct type.
+    TypeGenerator typeGen(output, indentLevel);
     for (const auto& param : node->parameters) {
-        functionScope.addSymbol(param.first, param.second->toCType());
+        functionScope.addSymbol(param.first, typeGen.declaredType(param.second.get()));
+        auto* structType = nodeCast<StructTypeNode>(param.second.get());
+        if (structType && structType->isReadOnlyReference) {
+            functionScope.addAlias(param.first, "(*" + param.first.str() + ")");
+        }
+    }
+    for (Symbol name : node->addressTaken) {
+        functionScope.markAddressTaken(name);
     }
     
     // Create statement generator with function scope
     StmtGenerator stmtGen(output, indentLevel, typeRegistry);
     stmtGen.setCurrentScope(&functionScope);
+    HoistPoint hoist{&output, functionStart, &parallelLoopCount};
+    stmtGen.setHoistPoint(&hoist);
     
-    if (dynamic_cast<BlockNode*>(node->body.get())) {
+    if (nodeCast<BlockNode>(node->body.get())) {
         stmtGen.generate(node->body.get());
-    } else if (auto* exprStmt = dynamic_cast<ExprStmtNode*>(node->body.get())) {
+    } else if (auto* exprStmt = nodeCast<ExprStmtNode>(node->body.get())) {
         // Single expression body - wrap in block with return
         emitLine("{");
         indentLevel++;
@@ -82,7 +111,7 @@ void FuncGenerator::generateBody(FunctionNode* node) {
         if (returnType != "void") {
             indent();
             emit("return ");
-            ExprGenerator exprGen(output, indentLevel);
+            ExprGenerator exprGen(output, indentLevel, &functionScope, typeRegistry);
             exprGen.generate(exprStmt->expr.get());
             emit(";\n");
         } else {
@@ -96,32 +125,33 @@ void FuncGenerator::generateBody(FunctionNode* node) {
 }
 
 std::string FuncGenerator::inferReturnType(StmtNode* body) {
-    std::vector<std::pair<std::string, TypeNodePtr>> emptyParams;
+    std::vector<std::pair<Symbol, TypeNodePtr>> emptyParams;
     return inferReturnTypeWithContext(body, emptyParams);
 }
 
-std::string FuncGenerator::inferReturnTypeWithContext(StmtNode* body, const std::vector<std::pair<std::string, TypeNodePtr>>& parameters) {
+std::string FuncGenerator::inferReturnTypeWithContext(StmtNode* body, const std::vector<std::pair<Symbol, TypeNodePtr>>& parameters) {
     // Create symbol table with function parameters
     SymbolTable symbolTable;
+    TypeGenerator paramTypes(output, indentLevel);
     for (const auto& param : parameters) {
-        symbolTable.addSymbol(param.first, param.second->toCType());
+        symbolTable.addSymbol(param.first, paramTypes.declaredType(param.second.get()));
     }
     
     // Handle expression statements (single expression functions)
-    if (auto* exprStmt = dynamic_cast<ExprStmtNode*>(body)) {
-        TypeGenerator typeGen(output, indentLevel, &symbolTable);
+    if (auto* exprStmt = nodeCast<ExprStmtNode>(body)) {
+        TypeGenerator typeGen(output, indentLevel, &symbolTable, typeRegistry);
         return typeGen.inferType(exprStmt->expr.get());
     }
     
     // Handle block statements
-    if (auto* block = dynamic_cast<BlockNode*>(body)) {
+    if (auto* block = nodeCast<BlockNode>(body)) {
         std::string returnType = "void"; // Default
         
         // Look for return statements in the block
         for (const auto& stmt : block->statements) {
-            if (auto* returnStmt = dynamic_cast<ReturnNode*>(stmt.get())) {
+            if (auto* returnStmt = nodeCast<ReturnNode>(stmt.get())) {
                 if (returnStmt->value) {
-                    TypeGenerator typeGen(output, indentLevel, &symbolTable);
+                    TypeGenerator typeGen(output, indentLevel, &symbolTable, typeRegistry);
                     return typeGen.inferType(returnStmt->value.get());
                 } else {
                     return "void";
@@ -129,7 +159,7 @@ std::string FuncGenerator::inferReturnTypeWithContext(StmtNode* body, const std:
             }
             
             // Recursively check nested blocks
-            if (auto* nestedBlock = dynamic_cast<BlockNode*>(stmt.get())) {
+            if (auto* nestedBlock = nodeCast<BlockNode>(stmt.get())) {
                 std::string nestedType = inferReturnType(nestedBlock);
                 if (nestedType != "void") {
                     returnType = nestedType;
@@ -137,7 +167,7 @@ std::string FuncGenerator::inferReturnTypeWithContext(StmtNode* body, const std:
             }
             
             // Check if statements
-            if (auto* ifStmt = dynamic_cast<IfNode*>(stmt.get())) {
+            if (auto* ifStmt = nodeCast<IfNode>(stmt.get())) {
                 std::string thenType = inferReturnType(ifStmt->thenBranch.get());
                 if (thenType != "void") {
                     returnType = thenType;
@@ -9,17 +9,31 @@
 class FuncGenerator : public CodeGenBase {
 private:
     TypeRegistry* typeRegistry;
+    size_t functionStart;  // output position of the function being generated
+    int parallelLoopCount; // workers hoisted so far
+    bool wholeProgram;     // functions other than main are static
     
 public:
-    FuncGenerator(std::stringstream& out, int& indent, TypeRegistry* types = nullptr) 
-        : CodeGenBase(out, indent), typeRegistry(types) {}
+    FuncGenerator(OutputBuffer& out, int& indent, TypeRegistry* types = nullptr) 
+        : CodeGenBase(out, indent), typeRegistry(types), functionStart(0), parallelLoopCount(0),
+          wholeProgram(false) {}
+    
+    void setWholeProgram(bool whole) { wholeProgram = whole; }
     
     void generate(FunctionNode* node);
-    void generateBody(FunctionNode* node);
+    void generatePrototype(FunctionNode* node);
+    
+    // Call before emitting a signature whose body comes from generateBody,
+    // parallel loop workers are inserted at this point
+    void markFunctionStart() { functionStart = output.size(); }
+    void generateBody(FunctionNode* node, const std::string& receiverType = "");
+    
+    // Linkage and inlining ahead of the signature, if any
+    void generateSpecifiers(FunctionNode* node);
     
 private:
     void generateSignature(FunctionNode* node);
-    void generateParameters(const std::vector<std::pair<std::string, TypeNodePtr>>& params);
+    void generateParameters(const std::vector<std::pair<Symbol, TypeNodePtr>>& params);
     std::string inferReturnType(StmtNode* body);
-    std::string inferReturnTypeWithContext(StmtNode* body, const std::vector<std::pair<std::string, TypeNodePtr>>& parameters);
+    std::string inferReturnTypeWithContext(StmtNode* body, const std::vector<std::pair<Symbol, TypeNodePtr>>& parameters);
 };
\ No newline at end of file
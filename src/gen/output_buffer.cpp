@@ -0,0 +1,125 @@
+#include "output_buffer.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <sys/uio.h>
+
+namespace {
+// Indentation is copied from here instead of being built four spaces at a time
+const std::string INDENT_SPACES(256, ' ');
+}
+
+OutputBuffer::OutputBuffer() : cursor(nullptr), limit(nullptr), fullChunkBytes(0) {}
+
+void OutputBuffer::grow() {
+    if (!chunks.empty()) {
+        fullChunkBytes += CHUNK_SIZE;
+    }
+    chunks.push_back(std::unique_ptr<char[]>(new char[CHUNK_SIZE]));
+    cursor = chunks.back().get();
+    limit = cursor + CHUNK_SIZE;
+}
+
+void OutputBuffer::appendSlow(std::string_view text) {
+    // Fill the current chunk, then continue in fresh ones
+    while (!text.empty()) {
+        if (cursor == limit) {
+            grow();
+        }
+        size_t count = std::min(text.size(), static_cast<size_t>(limit - cursor));
+        text.copy(cursor, count);
+        cursor += count;
+        text.remove_prefix(count);
+    }
+}
+
+void OutputBuffer::appendIndent(int level) {
+    size_t width = static_cast<size_t>(std::max(level, 0)) * 4;
+    while (width > 0) {
+        size_t count = std::min(width, INDENT_SPACES.size());
+        append(std::string_view(INDENT_SPACES.data(), count));
+        width -= count;
+    }
+}
+
+size_t OutputBuffer::size() const {
+    if (chunks.empty()) {
+        return 0;
+    }
+    return fullChunkBytes + (cursor - chunks.back().get());
+}
+
+void OutputBuffer::clear() {
+    chunks.clear();
+    cursor = nullptr;
+    limit = nullptr;
+    fullChunkBytes = 0;
+}
+
+void OutputBuffer::insert(size_t position, std::string_view text) {
+    // Save the tail, cut the buffer back to the position and re-append
+    std::string tail;
+    tail.reserve(size() - position);
+    for (size_t i = position / CHUNK_SIZE; i < chunks.size(); i++) {
+        size_t begin = (i == position / CHUNK_SIZE) ? position % CHUNK_SIZE : 0;
+        size_t length = (i + 1 == chunks.size()) ? cursor - chunks[i].get() : CHUNK_SIZE;
+        tail.append(chunks[i].get() + begin, length - begin);
+    }
+    
+    size_t chunkIndex = position / CHUNK_SIZE;
+    if (chunkIndex < chunks.size()) {
+        chunks.resize(chunkIndex + 1);
+        cursor = chunks.back().get() + position % CHUNK_SIZE;
+        limit = chunks.back().get() + CHUNK_SIZE;
+        fullChunkBytes = chunkIndex * CHUNK_SIZE;
+    }
+    
+    append(text);
+    append(std::string_view(tail));
+}
+
+std::string OutputBuffer::str() const {
+    std::string result;
+    result.reserve(size());
+    for (size_t i = 0; i < chunks.size(); i++) {
+        size_t length = (i + 1 == chunks.size()) ? cursor - chunks[i].get() : CHUNK_SIZE;
+        result.append(chunks[i].get(), length);
+    }
+    return result;
+}
+
+bool OutputBuffer::writeTo(int fd) const {
+    // Gather the chunks into iovecs and writev them in batches
+    std::vector<iovec> pending;
+    pending.reserve(chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++) {
+        size_t length = (i + 1 == chunks.size()) ? cursor - chunks[i].get() : CHUNK_SIZE;
+        if (length > 0) {
+            pending.push_back({chunks[i].get(), length});
+        }
+    }
+    
+    size_t next = 0;
+    while (next < pending.size()) {
+        int batch = static_cast<int>(std::min(pending.size() - next, static_cast<size_t>(IOV_MAX)));
+        ssize_t written = writev(fd, &pending[next], batch);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        
+        // Skip what was written, trimming a partially written iovec
+        size_t remaining = written;
+        while (next < pending.size() && remaining >= pending[next].iov_len) {
+            remaining -= pending[next].iov_len;
+            next++;
+        }
+        if (remaining > 0) {
+            pending[next].iov_base = static_cast<char*>(pending[next].iov_base) + remaining;
+            pending[next].iov_len -= remaining;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "../interner.h"
+
+// Append-only buffer for generated C. Text is copied into fixed-size chunks
+// that never move, so appending never reallocates or copies earlier output,
+// and the chunks can be written to a file descriptor as they are.
+class OutputBuffer {
+private:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+    
+    // Every chunk but the last is full
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char* cursor;
+    char* limit;
+    size_t fullChunkBytes; // bytes in full chunks
+    
+    void grow();
+    void appendSlow(std::string_view text);
+    
+public:
+    OutputBuffer();
+    
+    // Prevent copying, the buffer can be large
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+    
+    void append(std::string_view text) {
+        if (static_cast<size_t>(limit - cursor) >= text.size()) {
+            text.copy(cursor, text.size());
+            cursor += text.size();
+        } else {
+            appendSlow(text);
+        }
+    }
+    
+    void append(char c) {
+        if (cursor == limit) {
+            grow();
+        }
+        *cursor++ = c;
+    }
+    
+    // Append `level` levels of four-space indentation
+    void appendIndent(int level);
+    
+    OutputBuffer& operator<<(std::string_view text) { append(text); return *this; }
+    OutputBuffer& operator<<(const char* text) { append(std::string_view(text)); return *this; }
+    OutputBuffer& operator<<(const std::string& text) { append(std::string_view(text)); return *this; }
+    OutputBuffer& operator<<(Symbol symbol) { append(std::string_view(symbol.str())); return *this; }
+    OutputBuffer& operator<<(char c) { append(c); return *this; }
+    
+    template<typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, char>>>
+    OutputBuffer& operator<<(T value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        append(std::string_view(digits, result.ptr - digits));
+        return *this;
+    }
+    
+    size_t size() const;
+    void clear();
+    
+    // Insert text at an earlier position. Everything after it is copied,
+    // so this is meant for positions close to the end.
+    void insert(size_t position, std::string_view text);
+    
+    // Copy out as one string (tests, small outputs)
+    std::string str() const;
+    
+    // Write everything to fd, handling short writes. Returns false on error.
+    bool writeTo(int fd) const;
+};
@@ -1,30 +1,145 @@
 #include "stmt.h"
 #include "type.h"
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
 
-void StmtGenerator::generate(StmtNode* node) {
-    if (auto* varDecl = dynamic_cast<VarDeclNode*>(node)) {
-        generateVarDecl(varDecl);
-    } else if (auto* block = dynamic_cast<BlockNode*>(node)) {
-        generateBlock(block);
-    } else if (auto* ifNode = dynamic_cast<IfNode*>(node)) {
-        generateIf(ifNode);
-    } else if (auto* whileNode = dynamic_cast<WhileNode*>(node)) {
-        generateWhile(whileNode);
-    } else if (auto* forNode = dynamic_cast<ForNode*>(node)) {
-        generateFor(forNode);
-    } else if (auto* returnNode = dynamic_cast<ReturnNode*>(node)) {
-        generateReturn(returnNode);
-        emit(";\n");
-    } else if (auto* exprStmt = dynamic_cast<ExprStmtNode*>(node)) {
-        generateExprStmt(exprStmt);
+namespace {
+
+// Names a parallel loop body reads or writes, and the ones it declares itself
+class CaptureCollector : public ExprVisitor<CaptureCollector>, public StmtVisitor<CaptureCollector> {
+private:
+    friend class ExprVisitor<CaptureCollector>;
+    friend class StmtVisitor<CaptureCollector>;
+    
+    std::unordered_set<Symbol> seen;
+    
+    void reference(Symbol name) {
+        if (seen.insert(name).second) {
+            referenced.push_back(name);
+        }
+    }
+    
+    void visitIdentifier(IdentifierNode* node) { reference(node->name); }
+    void visitBinaryOp(BinaryOpNode* node) {
+        ExprVisitor::visit(node->left.get());
+        ExprVisitor::visit(node->right.get());
+    }
+    void visitUnaryOp(UnaryOpNode* node) { ExprVisitor::visit(node->operand.get()); }
+    void visitArrayLiteral(ArrayLiteralNode* node) {
+        for (auto& element : node->elements) {
+            ExprVisitor::visit(element.get());
+        }
+    }
+    void visitIndex(IndexNode* node) {
+        ExprVisitor::visit(node->array.get());
+        ExprVisitor::visit(node->index.get());
+    }
+    void visitCall(CallNode* node) {
+        for (auto& arg : node->arguments) {
+            ExprVisitor::visit(arg.get());
+        }
+    }
+    void visitAddressOf(AddressOfNode* node) { ExprVisitor::visit(node->operand.get()); }
+    void visitDereference(DereferenceNode* node) { ExprVisitor::visit(node->operand.get()); }
+    void visitFieldAccess(FieldAccessNode* node) { ExprVisitor::visit(node->object.get()); }
+    void visitStructInit(StructInitNode* node) {
+        for (auto& field : node->fields) {
+            ExprVisitor::visit(field.second.get());
+        }
+    }
+    void visitUnionInit(UnionInitNode* node) { ExprVisitor::visit(node->value.get()); }
+    void visitMethodCall(MethodCallNode* node) {
+        ExprVisitor::visit(node->receiver.get());
+        for (auto& arg : node->arguments) {
+            ExprVisitor::visit(arg.get());
+        }
+    }
+    
+    void visitExprStmt(ExprStmtNode* node) { ExprVisitor::visit(node->expr.get()); }
+    void visitVarDecl(VarDeclNode* node) {
+        if (node->initializer) {
+            ExprVisitor::visit(node->initializer.get());
+        }
+        declared.insert(node->name);
+    }
+    void visitAssignment(AssignmentNode* node) {
+        ExprVisitor::visit(node->target.get());
+        ExprVisitor::visit(node->value.get());
+    }
+    void visitBlock(BlockNode* node) {
+        for (auto& stmt : node->statements) {
+            StmtVisitor::visit(stmt.get());
+        }
+    }
+    void visitReturn(ReturnNode* node) {
+        hasReturn = true;
+        if (node->value) {
+            ExprVisitor::visit(node->value.get());
+        }
+    }
+    void visitIf(IfNode* node) {
+        ExprVisitor::visit(node->condition.get());
+        StmtVisitor::visit(node->thenBranch.get());
+        if (node->elseBranch) {
+            StmtVisitor::visit(node->elseBranch.get());
+        }
     }
+    void visitWhile(WhileNode* node) {
+        ExprVisitor::visit(node->condition.get());
+        StmtVisitor::visit(node->body.get());
+    }
+    void visitFor(ForNode* node) {
+        ExprVisitor::visit(node->collection.get());
+        for (const auto& reduction : node->reductions) {
+            reference(reduction.variable);
+        }
+        declared.insert(node->iteratorName);
+        StmtVisitor::visit(node->body.get());
+    }
+    
+public:
+    std::vector<Symbol> referenced; // in order of first use
+    std::unordered_set<Symbol> declared;
+    bool hasReturn = false;
+    
+    void collect(StmtNode* body) { StmtVisitor::visit(body); }
+};
+
+// Value a reduction starts from
+std::string reductionIdentity(const std::string& op, const std::string& type) {
+    bool isFloating = type == "double" || type == "float";
+    bool isLong = type == "long";
+    if (op == "+") {
+        return "0";
+    }
+    if (op == "*") {
+        return "1";
+    }
+    if (op == "min") {
+        return isFloating ? "INFINITY" : isLong ? "LONG_MAX" : "INT_MAX";
+    }
+    return isFloating ? "-INFINITY" : isLong ? "LONG_MIN" : "INT_MIN";
+}
+
+// Statement folding `other` into `target`
+std::string reductionCombine(const std::string& op, const std::string& target, const std::string& other) {
+    if (op == "min") {
+        return target + " = " + other + " < " + target + " ? " + other + " : " + target + ";";
+    }
+    if (op == "max") {
+        return target + " = " + other + " > " + target + " ? " + other + " : " + target + ";";
+    }
+    return target + " = " + target + " " + op + " " + other + ";";
 }
 
-void StmtGenerator::generateVarDecl(VarDeclNode* node) {
+} // namespace
+
+void StmtGenerator::visitVarDecl(VarDeclNode* node) {
     indent();
     
     // Handle array types specially (const arrays cause issues with pointer passing)
-    if (auto* arrayType = dynamic_cast<ArrayTypeNode*>(node->type.get())) {
+    if (auto* arrayType = nodeCast<ArrayTypeNode>(node->type.get())) {
         TypeGenerator typeGen(output, indentLevel);
         std::string decl = typeGen.generateArrayDeclaration(arrayType, node->name, node->initializer.get());
         emit(decl);
@@ -41,19 +156,19 @@ void StmtGenerator::generateVarDecl(VarDeclNode* node) {
         TypeGenerator typeGen(output, indentLevel, nullptr, typeRegistry);
         std::string inferredType = typeGen.inferType(node->initializer.get());
         
-        if (auto* arrayLit = dynamic_cast<ArrayLiteralNode*>(node->initializer.get())) {
+        if (auto* arrayLit = nodeCast<ArrayLiteralNode>(node->initializer.get())) {
             // For array literals, don't use const to avoid pointer passing issues
             int size = arrayLit->elements.size();
-            emit(inferredType + " " + node->name + "[" + std::to_string(size) + "]");
+            output << inferredType << " " << node->name << "[" << size << "]";
         } else {
             // Generate const for non-array types
             if (node->isConst) {
                 emit("const ");
             }
-            emit(inferredType + " " + node->name);
+            output << inferredType << " " << node->name;
         }
     } else {
-        emit("int " + node->name); // Default type
+        output << "int " << node->name; // Default type
     }
     
     if (node->initializer) {
@@ -62,28 +177,40 @@ void StmtGenerator::generateVarDecl(VarDeclNode* node) {
         // Create expression generator with current scope
         ExprGenerator exprGen(output, indentLevel, currentScope, typeRegistry);
         exprGen.generate(node->initializer.get());
-        
-        // Register variable type in current scope and type registry
-        std::string varType;
-        if (node->type) {
-            varType = node->type->toCType();
-        } else {
-            // Infer type from initializer
-            TypeGenerator typeGen(output, indentLevel, currentScope, typeRegistry);
-            varType = typeGen.inferType(node->initializer.get());
-        }
-        
-        if (currentScope && !varType.empty()) {
-            currentScope->addSymbol(node->name, varType);
-        }
-        if (typeRegistry && !varType.empty()) {
-            typeRegistry->registerVariable(node->name, varType);
-        }
+    } else if (nodeCast<VecTypeNode>(node->type.get()) || nodeCast<MapTypeNode>(node->type.get())) {
+        emit(" = {0}"); // an empty Vec or Map
     }
     emit(";\n");
+    
+    // Register variable type in current scope and type registry. The scope
+    // keeps the bound of sized arrays, e.g. "int[4]".
+    std::string varType;
+    std::string scopeType;
+    if (node->type) {
+        TypeGenerator typeGen(output, indentLevel);
+        varType = node->type->toCType();
+        scopeType = typeGen.declaredType(node->type.get());
+    } else if (node->initializer) {
+        // Infer type from initializer
+        TypeGenerator typeGen(output, indentLevel, currentScope, typeRegistry);
+        varType = typeGen.inferType(node->initializer.get());
+        scopeType = varType;
+        if (auto* arrayLit = nodeCast<ArrayLiteralNode>(node->initializer.get())) {
+            scopeType += "[" + std::to_string(arrayLit->elements.size()) + "]";
+        }
+    } else {
+        varType = scopeType = "int";
+    }
+    
+    if (currentScope) {
+        currentScope->addSymbol(node->name, scopeType);
+    }
+    if (typeRegistry && node->initializer && !varType.empty()) {
+        typeRegistry->registerVariable(node->name, varType);
+    }
 }
 
-void StmtGenerator::generateBlock(BlockNode* node) {
+void StmtGenerator::visitBlock(BlockNode* node) {
     emitLine("{");
     indentLevel++;
     
@@ -96,23 +223,20 @@ void StmtGenerator::generateBlock(BlockNode* node) {
     emitLine("}");
 }
 
-void StmtGenerator::generateIf(IfNode* node) {
+void StmtGenerator::visitIf(IfNode* node) {
     indent();
     emit("if (");
     ExprGenerator exprGen(output, indentLevel, currentScope, typeRegistry);
     exprGen.generate(node->condition.get());
     emit(") ");
     
-    if (dynamic_cast<BlockNode*>(node->thenBranch.get())) {
+    if (nodeCast<BlockNode>(node->thenBranch.get())) {
         emit("\n");
         generate(node->thenBranch.get());
     } else {
         emit("{\n");
         indentLevel++;
         generate(node->thenBranch.get());
-        if (dynamic_cast<ExprStmtNode*>(node->thenBranch.get())) {
-            emit(";\n");
-        }
         indentLevel--;
         emitLine("}");
     }
@@ -120,54 +244,70 @@ void StmtGenerator::generateIf(IfNode* node) {
     if (node->elseBranch) {
         indent();
         emit("else ");
-        if (dynamic_cast<BlockNode*>(node->elseBranch.get()) || 
-            dynamic_cast<IfNode*>(node->elseBranch.get())) {
+        if (nodeCast<BlockNode>(node->elseBranch.get()) || 
+            nodeCast<IfNode>(node->elseBranch.get())) {
             emit("\n");
             generate(node->elseBranch.get());
         } else {
             emit("{\n");
             indentLevel++;
             generate(node->elseBranch.get());
-            if (dynamic_cast<ExprStmtNode*>(node->elseBranch.get())) {
-                emit(";\n");
-            }
             indentLevel--;
             emitLine("}");
         }
     }
 }
 
-void StmtGenerator::generateWhile(WhileNode* node) {
+void StmtGenerator::visitWhile(WhileNode* node) {
     indent();
     emit("while (");
     ExprGenerator exprGen(output, indentLevel, currentScope, typeRegistry);
     exprGen.generate(node->condition.get());
     emit(") ");
     
-    if (dynamic_cast<BlockNode*>(node->body.get())) {
+    if (nodeCast<BlockNode>(node->body.get())) {
         emit("\n");
         generate(node->body.get());
     } else {
         emit("{\n");
         indentLevel++;
         generate(node->body.get());
-        if (dynamic_cast<ExprStmtNode*>(node->body.get())) {
-            emit(";\n");
-        }
         indentLevel--;
         emitLine("}");
     }
 }
 
-void StmtGenerator::generateFor(ForNode* node) {
+void StmtGenerator::visitFor(ForNode* node) {
     // Check if it's a range-based for loop
-    if (auto* call = dynamic_cast<CallNode*>(node->collection.get())) {
-        if (call->functionName == "range") {
+    static const Symbol range("range");
+    
+    if (node->isParallel) {
+        generateParallelFor(node);
+        return;
+    }
+    
+    if (auto* call = nodeCast<CallNode>(node->collection.get())) {
+        if (call->functionName == range) {
             generateForRange(node, call);
             return;
         }
     }
     
+    // Vecs know their length and element type, Maps their keys
+    if (typeRegistry) {
+        TypeGenerator typeGen(output, indentLevel, currentScope, typeRegistry);
+        std::string collectionType = typeGen.inferType(node->collection.get());
+        std::string elementType = typeRegistry->getVecElementType(collectionType);
+        if (!elementType.empty()) {
+            generateForVec(node, elementType);
+            return;
+        }
+        if (const MapInfo* map = typeRegistry->getMap(collectionType)) {
+            generateForMap(node, *map);
+            return;
+        }
+    }
+    
     // Otherwise, it's an array iteration
     generateForArray(node);
 }
@@ -177,36 +317,32 @@ void StmtGenerator::generateForRange(ForNode* node, CallNode* rangeCall) {
     ExprGenerator exprGen(output, indentLevel, currentScope, typeRegistry);
     
     if (rangeCall->arguments.size() == 1) {
-        emit("for (int " + node->iteratorName + " = 0; " + 
-             node->iteratorName + " < ");
+        output << "for (int " << node->iteratorName << " = 0; " << node->iteratorName << " < ";
         exprGen.generate(rangeCall->arguments[0].get());
-        emit("; " + node->iteratorName + "++)");
+        output << "; " << node->iteratorName << "++)";
     } else if (rangeCall->arguments.size() == 2) {
-        emit("for (int " + node->iteratorName + " = ");
+        output << "for (int " << node->iteratorName << " = ";
         exprGen.generate(rangeCall->arguments[0].get());
-        emit("; " + node->iteratorName + " < ");
+        output << "; " << node->iteratorName << " < ";
         exprGen.generate(rangeCall->arguments[1].get());
-        emit("; " + node->iteratorName + "++)");
+        output << "; " << node->iteratorName << "++)";
     } else if (rangeCall->arguments.size() == 3) {
-        emit("for (int " + node->iteratorName + " = ");
+        output << "for (int " << node->iteratorName << " = ";
         exprGen.generate(rangeCall->arguments[0].get());
-        emit("; " + node->iteratorName + " < ");
+        output << "; " << node->iteratorName << " < ";
         exprGen.generate(rangeCall->arguments[1].get());
-        emit("; " + node->iteratorName + " += ");
+        output << "; " << node->iteratorName << " += ";
         exprGen.generate(rangeCall->arguments[2].get());
         emit(")");
     }
     
-    if (dynamic_cast<BlockNode*>(node->body.get())) {
+    if (nodeCast<BlockNode>(node->body.get())) {
         emit(" \n");
         generate(node->body.get());
     } else {
         emit(" {\n");
         indentLevel++;
         generate(node->body.get());
-        if (dynamic_cast<ExprStmtNode*>(node->body.get())) {
-            emit(";\n");
-        }
         indentLevel--;
         emitLine("}");
     }
@@ -217,12 +353,12 @@ void StmtGenerator::generateForArray(ForNode* node) {
     ExprGenerator exprGen(output, indentLevel, currentScope, typeRegistry);
     
     // Check if the collection is an identifier (array variable)
-    std::string arrayName;
+    Symbol arrayName;
     std::string arrayType;
     int arraySize = -1;
     bool isPointerParam = false;
     
-    if (auto* ident = dynamic_cast<IdentifierNode*>(node->collection.get())) {
+    if (auto* ident = nodeCast<IdentifierNode>(node->collection.get())) {
         arrayName = ident->name;
         // Look up array type and size from symbol table or type registry
         if (currentScope && currentScope->hasSymbol(arrayName)) {
@@ -231,20 +367,22 @@ void StmtGenerator::generateForArray(ForNode* node) {
             arrayType = typeRegistry->getVariableType(arrayName);
         }
         
-        // Check if it's a pointer parameter (int*) 
-        if (arrayType.find("*") != std::string::npos) {
-            isPointerParam = true;
-        } else if (arrayType.find("[") != std::string::npos) {
-            // Extract array size from type like "[5]int"
+        // Sized arrays are recorded as "T[N]"
+        if (!arrayType.empty() && arrayType.back() == ']') {
             size_t start = arrayType.find("[");
-            size_t end = arrayType.find("]");
-            if (end != std::string::npos) {
-                std::string sizeStr = arrayType.substr(start + 1, end - start - 1);
-                arraySize = std::stoi(sizeStr);
-            }
+            arraySize = std::stoi(arrayType.substr(start + 1));
+        } else if (arrayType.find("*") != std::string::npos) {
+            isPointerParam = true;
         }
     }
     
+    // Slices carry their length, iterate with the element type
+    std::string elementType = typeRegistry ? typeRegistry->getSliceElementType(arrayType) : "";
+    if (!elementType.empty()) {
+        generateForSlice(node, elementType);
+        return;
+    }
+    
     emit("// For-each loop for array\n");
     indent();
     
@@ -256,7 +394,7 @@ void StmtGenerator::generateForArray(ForNode* node) {
         emit("for (int _i = 0; _i < 1 /* UNKNOWN SIZE */; _i++) {\n");
     } else if (arraySize > 0) {
         // Use known array size
-        emit("for (int _i = 0; _i < " + std::to_string(arraySize) + "; _i++) {\n");
+        output << "for (int _i = 0; _i < " << arraySize << "; _i++) {\n";
     } else {
         // Fallback to sizeof approach (works for local arrays)
         emit("for (int _i = 0; _i < sizeof(");
@@ -266,33 +404,305 @@ void StmtGenerator::generateForArray(ForNode* node) {
         emit("[0]); _i++) {\n");
     }
     
+    // Sized one-dimensional arrays also know their element type
+    std::string iteratorType = "int";
+    if (arraySize > 0 && arrayType.find('[') == arrayType.rfind('[')) {
+        iteratorType = arrayType.substr(0, arrayType.find('['));
+    }
+    
     indentLevel++;
     indent();
-    emit("int " + node->iteratorName + " = ");
+    output << iteratorType << " " << node->iteratorName << " = ";
     exprGen.generate(node->collection.get());
     emit("[_i];\n");
     
-    if (auto* block = dynamic_cast<BlockNode*>(node->body.get())) {
+    if (auto* block = nodeCast<BlockNode>(node->body.get())) {
         // Extract statements from block without generating extra braces
         for (auto& stmt : block->statements) {
             generate(stmt.get());
-            if (dynamic_cast<VarDeclNode*>(stmt.get()) || 
-                dynamic_cast<ExprStmtNode*>(stmt.get())) {
-                emit(";\n");
-            }
         }
     } else {
         generate(node->body.get());
-        if (dynamic_cast<ExprStmtNode*>(node->body.get())) {
-            emit(";\n");
+    }
+    
+    indentLevel--;
+    emitLine("}");
+}
+
+void StmtGenerator::generateForSlice(ForNode* node, const std::string& elementType) {
+    ExprGenerator exprGen(output, indentLevel, currentScope, typeRegistry);
+    
+    emit("// For-each loop for slice\n");
+    indent();
+    emit("for (size_t _i = 0; _i < ");
+    exprGen.generate(node->collection.get());
+    emit(".len; _i++) {\n");
+    
+    indentLevel++;
+    indent();
+    output << elementType << " " << node->iteratorName << " = ";
+    exprGen.generate(node->collection.get());
+    emit(".ptr[_i];\n");
+    
+    // The element type lets method calls on the iterator resolve
+    if (currentScope) {
+        currentScope->addSymbol(node->iteratorName, elementType);
+    }
+    
+    if (auto* block = nodeCast<BlockNode>(node->body.get())) {
+        for (auto& stmt : block->statements) {
+            generate(stmt.get());
+        }
+    } else {
+        generate(node->body.get());
+    }
+    
+    indentLevel--;
+    emitLine("}");
+}
+
+void StmtGenerator::generateForVec(ForNode* node, const std::string& elementType) {
+    ExprGenerator exprGen(output, indentLevel, currentScope, typeRegistry);
+    
+    // The body may push, so the length and data are read on every iteration
+    indent();
+    emit("// For-each loop for Vec\n");
+    indent();
+    emit("for (long _i = 0; _i < (");
+    exprGen.generate(node->collection.get());
+    emit(").len; _i++) {\n");
+    
+    indentLevel++;
+    indent();
+    output << elementType << " " << node->iteratorName << " = (";
+    exprGen.generate(node->collection.get());
+    emit(").data[_i];\n");
+    
+    if (currentScope) {
+        currentScope->addSymbol(node->iteratorName, elementType);
+    }
+    
+    if (auto* block = nodeCast<BlockNode>(node->body.get())) {
+        for (auto& stmt : block->statements) {
+            generate(stmt.get());
+        }
+    } else {
+        generate(node->body.get());
+    }
+    
+    indentLevel--;
+    emitLine("}");
+}
+
+void StmtGenerator::generateForMap(ForNode* node, const MapInfo& map) {
+    ExprGenerator exprGen(output, indentLevel, currentScope, typeRegistry);
+    
+    // Keys in slot order; the body must not insert or remove
+    indent();
+    emit("// For-each loop over Map keys\n");
+    indent();
+    emit("for (long _i = 0; _i < (");
+    exprGen.generate(node->collection.get());
+    emit(").cap; _i++) {\n");
+    
+    indentLevel++;
+    indent();
+    emit("if ((");
+    exprGen.generate(node->collection.get());
+    emit(").ctrl[_i] < 0) continue;\n");
+    indent();
+    output << map.keyType << " " << node->iteratorName << " = (";
+    exprGen.generate(node->collection.get());
+    emit(").entries[_i].key;\n");
+    
+    if (currentScope) {
+        currentScope->addSymbol(node->iteratorName, map.keyType);
+    }
+    
+    if (auto* block = nodeCast<BlockNode>(node->body.get())) {
+        for (auto& stmt : block->statements) {
+            generate(stmt.get());
+        }
+    } else {
+        generate(node->body.get());
+    }
+    
+    indentLevel--;
+    emitLine("}");
+}
+
+void StmtGenerator::generateParallelFor(ForNode* node) {
+    // The body is outlined into a worker over [__begin, __end) and the loop
+    // becomes a call into the runtime. Locals it uses are passed by address,
+    // reduction variables get a private copy per worker.
+    static const Symbol range("range");
+    auto* rangeCall = nodeCast<CallNode>(node->collection.get());
+    if (!rangeCall || rangeCall->functionName != range || rangeCall->arguments.empty() ||
+        rangeCall->arguments.size() > 2) {
+        throw std::runtime_error("par for requires range(end) or range(begin, end)");
+    }
+    if (!hoist || !currentScope) {
+        throw std::runtime_error("par for is only allowed inside a function");
+    }
+    
+    CaptureCollector body;
+    body.collect(node->body.get());
+    if (body.hasReturn) {
+        throw std::runtime_error("Cannot return from inside a par for");
+    }
+    
+    std::string name = "__par" + std::to_string((*hoist->nextId)++);
+    SymbolTable bodyScope(*currentScope);
+    
+    // Outer variables are referred to by their alias when loops are nested
+    auto outerExpression = [&](Symbol variable) {
+        const std::string* alias = currentScope->getAlias(variable);
+        return alias ? *alias : variable.str();
+    };
+    
+    std::vector<std::string> reductionTypes;
+    std::unordered_set<Symbol> reduced;
+    for (const auto& reduction : node->reductions) {
+        std::string type = currentScope->getSymbolType(reduction.variable);
+        if (type.empty()) {
+            throw std::runtime_error("Unknown reduction variable '" + reduction.variable.str() + "'");
+        }
+        reductionTypes.push_back(type);
+        reduced.insert(reduction.variable);
+        bodyScope.addAlias(reduction.variable, "__red." + reduction.variable.str());
+    }
+    
+    std::vector<std::string> environment;
+    for (Symbol variable : body.referenced) {
+        if (variable == node->iteratorName || body.declared.count(variable) || reduced.count(variable) ||
+            !currentScope->hasSymbol(variable)) {
+            continue; // loop-local, reduced or global
+        }
+        
+        std::string type = currentScope->getSymbolType(variable);
+        std::string slot = "__env[" + std::to_string(environment.size()) + "]";
+        if (!type.empty() && type.back() == ']') {
+            // Arrays are passed as their first element and keep their dimensions
+            size_t open = type.find('[');
+            bodyScope.addAlias(variable, "(*(" + type.substr(0, open) + "(*)" + type.substr(open) + ")" + slot + ")");
+            environment.push_back("(void*)(" + outerExpression(variable) + ")");
+        } else {
+            bodyScope.addAlias(variable, "(*(" + type + "*)" + slot + ")");
+            environment.push_back("(void*)&(" + outerExpression(variable) + ")");
+        }
+    }
+    bodyScope.addSymbol(node->iteratorName, "int");
+    
+    // Generate the worker, hoisting loops nested in it in front of it
+    OutputBuffer worker;
+    int workerIndent = 0;
+    HoistPoint nested{&worker, 0, hoist->nextId};
+    StmtGenerator bodyGen(worker, workerIndent, typeRegistry);
+    bodyGen.setCurrentScope(&bodyScope);
+    bodyGen.setHoistPoint(&nested);
+    
+    std::string acc = "struct " + name + "_acc";
+    if (!node->reductions.empty()) {
+        worker << acc << " {\n";
+        for (size_t i = 0; i < node->reductions.size(); i++) {
+            worker << "    " << reductionTypes[i] << " " << node->reductions[i].variable << ";\n";
+        }
+        worker << "};\n\n";
+        
+        worker << "static void " << name << "_init(void* __accp) {\n";
+        worker << "    " << acc << "* __acc = __accp;\n";
+        for (size_t i = 0; i < node->reductions.size(); i++) {
+            const auto& reduction = node->reductions[i];
+            worker << "    __acc->" << reduction.variable << " = "
+                   << reductionIdentity(reduction.op, reductionTypes[i]) << ";\n";
+        }
+        worker << "}\n\n";
+        
+        worker << "static void " << name << "_combine(void* __accp, const void* __otherp) {\n";
+        worker << "    " << acc << "* __acc = __accp;\n";
+        worker << "    const " << acc << "* __other = __otherp;\n";
+        for (const auto& reduction : node->reductions) {
+            std::string field = reduction.variable.str();
+            worker << "    " << reductionCombine(reduction.op, "__acc->" + field, "__other->" + field) << "\n";
+        }
+        worker << "}\n\n";
+    }
+    
+    worker << "static void " << name << "_body(void* __envp, long __begin, long __end, void* __accp) {\n";
+    if (!environment.empty()) {
+        worker << "    void** __env = __envp;\n";
+    }
+    if (!node->reductions.empty()) {
+        worker << "    " << acc << " __red = *(" << acc << "*)__accp;\n";
+    }
+    worker << "    for (int " << node->iteratorName << " = (int)__begin; " << node->iteratorName
+           << " < (int)__end; " << node->iteratorName << "++) ";
+    workerIndent = 1;
+    if (nodeCast<BlockNode>(node->body.get())) {
+        worker << "\n";
+        bodyGen.generate(node->body.get());
+    } else {
+        worker << "{\n";
+        workerIndent++;
+        bodyGen.generate(node->body.get());
+        workerIndent--;
+        worker << "    }\n";
+    }
+    if (!node->reductions.empty()) {
+        worker << "    *(" << acc << "*)__accp = __red;\n";
+    }
+    worker << "}\n\n";
+    
+    worker << "static const peach_par_loop " << name << " = {" << name << "_body, ";
+    if (node->reductions.empty()) {
+        worker << "NULL, NULL, 0};\n\n";
+    } else {
+        worker << name << "_init, " << name << "_combine, sizeof(" << acc << ")};\n\n";
+    }
+    
+    std::string workerCode = worker.str();
+    hoist->output->insert(hoist->position, workerCode);
+    hoist->position += workerCode.size();
+    
+    // Call the runtime, then fold the reduced values into the variables
+    std::string id = name.substr(5);
+    emitLine("{");
+    indentLevel++;
+    if (!environment.empty()) {
+        indent();
+        output << "void* __env" << id << "[] = {";
+        for (size_t i = 0; i < environment.size(); i++) {
+            output << (i > 0 ? ", " : "") << environment[i];
         }
+        output << "};\n";
+    }
+    if (!node->reductions.empty()) {
+        indent();
+        output << acc << " __red" << id << ";\n";
+    }
+    
+    ExprGenerator exprGen(output, indentLevel, currentScope, typeRegistry);
+    indent();
+    output << "peach_par_for(&" << name << ", " << (environment.empty() ? "NULL" : "__env" + id) << ", (long)(";
+    if (rangeCall->arguments.size() == 2) {
+        exprGen.generate(rangeCall->arguments[0].get());
+    } else {
+        emit("0");
     }
+    emit("), (long)(");
+    exprGen.generate(rangeCall->arguments.back().get());
+    output << "), " << (node->reductions.empty() ? "NULL" : "&__red" + id) << ");\n";
     
+    for (const auto& reduction : node->reductions) {
+        indent();
+        output << reductionCombine(reduction.op, outerExpression(reduction.variable),
+                                   "__red" + id + "." + reduction.variable.str()) << "\n";
+    }
     indentLevel--;
     emitLine("}");
 }
 
-void StmtGenerator::generateReturn(ReturnNode* node) {
+void StmtGenerator::visitReturn(ReturnNode* node) {
     indent();
     emit("return");
     if (node->value) {
@@ -300,9 +710,10 @@ void StmtGenerator::generateReturn(ReturnNode* node) {
         ExprGenerator exprGen(output, indentLevel, currentScope, typeRegistry);
         exprGen.generate(node->value.get());
     }
+    emit(";\n");
 }
 
-void StmtGenerator::generateExprStmt(ExprStmtNode* node) {
+void StmtGenerator::visitExprStmt(ExprStmtNode* node) {
     indent();
     ExprGenerator exprGen(output, indentLevel, currentScope, typeRegistry);
     exprGen.generate(node->expr.get());
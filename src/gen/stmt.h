@@ -2,31 +2,48 @@
 #include "base.h"
 #include "expr.h"
 #include "../ast.h"
+#include "../ast_visitor.h"
 #include "../type_registry.h"
 
-class StmtGenerator : public CodeGenBase {
+// Where the worker functions of parallel loops go: in front of the
+// enclosing function, which is still being written to the same buffer
+struct HoistPoint {
+    OutputBuffer* output;
+    size_t position; // advanced past each inserted worker
+    int* nextId;     // numbers workers uniquely in the translation unit
+};
+
+class StmtGenerator : public CodeGenBase, public StmtVisitor<StmtGenerator> {
 private:
+    friend class StmtVisitor<StmtGenerator>;
+    
     TypeRegistry* typeRegistry;
     SymbolTable* currentScope;
+    HoistPoint* hoist;
     
 public:
-    StmtGenerator(std::stringstream& out, int& indent, TypeRegistry* types = nullptr) 
-        : CodeGenBase(out, indent), typeRegistry(types), currentScope(nullptr) {}
+    StmtGenerator(OutputBuffer& out, int& indent, TypeRegistry* types = nullptr) 
+        : CodeGenBase(out, indent), typeRegistry(types), currentScope(nullptr), hoist(nullptr) {}
     
     void setCurrentScope(SymbolTable* scope) { currentScope = scope; }
+    void setHoistPoint(HoistPoint* point) { hoist = point; }
     
-    void generate(StmtNode* node);
+    void generate(StmtNode* node) { visit(node); }
     
 private:
-    void generateVarDecl(VarDeclNode* node);
-    void generateBlock(BlockNode* node);
-    void generateIf(IfNode* node);
-    void generateWhile(WhileNode* node);
-    void generateFor(ForNode* node);
-    void generateReturn(ReturnNode* node);
-    void generateExprStmt(ExprStmtNode* node);
+    void visitVarDecl(VarDeclNode* node);
+    void visitBlock(BlockNode* node);
+    void visitIf(IfNode* node);
+    void visitWhile(WhileNode* node);
+    void visitFor(ForNode* node);
+    void visitReturn(ReturnNode* node);
+    void visitExprStmt(ExprStmtNode* node);
     
     // Helper methods
     void generateForRange(ForNode* node, CallNode* rangeCall);
     void generateForArray(ForNode* node);
+    void generateForSlice(ForNode* node, const std::string& elementType);
+    void generateForVec(ForNode* node, const std::string& elementType);
+    void generateForMap(ForNode* node, const MapInfo& map);
+    void generateParallelFor(ForNode* node);
 };
\ No newline at end of file
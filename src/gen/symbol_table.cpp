@@ -1,10 +1,25 @@
 #include "symbol_table.h"
 
-void SymbolTable::addSymbol(const std::string& name, const std::string& type) {
+void SymbolTable::addSymbol(Symbol name, const std::string& type) {
     symbols[name] = type;
+    if (!aliases.empty()) {
+        aliases.erase(name);
+    }
+}
+
+void SymbolTable::addAlias(Symbol name, const std::string& expression) {
+    aliases[name] = expression;
+}
+
+const std::string* SymbolTable::getAlias(Symbol name) const {
+    if (aliases.empty()) {
+        return nullptr;
+    }
+    auto it = aliases.find(name);
+    return it != aliases.end() ? &it->second : nullptr;
 }
 
-std::string SymbolTable::getSymbolType(const std::string& name) const {
+std::string SymbolTable::getSymbolType(Symbol name) const {
     auto it = symbols.find(name);
     if (it != symbols.end()) {
         return it->second;
@@ -12,14 +27,18 @@ std::string SymbolTable::getSymbolType(const std::string& name) const {
     return ""; // Unknown symbol
 }
 
-bool SymbolTable::hasSymbol(const std::string& name) const {
+bool SymbolTable::hasSymbol(Symbol name) const {
     return symbols.find(name) != symbols.end();
 }
 
 void SymbolTable::clear() {
     symbols.clear();
+    aliases.clear();
+    addressTaken.clear();
 }
 
 SymbolTable::SymbolTable(const SymbolTable& parent) {
     symbols = parent.symbols;
+    aliases = parent.aliases;
+    addressTaken = parent.addressTaken;
 }
\ No newline at end of file
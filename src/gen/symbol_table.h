@@ -1,21 +1,35 @@
 #pragma once
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
+#include "../interner.h"
 
 // Simple symbol table for tracking variable and parameter types
 class SymbolTable {
 private:
-    std::unordered_map<std::string, std::string> symbols;
+    std::unordered_map<Symbol, std::string> symbols;
+    std::unordered_map<Symbol, std::string> aliases; // name -> C expression emitted instead
+    std::unordered_set<Symbol> addressTaken;
     
 public:
-    // Add a symbol with its type
-    void addSymbol(const std::string& name, const std::string& type);
+    // Add a symbol with its type. A new declaration hides any alias.
+    void addSymbol(Symbol name, const std::string& type);
+    
+    // Emit `expression` wherever `name` is used, e.g. a variable captured
+    // by an outlined loop body
+    void addAlias(Symbol name, const std::string& expression);
+    const std::string* getAlias(Symbol name) const;
+    
+    // Locals other code may reach through a pointer while a call runs.
+    // Only the others can be passed to a read-only struct parameter by address.
+    void markAddressTaken(Symbol name) { addressTaken.insert(name); }
+    bool isAddressTaken(Symbol name) const { return addressTaken.count(name) > 0; }
     
     // Look up a symbol's type
-    std::string getSymbolType(const std::string& name) const;
+    std::string getSymbolType(Symbol name) const;
     
     // Check if a symbol exists
-    bool hasSymbol(const std::string& name) const;
+    bool hasSymbol(Symbol name) const;
     
     // Clear all symbols (for new scope)
     void clear();
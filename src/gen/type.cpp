@@ -1,4 +1,5 @@
 #include "type.h"
+#include "../vector_types.h"
 
 std::string TypeGenerator::generateArrayDeclaration(ArrayTypeNode* arrayType, 
                                                   const std::string& varName,
@@ -11,7 +12,7 @@ std::string TypeGenerator::generateArrayDeclaration(ArrayTypeNode* arrayType,
     
     // If size is not specified and we have an initializer, infer size
     if (!arrayType->size && initializer) {
-        if (auto* arrayLit = dynamic_cast<ArrayLiteralNode*>(initializer)) {
+        if (auto* arrayLit = nodeCast<ArrayLiteralNode>(initializer)) {
             int size = calculateArraySize(arrayLit);
             dimensions.push_back("[" + std::to_string(size) + "]");
         } else {
@@ -29,141 +30,296 @@ std::string TypeGenerator::generateArrayDeclaration(ArrayTypeNode* arrayType,
     return result;
 }
 
+std::string TypeGenerator::generateParameterDeclaration(TypeNode* type, const std::string& name) {
+    if (auto* arrayType = nodeCast<ArrayTypeNode>(type)) {
+        return generateArrayDeclaration(arrayType, name);
+    }
+    return parameterCType(type) + " " + name;
+}
+
+std::string TypeGenerator::parameterCType(TypeNode* type) {
+    if (auto* pointerType = nodeCast<PointerTypeNode>(type)) {
+        if (pointerType->isRestrict) {
+            return pointerType->toCType() + " restrict";
+        }
+    }
+    if (auto* structType = nodeCast<StructTypeNode>(type)) {
+        if (structType->isReadOnlyReference) {
+            return "const " + structType->toCType() + "*";
+        }
+    }
+    return type->toCType();
+}
+
+std::string TypeGenerator::declaredType(TypeNode* type) {
+    std::string dimensions;
+    TypeNode* element = type;
+    while (auto* arrayType = nodeCast<ArrayTypeNode>(element)) {
+        auto* size = nodeCast<IntLiteralNode>(arrayType->size.get());
+        if (!size) {
+            return type->toCType();
+        }
+        dimensions += "[" + std::to_string(size->value) + "]";
+        element = arrayType->elementType.get();
+    }
+    return element->toCType() + dimensions;
+}
+
 std::string TypeGenerator::inferType(ExprNode* expr) {
-    if (dynamic_cast<IntLiteralNode*>(expr)) {
+    return visit(expr);
+}
+
+std::string TypeGenerator::visitExpr(ExprNode*) {
+    return "int"; // Default type
+}
+
+std::string TypeGenerator::visitIntLiteral(IntLiteralNode*) {
+    return "int";
+}
+
+std::string TypeGenerator::visitLongLiteral(LongLiteralNode*) {
+    return "long";
+}
+
+std::string TypeGenerator::visitFloatLiteral(FloatLiteralNode*) {
+    return "float";
+}
+
+std::string TypeGenerator::visitDoubleLiteral(DoubleLiteralNode*) {
+    return "double";
+}
+
+std::string TypeGenerator::visitStringLiteral(StringLiteralNode*) {
+    return "const char*";
+}
+
+std::string TypeGenerator::visitBoolLiteral(BoolLiteralNode*) {
+    return "int";
+}
+
+std::string TypeGenerator::visitArrayLiteral(ArrayLiteralNode* arrayLit) {
+    // For array literals, we need to look at the first element
+    if (!arrayLit->elements.empty()) {
+        return inferType(arrayLit->elements[0].get());
+    }
+    return "int"; // Default array element type
+}
+
+std::string TypeGenerator::visitIndex(IndexNode* index) {
+    std::string arrayType = inferType(index->array.get());
+    
+    // Slices, Vecs, Maps and sized array parameters know their element type
+    if (typeRegistry) {
+        if (const MapInfo* map = typeRegistry->getMap(arrayType)) {
+            return map->valueType;
+        }
+        std::string elementType = typeRegistry->getSliceElementType(arrayType);
+        if (elementType.empty()) {
+            elementType = typeRegistry->getVecElementType(arrayType);
+        }
+        if (!elementType.empty()) {
+            return elementType;
+        }
+    }
+    if (const VectorType* vector = findVectorType(arrayType)) {
+        return std::string(vector->elementType); // lane
+    }
+    if (!arrayType.empty() && arrayType.back() == ']') {
+        // Drop the outermost dimension
+        size_t open = arrayType.find('[');
+        return arrayType.substr(0, open) + arrayType.substr(arrayType.find(']', open) + 1);
+    }
+    return "int"; // Fallback
+}
+
+std::string TypeGenerator::visitDereference(DereferenceNode* deref) {
+    // Dereference of a pointer gives the pointed-to type
+    std::string ptrType = inferType(deref->operand.get());
+    // Remove the trailing '*' if it exists
+    if (ptrType.length() > 1 && ptrType.back() == '*') {
+        return ptrType.substr(0, ptrType.length() - 1);
+    }
+    return "int"; // Fallback
+}
+
+std::string TypeGenerator::visitBinaryOp(BinaryOpNode* binOp) {
+    // For binary operations, need to consider type promotion
+    if (binOp->op == "=") {
+        // This shouldn't happen in a proper parse
         return "int";
-    } else if (dynamic_cast<LongLiteralNode*>(expr)) {
-        return "long";
-    } else if (dynamic_cast<FloatLiteralNode*>(expr)) {
-        return "float";
-    } else if (dynamic_cast<DoubleLiteralNode*>(expr)) {
+    }
+    
+    std::string leftType = inferType(binOp->left.get());
+    std::string rightType = inferType(binOp->right.get());
+    
+    // Type promotion rules, vectors absorb scalar operands
+    if (findVectorType(leftType)) {
+        return leftType;
+    } else if (findVectorType(rightType)) {
+        return rightType;
+    } else if (leftType == "double" || rightType == "double") {
         return "double";
-    } else if (dynamic_cast<StringLiteralNode*>(expr)) {
-        return "const char*";
-    } else if (dynamic_cast<BoolLiteralNode*>(expr)) {
+    } else if (leftType == "float" || rightType == "float") {
+        return "float";
+    } else if (leftType == "long" || rightType == "long") {
+        return "long";
+    } else {
         return "int";
-    } else if (dynamic_cast<ArrayLiteralNode*>(expr)) {
-        // For array literals, we need to look at the first element
-        auto* arrayLit = dynamic_cast<ArrayLiteralNode*>(expr);
-        if (!arrayLit->elements.empty()) {
-            return inferType(arrayLit->elements[0].get());
-        }
-        return "int"; // Default array element type
-    } else if (auto* deref = dynamic_cast<DereferenceNode*>(expr)) {
-        // Dereference of a pointer gives the pointed-to type
-        std::string ptrType = inferType(deref->operand.get());
-        // Remove the trailing '*' if it exists
-        if (ptrType.length() > 1 && ptrType.back() == '*') {
-            return ptrType.substr(0, ptrType.length() - 1);
-        }
-        return "int"; // Fallback
-    } else if (auto* binOp = dynamic_cast<BinaryOpNode*>(expr)) {
-        // For binary operations, need to consider type promotion
-        if (binOp->op == "=") {
-            // This shouldn't happen in a proper parse
-            return "int";
+    }
+}
+
+std::string TypeGenerator::visitAddressOf(AddressOfNode* addrOf) {
+    // Address-of gives a pointer type
+    // Try to determine the type of the operand
+    std::string operandType = inferType(addrOf->operand.get());
+    return operandType + "*";
+}
+
+std::string TypeGenerator::visitCall(CallNode* call) {
+    static const Symbol hsum("hsum"), hmin("hmin"), hmax("hmax"), arenaName("Arena"), vecName("Vec");
+    static const Symbol mapName("Map");
+    
+    if (call->functionName == arenaName) {
+        return "peach_arena";
+    }
+    if (call->functionName == vecName && call->typeArguments.size() == 1) {
+        return VecTypeNode::cTypeFor(call->typeArguments[0]->toCType());
+    }
+    if (call->functionName == mapName && call->typeArguments.size() == 2) {
+        return MapTypeNode::cTypeFor(call->typeArguments[0]->toCType(), call->typeArguments[1]->toCType());
+    }
+    
+    // Vector builtins
+    std::string_view operation;
+    if (const VectorType* vector = findVectorBuiltin(call->functionName.str(), operation)) {
+        if (operation == "splat" || operation == "load") {
+            return vector->cType();
         }
-        
-        std::string leftType = inferType(binOp->left.get());
-        std::string rightType = inferType(binOp->right.get());
-        
-        // Type promotion rules
-        if (leftType == "double" || rightType == "double") {
-            return "double";
-        } else if (leftType == "float" || rightType == "float") {
-            return "float";
-        } else if (leftType == "long" || rightType == "long") {
-            return "long";
-        } else {
-            return "int";
-        }
-    } else if (auto* addrOf = dynamic_cast<AddressOfNode*>(expr)) {
-        // Address-of gives a pointer type
-        // Try to determine the type of the operand
-        std::string operandType = inferType(addrOf->operand.get());
-        return operandType + "*";
-    } else if (dynamic_cast<CallNode*>(expr)) {
-        // Function calls - for now assume int, but could be extended
-        // to track function return types
-        return "int";
-    } else if (auto* methodCall = dynamic_cast<MethodCallNode*>(expr)) {
-        // Method calls - look up the return type from type registry
-        if (typeRegistry) {
-            auto* ident = dynamic_cast<IdentifierNode*>(methodCall->receiver.get());
-            if (ident) {
-                std::string varType = "";
-                
-                // Try to get variable type from symbol table first
-                if (symbolTable && symbolTable->hasSymbol(ident->name)) {
-                    varType = symbolTable->getSymbolType(ident->name);
-                } else {
-                    varType = typeRegistry->getVariableType(ident->name);
-                }
-                
-                // Extract struct name from type
-                if (varType.find("struct ") == 0) {
-                    std::string structName = varType.substr(7);
-                    std::string returnType = typeRegistry->getMethodReturnType(structName, methodCall->methodName);
-                    if (!returnType.empty()) {
-                        return returnType;
-                    }
+    } else if ((call->functionName == hsum || call->functionName == hmin || call->functionName == hmax) &&
+               call->arguments.size() == 1) {
+        if (const VectorType* vector = findVectorType(inferType(call->arguments[0].get()))) {
+            return std::string(vector->elementType);
+        }
+    }
+    
+    // Other function calls - for now assume int, but could be extended
+    // to track function return types
+    return "int";
+}
+
+std::string TypeGenerator::visitMethodCall(MethodCallNode* methodCall) {
+    static const Symbol used("used"), pop("pop"), has("has"), remove("remove");
+    
+    std::string receiverType = inferType(methodCall->receiver.get());
+    if (isArenaType(receiverType)) {
+        if (methodCall->typeArgument) {
+            return methodCall->typeArgument->toCType() + "*"; // alloc
+        }
+        return methodCall->methodName == used ? "long" : "void";
+    }
+    
+    // Vec and Map methods, on the collection or through a pointer to it
+    if (typeRegistry && !receiverType.empty()) {
+        if (receiverType.back() == '*') {
+            receiverType.pop_back();
+        }
+        std::string elementType = typeRegistry->getVecElementType(receiverType);
+        if (!elementType.empty()) {
+            return methodCall->methodName == pop ? elementType : "void";
+        }
+        if (typeRegistry->getMap(receiverType)) {
+            return methodCall->methodName == has || methodCall->methodName == remove ? "int" : "void";
+        }
+    }
+    
+    // Method calls - look up the return type from type registry
+    if (typeRegistry) {
+        auto* ident = nodeCast<IdentifierNode>(methodCall->receiver.get());
+        if (ident) {
+            std::string varType = "";
+            
+            // Try to get variable type from symbol table first
+            if (symbolTable && symbolTable->hasSymbol(ident->name)) {
+                varType = symbolTable->getSymbolType(ident->name);
+            } else {
+                varType = typeRegistry->getVariableType(ident->name);
+            }
+            
+            // Extract struct name from type
+            if (varType.find("struct ") == 0) {
+                std::string structName = varType.substr(7);
+                std::string returnType = typeRegistry->getMethodReturnType(structName, methodCall->methodName);
+                if (!returnType.empty()) {
+                    return returnType;
                 }
             }
         }
-        
-        // Fallback - this should be an error in a complete implementation
-        return "int";
-    } else if (auto* structInit = dynamic_cast<StructInitNode*>(expr)) {
-        // Struct initialization - return the struct type
-        return "struct " + structInit->structName;
-    } else if (auto* unionInit = dynamic_cast<UnionInitNode*>(expr)) {
-        // Union initialization - return the union type
-        return "union " + unionInit->unionName;
-    } else if (auto* ident = dynamic_cast<IdentifierNode*>(expr)) {
-        // Identifiers - use symbol table for type lookup
-        if (symbolTable && symbolTable->hasSymbol(ident->name)) {
-            return symbolTable->getSymbolType(ident->name);
-        } else if (typeRegistry) {
-            std::string varType = typeRegistry->getVariableType(ident->name);
-            if (!varType.empty()) {
-                return varType;
+    }
+    
+    // Fallback - this should be an error in a complete implementation
+    return "int";
+}
+
+std::string TypeGenerator::visitStructInit(StructInitNode* structInit) {
+    // Struct initialization - return the struct type
+    return "struct " + structInit->structName;
+}
+
+std::string TypeGenerator::visitUnionInit(UnionInitNode* unionInit) {
+    // Union initialization - return the union type
+    return "union " + unionInit->unionName;
+}
+
+std::string TypeGenerator::visitIdentifier(IdentifierNode* ident) {
+    // Identifiers - use symbol table for type lookup
+    if (symbolTable && symbolTable->hasSymbol(ident->name)) {
+        return symbolTable->getSymbolType(ident->name);
+    } else if (typeRegistry) {
+        std::string varType = typeRegistry->getVariableType(ident->name);
+        if (!varType.empty()) {
+            return varType;
+        }
+    }
+    return "int"; // Fallback
+}
+
+std::string TypeGenerator::visitFieldAccess(FieldAccessNode* fieldAccess) {
+    // Field access - determine field type
+    if (typeRegistry) {
+        auto* ident = nodeCast<IdentifierNode>(fieldAccess->object.get());
+        std::string varType = "";
+        if (ident) {
+            // Get variable type
+            if (symbolTable && symbolTable->hasSymbol(ident->name)) {
+                varType = symbolTable->getSymbolType(ident->name);
+            } else {
+                varType = typeRegistry->getVariableType(ident->name);
             }
+        } else {
+            varType = inferType(fieldAccess->object.get()); // a.b.c, v[i].x
         }
-        return "int"; // Fallback
-    } else if (auto* fieldAccess = dynamic_cast<FieldAccessNode*>(expr)) {
-        // Field access - determine field type
-        if (typeRegistry) {
-            auto* ident = dynamic_cast<IdentifierNode*>(fieldAccess->object.get());
-            if (ident) {
-                std::string varType = "";
-                
-                // Get variable type
-                if (symbolTable && symbolTable->hasSymbol(ident->name)) {
-                    varType = symbolTable->getSymbolType(ident->name);
-                } else {
-                    varType = typeRegistry->getVariableType(ident->name);
-                }
-                
-                // Extract struct/union name and look up field type
-                if (varType.find("struct ") == 0) {
-                    std::string structName = varType.substr(7);
-                    std::string fieldType = typeRegistry->getFieldType(structName, fieldAccess->fieldName);
-                    if (!fieldType.empty()) {
-                        return fieldType;
-                    }
-                } else if (varType.find("union ") == 0) {
-                    std::string unionName = varType.substr(6);
-                    std::string fieldType = typeRegistry->getFieldType(unionName, fieldAccess->fieldName);
-                    if (!fieldType.empty()) {
-                        return fieldType;
-                    }
-                }
+        
+        // A single pointer is followed, p.x reads (*p).x
+        if (!varType.empty() && varType.back() == '*' && varType.find('*') == varType.size() - 1) {
+            varType.pop_back();
+        }
+        
+        // Extract struct/union name and look up field type
+        if (varType.find("struct ") == 0) {
+            std::string structName = varType.substr(7);
+            std::string fieldType = typeRegistry->getFieldType(structName, fieldAccess->fieldName);
+            if (!fieldType.empty()) {
+                return fieldType;
+            }
+        } else if (varType.find("union ") == 0) {
+            std::string unionName = varType.substr(6);
+            std::string fieldType = typeRegistry->getFieldType(unionName, fieldAccess->fieldName);
+            if (!fieldType.empty()) {
+                return fieldType;
             }
         }
-        return "int"; // Fallback
-    } else {
-        return "int"; // Default type
     }
+    return "int"; // Fallback
 }
 
 std::string TypeGenerator::inferTypeWithContext(ExprNode* expr, SymbolTable* symbols) {
@@ -185,10 +341,10 @@ int TypeGenerator::calculateArraySize(ArrayLiteralNode* literal) {
 }
 
 void TypeGenerator::collectArrayDimensions(TypeNode* type, std::vector<std::string>& dimensions) {
-    ArrayTypeNode* current = dynamic_cast<ArrayTypeNode*>(type);
+    ArrayTypeNode* current = nodeCast<ArrayTypeNode>(type);
     while (current) {
         if (current->size) {
-            if (auto* intLit = dynamic_cast<IntLiteralNode*>(current->size.get())) {
+            if (auto* intLit = nodeCast<IntLiteralNode>(current->size.get())) {
                 dimensions.push_back("[" + std::to_string(intLit->value) + "]");
             } else {
                 dimensions.push_back("[1]"); // Default size
@@ -196,6 +352,6 @@ void TypeGenerator::collectArrayDimensions(TypeNode* type, std::vector<std::stri
         } else {
             dimensions.push_back("[]");
         }
-        current = dynamic_cast<ArrayTypeNode*>(current->elementType.get());
+        current = nodeCast<ArrayTypeNode>(current->elementType.get());
     }
 }
\ No newline at end of file
@@ -2,19 +2,22 @@
 #include "base.h"
 #include "symbol_table.h"
 #include "../ast.h"
+#include "../ast_visitor.h"
 #include "../type_registry.h"
 #include <vector>
 
-class TypeGenerator : public CodeGenBase {
+class TypeGenerator : public CodeGenBase, public ExprVisitor<TypeGenerator, std::string> {
 private:
+    friend class ExprVisitor<TypeGenerator, std::string>;
+    
     SymbolTable* symbolTable;
     TypeRegistry* typeRegistry;
     
 public:
-    TypeGenerator(std::stringstream& out, int& indent) 
+    TypeGenerator(OutputBuffer& out, int& indent) 
         : CodeGenBase(out, indent), symbolTable(nullptr), typeRegistry(nullptr) {}
     
-    TypeGenerator(std::stringstream& out, int& indent, SymbolTable* symbols, TypeRegistry* types = nullptr) 
+    TypeGenerator(OutputBuffer& out, int& indent, SymbolTable* symbols, TypeRegistry* types = nullptr) 
         : CodeGenBase(out, indent), symbolTable(symbols), typeRegistry(types) {}
     
     void setTypeRegistry(TypeRegistry* registry) { typeRegistry = registry; }
@@ -24,6 +27,23 @@ public:
                                        const std::string& varName,
                                        ExprNode* initializer = nullptr);
     
+    // Parameter declaration; sized arrays keep their dimensions
+    std::string generateParameterDeclaration(TypeNode* type, const std::string& name);
+    
+    // C type a non-array parameter is passed as, with restrict and
+    // read-only struct references applied
+    static std::string parameterCType(TypeNode* type);
+    
+    // The builtin Arena, held directly or through a pointer
+    static bool isArenaType(const std::string& cType) {
+        return cType == "peach_arena" || cType == "peach_arena*";
+    }
+    
+    // Type recorded in a scope for a declared variable or parameter. Arrays
+    // with literal sizes keep their dimensions, e.g. "int[4]", so loops and
+    // len() know their bound.
+    static std::string declaredType(TypeNode* type);
+    
     // Infer type from expression
     std::string inferType(ExprNode* expr);
     
@@ -36,4 +56,24 @@ public:
 private:
     // Helper to collect array dimensions
     void collectArrayDimensions(TypeNode* type, std::vector<std::string>& dimensions);
+    
+    // Type inference, one handler per expression kind
+    std::string visitExpr(ExprNode* expr);
+    std::string visitIntLiteral(IntLiteralNode* node);
+    std::string visitLongLiteral(LongLiteralNode* node);
+    std::string visitFloatLiteral(FloatLiteralNode* node);
+    std::string visitDoubleLiteral(DoubleLiteralNode* node);
+    std::string visitStringLiteral(StringLiteralNode* node);
+    std::string visitBoolLiteral(BoolLiteralNode* node);
+    std::string visitArrayLiteral(ArrayLiteralNode* node);
+    std::string visitIndex(IndexNode* node);
+    std::string visitDereference(DereferenceNode* node);
+    std::string visitBinaryOp(BinaryOpNode* node);
+    std::string visitAddressOf(AddressOfNode* node);
+    std::string visitCall(CallNode* node);
+    std::string visitMethodCall(MethodCallNode* node);
+    std::string visitStructInit(StructInitNode* node);
+    std::string visitUnionInit(UnionInitNode* node);
+    std::string visitIdentifier(IdentifierNode* node);
+    std::string visitFieldAccess(FieldAccessNode* node);
 };
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "inline_analysis.h"
+#include <stdexcept>
+
+namespace {
+
+// A getter is 2 nodes, `self.x * self.x + self.y * self.y` is 11
+constexpr size_t INLINE_COST_LIMIT = 16;
+
+// The expression a one-line body computes, nullptr for longer bodies
+ExprNode* singleExpression(StmtNode* body) {
+    if (auto* block = nodeCast<BlockNode>(body)) {
+        if (block->statements.size() != 1) {
+            return nullptr;
+        }
+        body = block->statements[0].get();
+    }
+    if (auto* exprStmt = nodeCast<ExprStmtNode>(body)) {
+        return exprStmt->expr.get();
+    }
+    if (auto* returnStmt = nodeCast<ReturnNode>(body)) {
+        return returnStmt->value.get();
+    }
+    return nullptr;
+}
+
+} // namespace
+
+void InlineAnalyzer::analyze(ProgramNode* program) {
+    for (auto& function : program->functions) {
+        functions[function->name] = function.get();
+    }
+    for (auto& implBlock : program->implBlocks) {
+        for (auto& method : implBlock->methods) {
+            methods[method->name].push_back(method.get());
+        }
+    }
+    
+    // Call graph and body sizes, in program order
+    std::vector<std::pair<FunctionNode*, size_t>> costs;
+    for (auto& implBlock : program->implBlocks) {
+        for (auto& method : implBlock->methods) {
+            collect(method.get());
+            costs.push_back({method.get(), cost});
+        }
+    }
+    for (auto& function : program->functions) {
+        collect(function.get());
+        costs.push_back({function.get(), cost});
+    }
+    
+    for (const auto& entry : costs) {
+        FunctionNode* function = entry.first;
+        bool wanted = function->inlineHint == InlineHint::Always ||
+                      (function->inlineHint == InlineHint::Auto && isCandidate(function) &&
+                       entry.second <= INLINE_COST_LIMIT);
+        static const Symbol main("main");
+        if (!wanted || function->name == main) {
+            continue;
+        }
+        
+        // gcc cannot honor always_inline on a recursive call
+        std::unordered_set<FunctionNode*> visited;
+        if (reaches(function, function, visited)) {
+            if (function->inlineHint == InlineHint::Always) {
+                throw std::runtime_error("Cannot inline recursive function '" + function->name.str() + "'");
+            }
+            continue;
+        }
+        
+        function->isInline = true;
+        inlineCount++;
+    }
+}
+
+void InlineAnalyzer::collect(FunctionNode* function) {
+    currentCallees = &callees[function];
+    cost = 0;
+    if (function->body) {
+        StmtVisitor::visit(function->body.get());
+    }
+}
+
+bool InlineAnalyzer::isCandidate(FunctionNode* function) const {
+    return function->body && singleExpression(function->body.get()) != nullptr;
+}
+
+bool InlineAnalyzer::reaches(FunctionNode* from, FunctionNode* target,
+                             std::unordered_set<FunctionNode*>& visited) const {
+    auto it = callees.find(from);
+    if (it == callees.end()) {
+        return false;
+    }
+    for (FunctionNode* callee : it->second) {
+        if (callee == target) {
+            return true;
+        }
+        if (visited.insert(callee).second && reaches(callee, target, visited)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void InlineAnalyzer::visitExpr(ExprNode*) {
+    cost++; // literals and identifiers
+}
+
+void InlineAnalyzer::visitBinaryOp(BinaryOpNode* node) {
+    cost++;
+    ExprVisitor::visit(node->left.get());
+    ExprVisitor::visit(node->right.get());
+}
+
+void InlineAnalyzer::visitUnaryOp(UnaryOpNode* node) {
+    cost++;
+    ExprVisitor::visit(node->operand.get());
+}
+
+void InlineAnalyzer::visitArrayLiteral(ArrayLiteralNode* node) {
+    cost++;
+    for (auto& element : node->elements) {
+        ExprVisitor::visit(element.get());
+    }
+}
+
+void InlineAnalyzer::visitIndex(IndexNode* node) {
+    cost++;
+    ExprVisitor::visit(node->array.get());
+    ExprVisitor::visit(node->index.get());
+}
+
+void InlineAnalyzer::visitCall(CallNode* node) {
+    cost++;
+    auto it = functions.find(node->functionName);
+    if (it != functions.end()) {
+        currentCallees->push_back(it->second);
+    }
+    for (auto& arg : node->arguments) {
+        ExprVisitor::visit(arg.get());
+    }
+}
+
+void InlineAnalyzer::visitAddressOf(AddressOfNode* node) {
+    cost++;
+    ExprVisitor::visit(node->operand.get());
+}
+
+void InlineAnalyzer::visitDereference(DereferenceNode* node) {
+    cost++;
+    ExprVisitor::visit(node->operand.get());
+}
+
+void InlineAnalyzer::visitFieldAccess(FieldAccessNode* node) {
+    cost++;
+    ExprVisitor::visit(node->object.get());
+}
+
+void InlineAnalyzer::visitStructInit(StructInitNode* node) {
+    cost++;
+    for (auto& field : node->fields) {
+        ExprVisitor::visit(field.second.get());
+    }
+}
+
+void InlineAnalyzer::visitUnionInit(UnionInitNode* node) {
+    cost++;
+    ExprVisitor::visit(node->value.get());
+}
+
+void InlineAnalyzer::visitMethodCall(MethodCallNode* node) {
+    cost++;
+    auto it = methods.find(node->methodName);
+    if (it != methods.end()) {
+        currentCallees->insert(currentCallees->end(), it->second.begin(), it->second.end());
+    }
+    ExprVisitor::visit(node->receiver.get());
+    for (auto& arg : node->arguments) {
+        ExprVisitor::visit(arg.get());
+    }
+}
+
+void InlineAnalyzer::visitExprStmt(ExprStmtNode* node) {
+    ExprVisitor::visit(node->expr.get());
+}
+
+void InlineAnalyzer::visitVarDecl(VarDeclNode* node) {
+    cost++;
+    if (node->initializer) {
+        ExprVisitor::visit(node->initializer.get());
+    }
+}
+
+void InlineAnalyzer::visitAssignment(AssignmentNode* node) {
+    cost++;
+    ExprVisitor::visit(node->target.get());
+    ExprVisitor::visit(node->value.get());
+}
+
+void InlineAnalyzer::visitBlock(BlockNode* node) {
+    for (auto& stmt : node->statements) {
+        StmtVisitor::visit(stmt.get());
+    }
+}
+
+void InlineAnalyzer::visitReturn(ReturnNode* node) {
+    if (node->value) {
+        ExprVisitor::visit(node->value.get());
+    }
+}
+
+void InlineAnalyzer::visitIf(IfNode* node) {
+    cost++;
+    ExprVisitor::visit(node->condition.get());
+    StmtVisitor::visit(node->thenBranch.get());
+    if (node->elseBranch) {
+        StmtVisitor::visit(node->elseBranch.get());
+    }
+}
+
+void InlineAnalyzer::visitWhile(WhileNode* node) {
+    cost++;
+    ExprVisitor::visit(node->condition.get());
+    StmtVisitor::visit(node->body.get());
+}
+
+void InlineAnalyzer::visitFor(ForNode* node) {
+    cost++;
+    ExprVisitor::visit(node->collection.get());
+    StmtVisitor::visit(node->body.get());
+}
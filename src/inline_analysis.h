@@ -0,0 +1,67 @@
+#pragma once
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+#include "ast_visitor.h"
+
+// Inlining decisions, made after escape analysis. gcc inlines nothing at -O0
+// and nothing across files without LTO, so getters and other small helpers
+// cost a full call. Functions and methods picked here are emitted with
+// always_inline and inlined into every caller in their file. A function is
+// picked when:
+//  - it is marked @inline, or it is not marked @noinline and its body is a
+//    single expression or return of at most INLINE_COST_LIMIT nodes;
+//  - it is not main;
+//  - it cannot reach itself through the calls it makes.
+// Callers in other files still call the external definition.
+class InlineAnalyzer : public ExprVisitor<InlineAnalyzer>, public StmtVisitor<InlineAnalyzer> {
+private:
+    friend class ExprVisitor<InlineAnalyzer>;
+    friend class StmtVisitor<InlineAnalyzer>;
+    
+    std::unordered_map<Symbol, FunctionNode*> functions;
+    std::unordered_map<Symbol, std::vector<FunctionNode*>> methods; // by name, receivers are not typed here
+    std::unordered_map<FunctionNode*, std::vector<FunctionNode*>> callees;
+    size_t inlineCount;
+    
+    // Per-function state
+    std::vector<FunctionNode*>* currentCallees;
+    size_t cost; // AST nodes in the body
+    
+    void collect(FunctionNode* function);
+    bool isCandidate(FunctionNode* function) const;
+    bool reaches(FunctionNode* from, FunctionNode* target, std::unordered_set<FunctionNode*>& visited) const;
+    
+    // Expressions
+    void visitExpr(ExprNode* node);
+    void visitBinaryOp(BinaryOpNode* node);
+    void visitUnaryOp(UnaryOpNode* node);
+    void visitArrayLiteral(ArrayLiteralNode* node);
+    void visitIndex(IndexNode* node);
+    void visitCall(CallNode* node);
+    void visitAddressOf(AddressOfNode* node);
+    void visitDereference(DereferenceNode* node);
+    void visitFieldAccess(FieldAccessNode* node);
+    void visitStructInit(StructInitNode* node);
+    void visitUnionInit(UnionInitNode* node);
+    void visitMethodCall(MethodCallNode* node);
+    
+    // Statements
+    void visitExprStmt(ExprStmtNode* node);
+    void visitVarDecl(VarDeclNode* node);
+    void visitAssignment(AssignmentNode* node);
+    void visitBlock(BlockNode* node);
+    void visitReturn(ReturnNode* node);
+    void visitIf(IfNode* node);
+    void visitWhile(WhileNode* node);
+    void visitFor(ForNode* node);
+    
+public:
+    InlineAnalyzer() : inlineCount(0), currentCallees(nullptr), cost(0) {}
+    
+    void analyze(ProgramNode* program);
+    
+    // Number of functions and methods marked for inlining
+    size_t getInlineCount() const { return inlineCount; }
+};
@@ -0,0 +1,40 @@
+#include "interner.h"
+#include <ostream>
+
+Symbol::Symbol(std::string_view name) : Symbol(StringInterner::global().intern(name)) {}
+
+const std::string& Symbol::str() const {
+    static const std::string emptyText;
+    return text ? *text : emptyText;
+}
+
+std::ostream& operator<<(std::ostream& out, Symbol symbol) {
+    return out << symbol.str();
+}
+
+StringInterner& StringInterner::global() {
+    static StringInterner instance;
+    return instance;
+}
+
+Symbol StringInterner::intern(std::string_view name) {
+    if (name.empty()) {
+        return Symbol();
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(name);
+    if (it != index.end()) {
+        return Symbol(it->second);
+    }
+    
+    storage.emplace_back(name);
+    const std::string* text = &storage.back();
+    index.emplace(std::string_view(*text), text);
+    return Symbol(text);
+}
+
+size_t StringInterner::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return storage.size();
+}
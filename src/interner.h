@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Interned identifier. Every distinct spelling is stored once in the global
+// StringInterner, so a Symbol is just a pointer to that copy: equality and
+// hashing are pointer operations and maps keyed on Symbol never hash text.
+class Symbol {
+private:
+    const std::string* text; // nullptr for the empty symbol
+    
+    explicit Symbol(const std::string* t) : text(t) {}
+    friend class StringInterner;
+    
+public:
+    Symbol() : text(nullptr) {}
+    explicit Symbol(std::string_view name);
+    
+    const std::string& str() const;
+    bool empty() const { return text == nullptr; }
+    
+    // Allow passing a Symbol wherever the spelling is needed
+    operator const std::string&() const { return str(); }
+    
+    bool operator==(Symbol other) const { return text == other.text; }
+    bool operator!=(Symbol other) const { return text != other.text; }
+    
+    size_t hash() const { return std::hash<const void*>()(text); }
+};
+
+std::ostream& operator<<(std::ostream& out, Symbol symbol);
+
+namespace std {
+template<>
+struct hash<Symbol> {
+    size_t operator()(Symbol symbol) const { return symbol.hash(); }
+};
+}
+
+// Process-wide string table. Interning is thread-safe; looking up the text
+// of a Symbol needs no lock because stored strings never move.
+class StringInterner {
+private:
+    std::mutex mutex;
+    std::deque<std::string> storage;
+    std::unordered_map<std::string_view, const std::string*> index;
+    
+public:
+    static StringInterner& global();
+    
+    Symbol intern(std::string_view name);
+    size_t size();
+};
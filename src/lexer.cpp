@@ -2,7 +2,7 @@
 #include <cctype>
 #include <stdexcept>
 
-std::unordered_map<std::string, TokenType> Lexer::keywords = {
+std::unordered_map<std::string_view, TokenType> Lexer::keywords = {
     {"val", TokenType::VAL},
     {"var", TokenType::VAR},
     {"def", TokenType::DEF},
@@ -23,10 +23,18 @@ std::unordered_map<std::string, TokenType> Lexer::keywords = {
     {"float", TokenType::FLOAT_TYPE},
     {"double", TokenType::DOUBLE_TYPE},
     {"bool", TokenType::BOOL_TYPE},
-    {"string", TokenType::STRING_TYPE}
+    {"string", TokenType::STRING_TYPE},
+    {"f32x4", TokenType::VECTOR_TYPE},
+    {"f32x8", TokenType::VECTOR_TYPE},
+    {"f64x2", TokenType::VECTOR_TYPE},
+    {"f64x4", TokenType::VECTOR_TYPE},
+    {"i32x4", TokenType::VECTOR_TYPE},
+    {"i32x8", TokenType::VECTOR_TYPE},
+    {"i64x2", TokenType::VECTOR_TYPE},
+    {"i64x4", TokenType::VECTOR_TYPE}
 };
 
-Lexer::Lexer(const std::string& src) : source(src), current(0), line(1), column(1) {}
+Lexer::Lexer(std::string_view src) : source(src), current(0), line(1), column(1) {}
 
 bool Lexer::isAtEnd() const {
     return current >= source.length();
@@ -92,11 +100,11 @@ Token Lexer::makeToken(TokenType type) {
     return Token(type, "", line, column);
 }
 
-Token Lexer::makeToken(TokenType type, const std::string& value) {
+Token Lexer::makeToken(TokenType type, std::string_view value) {
     return Token(type, value, line, column);
 }
 
-Token Lexer::errorToken(const std::string& message) {
+Token Lexer::errorToken(const char* message) {
     return Token(TokenType::UNKNOWN, message, line, column);
 }
 
@@ -113,65 +121,93 @@ bool Lexer::isAlphaNumeric(char c) const {
 }
 
 Token Lexer::scanString() {
-    std::string value;
     int startLine = line;
     int startCol = column;
     
     // Skip opening quote
     advance();
     
+    size_t start = current;
+    bool hasEscapes = false;
+    
     while (peek() != '"' && !isAtEnd()) {
         if (peek() == '\n') {
             return errorToken("Unterminated string");
         }
         if (peek() == '\\') {
+            hasEscapes = true;
             advance();
             switch (peek()) {
-                case 'n': value += '\n'; break;
-                case 't': value += '\t'; break;
-                case 'r': value += '\r'; break;
-                case '\\': value += '\\'; break;
-                case '"': value += '"'; break;
+                case 'n':
+                case 't':
+                case 'r':
+                case '\\':
+                case '"':
+                    break;
                 default:
                     return errorToken("Invalid escape sequence");
             }
-            advance();
-        } else {
-            value += advance();
         }
+        advance();
     }
     
     if (isAtEnd()) {
         return errorToken("Unterminated string");
     }
     
+    std::string_view raw = source.substr(start, current - start);
+    
     // Skip closing quote
     advance();
     
-    return Token(TokenType::STRING_LITERAL, value, startLine, startCol);
+    if (!hasEscapes) {
+        return Token(TokenType::STRING_LITERAL, raw, startLine, startCol);
+    }
+    
+    // Decode escapes into storage owned by the lexer
+    std::string value;
+    value.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); i++) {
+        if (raw[i] != '\\') {
+            value += raw[i];
+            continue;
+        }
+        switch (raw[++i]) {
+            case 'n': value += '\n'; break;
+            case 't': value += '\t'; break;
+            case 'r': value += '\r'; break;
+            case '\\': value += '\\'; break;
+            case '"': value += '"'; break;
+        }
+    }
+    decodedStrings.push_back(std::move(value));
+    
+    return Token(TokenType::STRING_LITERAL, decodedStrings.back(), startLine, startCol);
 }
 
 Token Lexer::scanNumber() {
-    std::string value;
     int startLine = line;
     int startCol = column;
+    size_t start = current;
     
     bool isFloat = false;
     bool isLong = false;
     
     while (isDigit(peek())) {
-        value += advance();
+        advance();
     }
     
     // Look for decimal part
     if (peek() == '.' && isDigit(peekNext())) {
         isFloat = true;
-        value += advance(); // consume '.'
+        advance(); // consume '.'
         while (isDigit(peek())) {
-            value += advance();
+            advance();
         }
     }
     
+    std::string_view value = source.substr(start, current - start);
+    
     // Check for type suffixes
     if (peek() == 'L' || peek() == 'l') {
         advance();
@@ -193,22 +229,47 @@ Token Lexer::scanNumber() {
     }
 }
 
+Token Lexer::scanAnnotation() {
+    int startLine = line;
+    int startCol = column - 1;
+    size_t start = current;
+    
+    while (isAlphaNumeric(peek())) {
+        advance();
+    }
+    
+    if (current == start) {
+        return errorToken("Expected annotation name after '@'");
+    }
+    return Token(TokenType::ANNOTATION, source.substr(start, current - start), startLine, startCol);
+}
+
 Token Lexer::scanIdentifier() {
-    std::string value;
     int startLine = line;
     int startCol = column;
+    size_t start = current;
     
     while (isAlphaNumeric(peek())) {
-        value += advance();
+        advance();
     }
     
+    std::string_view value = source.substr(start, current - start);
+    
     // Check if it's a keyword
     auto it = keywords.find(value);
     if (it != keywords.end()) {
         return Token(it->second, value, startLine, startCol);
     }
     
-    return Token(TokenType::IDENTIFIER, value, startLine, startCol);
+    Token token(TokenType::IDENTIFIER, value, startLine, startCol);
+    auto cached = symbolCache.find(value);
+    if (cached != symbolCache.end()) {
+        token.symbol = cached->second;
+    } else {
+        token.symbol = StringInterner::global().intern(value);
+        symbolCache.emplace(value, token.symbol);
+    }
+    return token;
 }
 
 Token Lexer::scanToken() {
@@ -288,24 +349,19 @@ Token Lexer::scanToken() {
             current--;
             column--;
             return scanString();
+        case '@':
+            return scanAnnotation();
         default:
             return errorToken("Unexpected character");
     }
 }
 
-std::vector<Token> Lexer::tokenize() {
-    std::vector<Token> tokens;
-    
-    while (!isAtEnd()) {
-        Token token = scanToken();
-        if (token.type == TokenType::UNKNOWN) {
-            throw std::runtime_error("Lexical error at line " + std::to_string(token.line) + 
-                                   ", column " + std::to_string(token.column) + 
-                                   ": " + token.value);
-        }
-        tokens.push_back(token);
+Token Lexer::next() {
+    Token token = scanToken();
+    if (token.type == TokenType::UNKNOWN) {
+        throw std::runtime_error("Lexical error at line " + std::to_string(token.line) + 
+                               ", column " + std::to_string(token.column) + 
+                               ": " + std::string(token.value));
     }
-    
-    tokens.push_back(makeToken(TokenType::END_OF_FILE));
-    return tokens;
-}
\ No newline at end of file
+    return token;
+}
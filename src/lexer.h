@@ -1,17 +1,25 @@
 #pragma once
+#include <deque>
 #include <string>
-#include <vector>
+#include <string_view>
 #include <unordered_map>
 #include "token.h"
 
 class Lexer {
 private:
-    std::string source;
+    std::string_view source;
     size_t current;
     int line;
     int column;
     
-    static std::unordered_map<std::string, TokenType> keywords;
+    // Backing storage for string literals whose escapes had to be decoded
+    std::deque<std::string> decodedStrings;
+    
+    // Identifiers already interned by this lexer; avoids taking the global
+    // interner's lock for every repeated name
+    std::unordered_map<std::string_view, Symbol> symbolCache;
+    
+    static std::unordered_map<std::string_view, TokenType> keywords;
     
     bool isAtEnd() const;
     char advance();
@@ -24,18 +32,21 @@ private:
     
     Token scanToken();
     Token makeToken(TokenType type);
-    Token makeToken(TokenType type, const std::string& value);
-    Token errorToken(const std::string& message);
+    Token makeToken(TokenType type, std::string_view value);
+    Token errorToken(const char* message);
     
     Token scanString();
     Token scanNumber();
     Token scanIdentifier();
+    Token scanAnnotation();
     
     bool isDigit(char c) const;
     bool isAlpha(char c) const;
     bool isAlphaNumeric(char c) const;
     
 public:
-    explicit Lexer(const std::string& src);
-    std::vector<Token> tokenize();
+    explicit Lexer(std::string_view src);
+    
+    // Scan the next token; returns END_OF_FILE once the source is exhausted
+    Token next();
 };
\ No newline at end of file
@@ -5,11 +5,25 @@
 #include <cstdlib>
 #include <chrono>
 #include <iomanip>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
 #include <getopt.h>
 #include "compiler.h"
 #include "security/type_safety.h"
 #include "security/memory_safety.h"
 
+// Long-only options
+enum {
+    OPT_CACHE_DIR = 256,
+    OPT_PIPE,
+    OPT_AMALGAMATE,
+    OPT_PGO_GENERATE,
+    OPT_PGO_USE,
+    OPT_PROFILE_DIR,
+    OPT_BUFFERED_OUTPUT
+};
+
 void printUsage(const std::string& programName) {
     std::cout << "Usage: " << programName << " [options] <source.peach> [source2.peach ...]\n";
     std::cout << "\nOptions:\n";
@@ -19,6 +33,19 @@ void printUsage(const std::string& programName) {
     std::cout << "  -c, --compile       Compile to object file only (don't link)\n";
     std::cout << "  -E, --preprocess    Run preprocessor only (not implemented yet)\n";
     std::cout << "  -v, --verbose       Enable verbose output\n";
+    std::cout << "  -j, --jobs N        Translate up to N source files in parallel (0 = one per CPU)\n";
+    std::cout << "  --pipe              Stream generated C to gcc over a pipe instead of a temp file\n";
+    std::cout << "  --amalgamate        Translate all sources into one C unit for whole-program optimization\n";
+    std::cout << "  -O LEVEL            gcc optimization level, 0 to 3 (default 0)\n";
+    std::cout << "  -mOPT, -fOPT        Pass a target or code generation option to gcc,\n";
+    std::cout << "                      e.g. -march=native, -flto\n";
+    std::cout << "  --pgo-generate      Instrument the program; running it records a profile\n";
+    std::cout << "  --pgo-use           Optimize with the profile recorded by a --pgo-generate build\n";
+    std::cout << "  --profile-dir DIR   Where profiles are written and read (default: OUTPUT.profile)\n";
+    std::cout << "  --buffered-output   Buffer program output per thread and write it in large blocks;\n";
+    std::cout << "                      it is written when full, on flush(), around par for and at exit\n";
+    std::cout << "  --cache-dir DIR     Reuse generated C and objects cached in DIR\n";
+    std::cout << "                      (default: $PEACH_CACHE_DIR, unset = no cache)\n";
 }
 
 int main(int argc, char* argv[]) {
@@ -26,6 +53,16 @@ int main(int argc, char* argv[]) {
     bool generateSourceOnly = false;
     bool compileToObjectOnly = false;
     bool verbose = false;
+    int jobs = 1;
+    bool pipeToGcc = false;
+    bool amalgamate = false;
+    bool bufferedOutput = false;
+    int optimizationLevel = 0;
+    std::vector<std::string> targetFlags;
+    ProfileMode profileMode = ProfileMode::None;
+    std::string profileDir;
+    const char* cacheEnv = std::getenv("PEACH_CACHE_DIR");
+    std::string cacheDir = cacheEnv ? cacheEnv : "";
     
     // Parse command line options
     static struct option long_options[] = {
@@ -35,12 +72,20 @@ int main(int argc, char* argv[]) {
         {"compile",      no_argument,       0, 'c'},
         {"preprocess",   no_argument,       0, 'E'},
         {"verbose",      no_argument,       0, 'v'},
+        {"jobs",         required_argument, 0, 'j'},
+        {"cache-dir",    required_argument, 0, OPT_CACHE_DIR},
+        {"pipe",         no_argument,       0, OPT_PIPE},
+        {"amalgamate",   no_argument,       0, OPT_AMALGAMATE},
+        {"pgo-generate", no_argument,       0, OPT_PGO_GENERATE},
+        {"pgo-use",      no_argument,       0, OPT_PGO_USE},
+        {"profile-dir",  required_argument, 0, OPT_PROFILE_DIR},
+        {"buffered-output", no_argument,    0, OPT_BUFFERED_OUTPUT},
         {0, 0, 0, 0}
     };
     
     int opt;
     int option_index = 0;
-    while ((opt = getopt_long(argc, argv, "ho:scEv", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "ho:scEvj:O:m:f:", long_options, &option_index)) != -1) {
         switch (opt) {
             case 'h':
                 printUsage(argv[0]);
@@ -60,6 +105,53 @@ int main(int argc, char* argv[]) {
             case 'v':
                 verbose = true;
                 break;
+            case 'j':
+                try {
+                    jobs = std::stoi(optarg);
+                } catch (const std::exception&) {
+                    jobs = -1;
+                }
+                if (jobs < 0) {
+                    std::cerr << "Error: Invalid job count: " << optarg << "\n";
+                    return 1;
+                }
+                if (jobs == 0) {
+                    jobs = std::max(1u, std::thread::hardware_concurrency());
+                }
+                break;
+            case OPT_CACHE_DIR:
+                cacheDir = optarg;
+                break;
+            case OPT_PIPE:
+                pipeToGcc = true;
+                break;
+            case OPT_AMALGAMATE:
+                amalgamate = true;
+                break;
+            case OPT_BUFFERED_OUTPUT:
+                bufferedOutput = true;
+                break;
+            case 'O':
+                if (std::string(optarg).size() != 1 || optarg[0] < '0' || optarg[0] > '3') {
+                    std::cerr << "Error: Invalid optimization level: " << optarg << "\n";
+                    return 1;
+                }
+                optimizationLevel = optarg[0] - '0';
+                break;
+            case 'm':
+            case 'f':
+                // -march=native arrives as -m with "arch=native"
+                targetFlags.push_back(std::string("-") + static_cast<char>(opt) + optarg);
+                break;
+            case OPT_PGO_GENERATE:
+                profileMode = ProfileMode::Generate;
+                break;
+            case OPT_PGO_USE:
+                profileMode = ProfileMode::Use;
+                break;
+            case OPT_PROFILE_DIR:
+                profileDir = optarg;
+                break;
             default:
                 printUsage(argv[0]);
                 return 1;
@@ -72,6 +164,11 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    if (profileMode == ProfileMode::None && !profileDir.empty()) {
+        std::cerr << "Error: --profile-dir needs --pgo-generate or --pgo-use\n";
+        return 1;
+    }
+    
     // Get source files
     if (optind >= argc) {
         std::cerr << "Error: No source files specified\n";
@@ -89,55 +186,81 @@ int main(int argc, char* argv[]) {
         
         PeachCompiler compiler;
         compiler.setVerbose(verbose);
+        compiler.setJobs(jobs);
+        compiler.setCacheDir(cacheDir);
+        compiler.setPipeToGcc(pipeToGcc);
+        compiler.setAmalgamate(amalgamate);
+        compiler.setSeparateUnits(!amalgamate && sourceFiles.size() > 1);
+        compiler.setBufferedOutput(bufferedOutput);
+        compiler.setOptimizationLevel(optimizationLevel);
+        for (const auto& flag : targetFlags) {
+            compiler.addTargetFlag(flag);
+        }
+        if (profileMode != ProfileMode::None) {
+            // Both phases name the same output, so they find the same profile
+            if (profileDir.empty()) {
+                profileDir = (outputName.empty() ? "a.out" : outputName) + ".profile";
+            }
+            // The program may run from anywhere
+            compiler.setProfile(profileMode, std::filesystem::absolute(profileDir).string());
+        }
+        
+        // Whole-program mode produces a single C file or object, named
+        // after the first source
+        std::vector<std::string> units = sourceFiles;
+        if (amalgamate) {
+            units.resize(1);
+        }
         
         if (generateSourceOnly) {
             // Generate C source files only
-            for (const auto& file : sourceFiles) {
-                if (verbose) std::cout << "Translating " << file << " to C...\n";
+            compiler.forEachFile(units.size(), [&](size_t i, std::ostream& log) {
+                const std::string& file = units[i];
+                if (verbose) log << "Translating " << file << " to C...\n";
                 
-                std::string cFileName = compiler.generateCSource(file);
+                std::string cFileName = amalgamate ? compiler.generateAmalgamatedSource(sourceFiles, log)
+                                                   : compiler.generateCSource(file, log);
                 
-                // If output name is specified and there's only one source file,
+                // If output name is specified and there's only one output file,
                 // rename the generated C file
-                if (!outputName.empty() && sourceFiles.size() == 1) {
+                if (!outputName.empty() && units.size() == 1) {
                     std::string newName = outputName;
                     // Ensure it ends with .c
                     if (newName.length() < 2 || newName.substr(newName.length() - 2) != ".c") {
                         newName += ".c";
                     }
                     std::rename(cFileName.c_str(), newName.c_str());
-                    std::cout << "Generated: " << newName << "\n";
+                    log << "Generated: " << newName << "\n";
                 } else {
-                    std::cout << "Generated: " << cFileName << "\n";
+                    log << "Generated: " << cFileName << "\n";
                 }
-            }
+            });
         } else if (compileToObjectOnly) {
             // Compile to object files only
-            for (const auto& file : sourceFiles) {
-                if (verbose) std::cout << "Compiling " << file << " to object file...\n";
+            compiler.forEachFile(units.size(), [&](size_t i, std::ostream& log) {
+                const std::string& file = units[i];
+                if (verbose) log << "Compiling " << file << " to object file...\n";
                 
-                std::string objFileName = compiler.compileToObject(file);
+                std::string objFileName = amalgamate ? compiler.compileAmalgamated(sourceFiles, log)
+                                                     : compiler.compileToObject(file, log);
                 
-                // If output name is specified and there's only one source file,
+                // If output name is specified and there's only one output file,
                 // rename the object file
-                if (!outputName.empty() && sourceFiles.size() == 1) {
+                if (!outputName.empty() && units.size() == 1) {
                     std::string newName = outputName;
                     // Ensure it ends with .o
                     if (newName.length() < 2 || newName.substr(newName.length() - 2) != ".o") {
                         newName += ".o";
                     }
                     std::rename(objFileName.c_str(), newName.c_str());
-                    std::cout << "Generated: " << newName << "\n";
+                    log << "Generated: " << newName << "\n";
                 } else {
-                    std::cout << "Generated: " << objFileName << "\n";
+                    log << "Generated: " << objFileName << "\n";
                 }
-            }
+            });
         } else {
             // Compile all source files to executable
-            for (const auto& file : sourceFiles) {
-                if (verbose) std::cout << "Compiling " << file << "...\n";
-                compiler.compile(file);
-            }
+            compiler.compileAll(sourceFiles);
             
             // Generate executable
             if (outputName.empty()) {
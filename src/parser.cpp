@@ -2,22 +2,23 @@
 #include <stdexcept>
 #include <sstream>
 
-Parser::Parser(const std::vector<Token>& toks) : tokens(toks), current(0) {}
+Parser::Parser(Lexer& lexer, AstArena& nodeArena)
+    : tokens(lexer), arena(nodeArena) {}
 
 bool Parser::isAtEnd() const {
     return peek().type == TokenType::END_OF_FILE;
 }
 
-Token Parser::peek() const {
-    return tokens[current];
+const Token& Parser::peek() const {
+    return tokens.current();
 }
 
-Token Parser::previous() const {
-    return tokens[current - 1];
+const Token& Parser::previous() const {
+    return tokens.previous();
 }
 
-Token Parser::advance() {
-    if (!isAtEnd()) current++;
+const Token& Parser::advance() {
+    if (!isAtEnd()) tokens.advance();
     return previous();
 }
 
@@ -44,7 +45,7 @@ bool Parser::match(std::initializer_list<TokenType> types) {
     return false;
 }
 
-Token Parser::consume(TokenType type, const std::string& message) {
+const Token& Parser::consume(TokenType type, const std::string& message) {
     if (check(type)) return advance();
     
     std::stringstream ss;
@@ -87,20 +88,20 @@ TypeNodePtr Parser::parseType() {
         
         // Parse element type
         TypeNodePtr elementType = parseType();
-        return std::make_unique<ArrayTypeNode>(std::move(elementType), std::move(size));
+        return arena.make<ArrayTypeNode>(std::move(elementType), std::move(size));
     }
     
     // Check for pointer type *T
     if (match(TokenType::STAR)) {
         TypeNodePtr pointeeType = parseType();
-        return std::make_unique<PointerTypeNode>(std::move(pointeeType));
+        return arena.make<PointerTypeNode>(std::move(pointeeType));
     }
     
     // Basic types
     if (match({TokenType::INT_TYPE, TokenType::LONG_TYPE, TokenType::FLOAT_TYPE,
                TokenType::DOUBLE_TYPE, TokenType::BOOL_TYPE, TokenType::STRING_TYPE,
                TokenType::VOID})) {
-        std::string typeName = previous().value;
+        std::string typeName(previous().value);
         if (previous().type == TokenType::INT_TYPE) typeName = "int";
         else if (previous().type == TokenType::LONG_TYPE) typeName = "long";
         else if (previous().type == TokenType::FLOAT_TYPE) typeName = "float";
@@ -109,11 +110,23 @@ TypeNodePtr Parser::parseType() {
         else if (previous().type == TokenType::STRING_TYPE) typeName = "string";
         else if (previous().type == TokenType::VOID) typeName = "void";
         
-        baseType = std::make_unique<BasicTypeNode>(typeName);
+        baseType = arena.make<BasicTypeNode>(typeName);
+    } else if (match(TokenType::VECTOR_TYPE)) {
+        baseType = arena.make<BasicTypeNode>(std::string(previous().value));
     } else if (match(TokenType::IDENTIFIER)) {
-        // This could be a struct type
-        std::string typeName = previous().value;
-        baseType = std::make_unique<StructTypeNode>(typeName);
+        // This could be a struct type, or the builtin Arena, Vec[T] or Map[K, V]
+        std::string typeName(previous().value);
+        if (typeName == "Arena") {
+            baseType = arena.make<BasicTypeNode>(typeName);
+        } else if (typeName == "Vec" && check(TokenType::LBRACKET)) {
+            auto typeArguments = parseTypeArguments(1);
+            baseType = arena.make<VecTypeNode>(std::move(typeArguments[0]));
+        } else if (typeName == "Map" && check(TokenType::LBRACKET)) {
+            auto typeArguments = parseTypeArguments(2);
+            baseType = arena.make<MapTypeNode>(std::move(typeArguments[0]), std::move(typeArguments[1]));
+        } else {
+            baseType = arena.make<StructTypeNode>(typeName);
+        }
     } else {
         throw std::runtime_error("Expected type");
     }
@@ -135,7 +148,7 @@ ExprNodePtr Parser::parseAssignment() {
         // For now, we'll allow any expression and let the code generator handle it
         // Non-associative: don't allow chained assignments in expressions
         ExprNodePtr value = parseOr(); // Changed from parseAssignment to parseOr
-        return std::make_unique<BinaryOpNode>(std::move(expr), std::move(value), "=");
+        return arena.make<BinaryOpNode>(std::move(expr), std::move(value), "=");
     }
     
     return expr;
@@ -147,7 +160,7 @@ ExprNodePtr Parser::parseOr() {
     while (match(TokenType::OR)) {
         std::string op = "||";
         ExprNodePtr right = parseAnd();
-        expr = std::make_unique<BinaryOpNode>(std::move(expr), std::move(right), op);
+        expr = arena.make<BinaryOpNode>(std::move(expr), std::move(right), op);
     }
     
     return expr;
@@ -159,7 +172,7 @@ ExprNodePtr Parser::parseAnd() {
     while (match(TokenType::AND)) {
         std::string op = "&&";
         ExprNodePtr right = parseEquality();
-        expr = std::make_unique<BinaryOpNode>(std::move(expr), std::move(right), op);
+        expr = arena.make<BinaryOpNode>(std::move(expr), std::move(right), op);
     }
     
     return expr;
@@ -171,7 +184,7 @@ ExprNodePtr Parser::parseEquality() {
     while (match({TokenType::EQ, TokenType::NE})) {
         std::string op = previous().type == TokenType::EQ ? "==" : "!=";
         ExprNodePtr right = parseComparison();
-        expr = std::make_unique<BinaryOpNode>(std::move(expr), std::move(right), op);
+        expr = arena.make<BinaryOpNode>(std::move(expr), std::move(right), op);
     }
     
     return expr;
@@ -190,7 +203,7 @@ ExprNodePtr Parser::parseComparison() {
             default: break;
         }
         ExprNodePtr right = parseAddition();
-        expr = std::make_unique<BinaryOpNode>(std::move(expr), std::move(right), op);
+        expr = arena.make<BinaryOpNode>(std::move(expr), std::move(right), op);
     }
     
     return expr;
@@ -202,7 +215,7 @@ ExprNodePtr Parser::parseAddition() {
     while (match({TokenType::PLUS, TokenType::MINUS})) {
         std::string op = previous().type == TokenType::PLUS ? "+" : "-";
         ExprNodePtr right = parseMultiplication();
-        expr = std::make_unique<BinaryOpNode>(std::move(expr), std::move(right), op);
+        expr = arena.make<BinaryOpNode>(std::move(expr), std::move(right), op);
     }
     
     return expr;
@@ -220,7 +233,7 @@ ExprNodePtr Parser::parseMultiplication() {
             default: break;
         }
         ExprNodePtr right = parseUnary();
-        expr = std::make_unique<BinaryOpNode>(std::move(expr), std::move(right), op);
+        expr = arena.make<BinaryOpNode>(std::move(expr), std::move(right), op);
     }
     
     return expr;
@@ -230,17 +243,17 @@ ExprNodePtr Parser::parseUnary() {
     if (match({TokenType::NOT, TokenType::MINUS})) {
         std::string op = previous().type == TokenType::NOT ? "!" : "-";
         ExprNodePtr right = parseUnary();
-        return std::make_unique<UnaryOpNode>(std::move(right), op);
+        return arena.make<UnaryOpNode>(std::move(right), op);
     }
     
     if (match(TokenType::AMPERSAND)) {
         ExprNodePtr operand = parseUnary();
-        return std::make_unique<AddressOfNode>(std::move(operand));
+        return arena.make<AddressOfNode>(std::move(operand));
     }
     
     if (match(TokenType::STAR)) {
         ExprNodePtr operand = parseUnary();
-        return std::make_unique<DereferenceNode>(std::move(operand));
+        return arena.make<DereferenceNode>(std::move(operand));
     }
     
     return parsePostfix();
@@ -253,8 +266,8 @@ ExprNodePtr Parser::parsePostfix() {
         if (match(TokenType::LPAREN)) {
             // Function call
             auto args = parseArguments();
-            if (auto* id = dynamic_cast<IdentifierNode*>(expr.get())) {
-                expr = std::make_unique<CallNode>(id->name, std::move(args));
+            if (auto* id = nodeCast<IdentifierNode>(expr.get())) {
+                expr = arena.make<CallNode>(id->name, std::move(args));
             } else {
                 throw std::runtime_error("Invalid function call");
             }
@@ -262,18 +275,27 @@ ExprNodePtr Parser::parsePostfix() {
             // Array indexing
             ExprNodePtr index = parseExpression();
             consume(TokenType::RBRACKET, "Expected ']' after array index");
-            expr = std::make_unique<IndexNode>(std::move(expr), std::move(index));
+            expr = arena.make<IndexNode>(std::move(expr), std::move(index));
         } else if (match(TokenType::DOT)) {
             // Field access or method call
             Token fieldName = consume(TokenType::IDENTIFIER, "Expected field or method name after '.'");
             
-            if (match(TokenType::LPAREN)) {
+            if (isTypeArgument()) {
+                // Method call with a type argument, e.g. arena.alloc[Point](n)
+                consume(TokenType::LBRACKET, "Expected '['");
+                TypeNodePtr typeArgument = parseType();
+                consume(TokenType::RBRACKET, "Expected ']' after type argument");
+                consume(TokenType::LPAREN, "Expected '(' after type argument");
+                auto args = parseArguments();
+                expr = arena.make<MethodCallNode>(std::move(expr), fieldName.symbol, std::move(args),
+                                                  std::move(typeArgument));
+            } else if (match(TokenType::LPAREN)) {
                 // Method call
                 auto args = parseArguments();
-                expr = std::make_unique<MethodCallNode>(std::move(expr), fieldName.value, std::move(args));
+                expr = arena.make<MethodCallNode>(std::move(expr), fieldName.symbol, std::move(args));
             } else {
                 // Field access
-                expr = std::make_unique<FieldAccessNode>(std::move(expr), fieldName.value);
+                expr = arena.make<FieldAccessNode>(std::move(expr), fieldName.symbol);
             }
         } else {
             break;
@@ -283,6 +305,46 @@ ExprNodePtr Parser::parsePostfix() {
     return expr;
 }
 
+bool Parser::isTypeArgument() {
+    // `[` *...T `]` `(` after a member name; an index is never called
+    if (!check(TokenType::LBRACKET)) {
+        return false;
+    }
+    size_t ahead = 1;
+    while (ahead < TokenStream::LOOKAHEAD - 2 && tokens.peek(ahead).type == TokenType::STAR) {
+        ahead++;
+    }
+    switch (tokens.peek(ahead).type) {
+        case TokenType::INT_TYPE:
+        case TokenType::LONG_TYPE:
+        case TokenType::FLOAT_TYPE:
+        case TokenType::DOUBLE_TYPE:
+        case TokenType::BOOL_TYPE:
+        case TokenType::STRING_TYPE:
+        case TokenType::VECTOR_TYPE:
+        case TokenType::IDENTIFIER:
+            break;
+        default:
+            return false;
+    }
+    return tokens.peek(ahead + 1).type == TokenType::RBRACKET &&
+           tokens.peek(ahead + 2).type == TokenType::LPAREN;
+}
+
+std::vector<TypeNodePtr> Parser::parseTypeArguments(size_t count) {
+    // `[` T, ... `]` with exactly count types
+    consume(TokenType::LBRACKET, "Expected '['");
+    std::vector<TypeNodePtr> typeArguments;
+    do {
+        typeArguments.push_back(parseType());
+    } while (typeArguments.size() < count && match(TokenType::COMMA));
+    if (typeArguments.size() != count) {
+        throw std::runtime_error("Expected " + std::to_string(count) + " type arguments");
+    }
+    consume(TokenType::RBRACKET, "Expected ']' after type arguments");
+    return typeArguments;
+}
+
 std::vector<ExprNodePtr> Parser::parseArguments() {
     std::vector<ExprNodePtr> args;
     
@@ -298,35 +360,44 @@ std::vector<ExprNodePtr> Parser::parseArguments() {
 
 ExprNodePtr Parser::parsePrimary() {
     if (match(TokenType::TRUE)) {
-        return std::make_unique<BoolLiteralNode>(true);
+        return arena.make<BoolLiteralNode>(true);
     }
     
     if (match(TokenType::FALSE)) {
-        return std::make_unique<BoolLiteralNode>(false);
+        return arena.make<BoolLiteralNode>(false);
     }
     
     if (match(TokenType::INT_LITERAL)) {
-        return std::make_unique<IntLiteralNode>(std::stoi(previous().value));
+        return arena.make<IntLiteralNode>(std::stoi(std::string(previous().value)));
     }
     
     if (match(TokenType::LONG_LITERAL)) {
-        return std::make_unique<LongLiteralNode>(std::stol(previous().value));
+        return arena.make<LongLiteralNode>(std::stol(std::string(previous().value)));
     }
     
     if (match(TokenType::FLOAT_LITERAL)) {
-        return std::make_unique<FloatLiteralNode>(std::stof(previous().value));
+        return arena.make<FloatLiteralNode>(std::stof(std::string(previous().value)));
     }
     
     if (match(TokenType::DOUBLE_LITERAL)) {
-        return std::make_unique<DoubleLiteralNode>(std::stod(previous().value));
+        return arena.make<DoubleLiteralNode>(std::stod(std::string(previous().value)));
     }
     
     if (match(TokenType::STRING_LITERAL)) {
-        return std::make_unique<StringLiteralNode>(previous().value);
+        return arena.make<StringLiteralNode>(std::string(previous().value));
     }
     
     if (match(TokenType::IDENTIFIER)) {
-        std::string identifier = previous().value;
+        Symbol identifier = previous().symbol;
+        
+        // Builtin container construction, e.g. Vec[int]() or Map[string, long](n)
+        static const Symbol vecName("Vec"), mapName("Map");
+        if ((identifier == vecName || identifier == mapName) && check(TokenType::LBRACKET)) {
+            auto typeArguments = parseTypeArguments(identifier == vecName ? 1 : 2);
+            consume(TokenType::LPAREN, "Expected '(' after type arguments");
+            auto args = parseArguments();
+            return arena.make<CallNode>(identifier, std::move(args), std::move(typeArguments));
+        }
         
         // Check for struct/union initialization: StructName { ... }
         if (check(TokenType::LBRACE)) {
@@ -339,7 +410,7 @@ ExprNodePtr Parser::parsePrimary() {
                 consume(TokenType::ASSIGN, "Expected '=' after member name");
                 ExprNodePtr value = parseExpression();
                 consume(TokenType::RBRACE, "Expected '}' after union member");
-                return std::make_unique<UnionInitNode>(identifier, memberName.value, std::move(value));
+                return arena.make<UnionInitNode>(identifier, std::string(memberName.value), std::move(value));
             }
             
             // Regular struct initialization
@@ -352,7 +423,7 @@ ExprNodePtr Parser::parsePrimary() {
                         Token fieldName = consume(TokenType::IDENTIFIER, "Expected field name after '.'");
                         consume(TokenType::ASSIGN, "Expected '=' after field name");
                         ExprNodePtr value = parseExpression();
-                        fields.emplace_back(fieldName.value, std::move(value));
+                        fields.emplace_back(std::string(fieldName.value), std::move(value));
                     } else {
                         // Positional initialization (without field names)
                         ExprNodePtr value = parseExpression();
@@ -362,10 +433,10 @@ ExprNodePtr Parser::parsePrimary() {
             }
             
             consume(TokenType::RBRACE, "Expected '}' after struct fields");
-            return std::make_unique<StructInitNode>(identifier, std::move(fields));
+            return arena.make<StructInitNode>(identifier, std::move(fields));
         }
         
-        return std::make_unique<IdentifierNode>(identifier);
+        return arena.make<IdentifierNode>(identifier);
     }
     
     if (match(TokenType::LBRACE)) {
@@ -377,7 +448,7 @@ ExprNodePtr Parser::parsePrimary() {
             } while (match(TokenType::COMMA));
         }
         consume(TokenType::RBRACE, "Expected '}' after array elements");
-        return std::make_unique<ArrayLiteralNode>(std::move(elements));
+        return arena.make<ArrayLiteralNode>(std::move(elements));
     }
     
     if (match(TokenType::LPAREN)) {
@@ -390,8 +461,7 @@ ExprNodePtr Parser::parsePrimary() {
 }
 
 StmtNodePtr Parser::parseStatement() {
-    if (match({TokenType::VAL, TokenType::VAR})) {
-        current--; // Go back
+    if (check(TokenType::VAL) || check(TokenType::VAR)) {
         return parseVarDeclaration();
     }
     
@@ -411,6 +481,14 @@ StmtNodePtr Parser::parseStatement() {
         return parseForStatement();
     }
     
+    // `par` is contextual, it only starts a statement in front of `for`
+    if (check(TokenType::IDENTIFIER) && peek().value == "par" &&
+        tokens.peek(1).type == TokenType::FOR) {
+        advance();
+        advance();
+        return parseForStatement(true);
+    }
+    
     if (match(TokenType::RETURN)) {
         return parseReturnStatement();
     }
@@ -440,7 +518,7 @@ StmtNodePtr Parser::parseVarDeclaration() {
     
     // Consume optional semicolon for statement termination
     match(TokenType::SEMICOLON);
-    return std::make_unique<VarDeclNode>(isConst, name.value, std::move(type), std::move(initializer));
+    return arena.make<VarDeclNode>(isConst, name.symbol, std::move(type), std::move(initializer));
 }
 
 StmtNodePtr Parser::parseExpressionStatement() {
@@ -448,7 +526,7 @@ StmtNodePtr Parser::parseExpressionStatement() {
     // Expression statements are just expressions used as statements
     // Consume optional semicolon for statement termination
     match(TokenType::SEMICOLON);
-    return std::make_unique<ExprStmtNode>(std::move(expr));
+    return arena.make<ExprStmtNode>(std::move(expr));
 }
 
 StmtNodePtr Parser::parseBlockStatement() {
@@ -460,7 +538,7 @@ StmtNodePtr Parser::parseBlockStatement() {
     }
     
     consume(TokenType::RBRACE, "Expected '}' after block");
-    return std::make_unique<BlockNode>(std::move(statements));
+    return arena.make<BlockNode>(std::move(statements));
 }
 
 StmtNodePtr Parser::parseIfStatement() {
@@ -475,7 +553,7 @@ StmtNodePtr Parser::parseIfStatement() {
         elseBranch = parseStatement();
     }
     
-    return std::make_unique<IfNode>(std::move(condition), std::move(thenBranch), std::move(elseBranch));
+    return arena.make<IfNode>(std::move(condition), std::move(thenBranch), std::move(elseBranch));
 }
 
 StmtNodePtr Parser::parseWhileStatement() {
@@ -485,7 +563,7 @@ StmtNodePtr Parser::parseWhileStatement() {
     
     StmtNodePtr body = parseStatement();
     
-    return std::make_unique<WhileNode>(std::move(condition), std::move(body));
+    return arena.make<WhileNode>(std::move(condition), std::move(body));
 }
 
 StmtNodePtr Parser::parseReturnStatement() {
@@ -495,10 +573,10 @@ StmtNodePtr Parser::parseReturnStatement() {
     }
     // Consume optional semicolon for statement termination
     match(TokenType::SEMICOLON);
-    return std::make_unique<ReturnNode>(std::move(value));
+    return arena.make<ReturnNode>(std::move(value));
 }
 
-StmtNodePtr Parser::parseForStatement() {
+StmtNodePtr Parser::parseForStatement(bool isParallel) {
     consume(TokenType::LPAREN, "Expected '(' after 'for'");
     
     Token iterator = consume(TokenType::IDENTIFIER, "Expected iterator name");
@@ -508,19 +586,101 @@ StmtNodePtr Parser::parseForStatement() {
     
     consume(TokenType::RPAREN, "Expected ')' after for clause");
     
+    std::vector<Reduction> reductions;
+    if (isParallel && check(TokenType::IDENTIFIER) && peek().value == "reduce") {
+        advance();
+        reductions = parseReductions();
+    }
+    
     StmtNodePtr body = parseStatement();
     
-    return std::make_unique<ForNode>(iterator.value, std::move(collection), std::move(body));
+    auto loop = arena.make<ForNode>(iterator.symbol, std::move(collection), std::move(body));
+    loop->isParallel = isParallel;
+    loop->reductions = std::move(reductions);
+    return loop;
+}
+
+std::vector<Reduction> Parser::parseReductions() {
+    // reduce(+: total, max: best)
+    consume(TokenType::LPAREN, "Expected '(' after 'reduce'");
+    
+    std::vector<Reduction> reductions;
+    do {
+        std::string op;
+        if (match(TokenType::PLUS)) {
+            op = "+";
+        } else if (match(TokenType::STAR)) {
+            op = "*";
+        } else if (check(TokenType::IDENTIFIER) && (peek().value == "min" || peek().value == "max")) {
+            op = std::string(advance().value);
+        } else {
+            consume(TokenType::PLUS, "Expected reduction operator '+', '*', 'min' or 'max'");
+        }
+        
+        consume(TokenType::COLON, "Expected ':' after reduction operator");
+        Token variable = consume(TokenType::IDENTIFIER, "Expected reduction variable");
+        reductions.push_back({op, variable.symbol});
+    } while (match(TokenType::COMMA));
+    
+    consume(TokenType::RPAREN, "Expected ')' after reductions");
+    return reductions;
+}
+
+TypeNodePtr Parser::parseParameterType() {
+    // An unsized []T parameter is a slice; it carries its length along
+    if (check(TokenType::LBRACKET) && tokens.peek(1).type == TokenType::RBRACKET) {
+        advance();
+        advance();
+        TypeNodePtr elementType = parseType();
+        return arena.make<SliceTypeNode>(std::move(elementType));
+    }
+    
+    return parseType();
+}
+
+void Parser::markNoAlias(TypeNode* type, const Token& paramName) {
+    if (auto* pointerType = nodeCast<PointerTypeNode>(type)) {
+        pointerType->isRestrict = true;
+    } else if (auto* sliceType = nodeCast<SliceTypeNode>(type)) {
+        sliceType->isRestrict = true;
+    } else {
+        std::stringstream ss;
+        ss << "Parse error at line " << paramName.line << ", column " << paramName.column
+           << ": 'noalias' requires a pointer or slice parameter";
+        throw std::runtime_error(ss.str());
+    }
+}
+
+void Parser::parseAnnotations(InlineHint& inlineHint, bool& isExported) {
+    while (check(TokenType::ANNOTATION)) {
+        Token annotation = advance();
+        if (annotation.value == "inline") {
+            inlineHint = InlineHint::Always;
+        } else if (annotation.value == "noinline") {
+            inlineHint = InlineHint::Never;
+        } else if (annotation.value == "export") {
+            isExported = true;
+        } else {
+            std::stringstream ss;
+            ss << "Parse error at line " << annotation.line << ", column " << annotation.column
+               << ": Unknown annotation '@" << annotation.value << "'";
+            throw std::runtime_error(ss.str());
+        }
+        while (match(TokenType::NEWLINE)) {}
+    }
 }
 
-std::unique_ptr<FunctionNode> Parser::parseFunction() {
+AstPtr<FunctionNode> Parser::parseFunction() {
+    InlineHint inlineHint = InlineHint::Auto;
+    bool isExported = false;
+    parseAnnotations(inlineHint, isExported);
     consume(TokenType::DEF, "Expected 'def'");
     
     Token name = consume(TokenType::IDENTIFIER, "Expected function name");
     
     consume(TokenType::LPAREN, "Expected '(' after function name");
     
-    std::vector<std::pair<std::string, TypeNodePtr>> parameters;
+    std::vector<std::pair<Symbol, TypeNodePtr>> parameters;
     
     // Handle void parameter or empty parameter list
     if (!check(TokenType::RPAREN)) {
@@ -530,10 +690,21 @@ std::unique_ptr<FunctionNode> Parser::parseFunction() {
         } else {
             // Parse parameters
             do {
+                // `noalias` is contextual, it is only special before a parameter name
+                bool noAlias = false;
+                if (check(TokenType::IDENTIFIER) && peek().value == "noalias" &&
+                    tokens.peek(1).type == TokenType::IDENTIFIER) {
+                    advance();
+                    noAlias = true;
+                }
+                
                 Token paramName = consume(TokenType::IDENTIFIER, "Expected parameter name");
                 consume(TokenType::COLON, "Expected ':' after parameter name");
-                TypeNodePtr paramType = parseType();
-                parameters.push_back({paramName.value, std::move(paramType)});
+                TypeNodePtr paramType = parseParameterType();
+                if (noAlias) {
+                    markNoAlias(paramType.get(), paramName);
+                }
+                parameters.push_back({paramName.symbol, std::move(paramType)});
             } while (match(TokenType::COMMA));
         }
     }
@@ -555,19 +726,22 @@ std::unique_ptr<FunctionNode> Parser::parseFunction() {
     } else {
         // Single expression body
         ExprNodePtr expr = parseExpression();
-        body = std::make_unique<ExprStmtNode>(std::move(expr));
+        body = arena.make<ExprStmtNode>(std::move(expr));
     }
     
-    return std::make_unique<FunctionNode>(name.value, std::move(parameters), 
-                                          std::move(returnType), std::move(body));
+    auto function = arena.make<FunctionNode>(name.symbol, std::move(parameters), 
+                                             std::move(returnType), std::move(body));
+    function->inlineHint = inlineHint;
+    function->isExported = isExported;
+    return function;
 }
 
-std::unique_ptr<ProgramNode> Parser::parse() {
-    auto program = std::make_unique<ProgramNode>();
+AstPtr<ProgramNode> Parser::parse() {
+    auto program = arena.make<ProgramNode>();
     
     while (!isAtEnd()) {
         try {
-            if (check(TokenType::DEF)) {
+            if (check(TokenType::DEF) || check(TokenType::ANNOTATION)) {
                 program->functions.push_back(parseFunction());
             } else if (check(TokenType::VAL) || check(TokenType::VAR)) {
                 program->globalDeclarations.push_back(parseVarDeclaration());
@@ -591,7 +765,7 @@ std::unique_ptr<ProgramNode> Parser::parse() {
     return program;
 }
 
-std::unique_ptr<StructDefNode> Parser::parseStructDefinition() {
+AstPtr<StructDefNode> Parser::parseStructDefinition() {
     consume(TokenType::STRUCT, "Expected 'struct'");
     Token nameToken = consume(TokenType::IDENTIFIER, "Expected struct name");
     consume(TokenType::LBRACE, "Expected '{' after struct name");
@@ -600,7 +774,7 @@ std::unique_ptr<StructDefNode> Parser::parseStructDefinition() {
     
     consume(TokenType::RBRACE, "Expected '}' after struct fields");
     
-    return std::make_unique<StructDefNode>(nameToken.value, std::move(fields));
+    return arena.make<StructDefNode>(std::string(nameToken.value), std::move(fields));
 }
 
 std::vector<StructField> Parser::parseStructFields() {
@@ -611,7 +785,7 @@ std::vector<StructField> Parser::parseStructFields() {
         consume(TokenType::COLON, "Expected ':' after field name");
         TypeNodePtr fieldType = parseType();
         
-        fields.emplace_back(fieldName.value, std::move(fieldType));
+        fields.emplace_back(fieldName.symbol, std::move(fieldType));
         
         // Skip optional newlines between fields
         while (match(TokenType::NEWLINE)) {}
@@ -620,7 +794,7 @@ std::vector<StructField> Parser::parseStructFields() {
     return fields;
 }
 
-std::unique_ptr<ImplBlockNode> Parser::parseImplBlock() {
+AstPtr<ImplBlockNode> Parser::parseImplBlock() {
     consume(TokenType::IMPL, "Expected 'impl'");
     
     ReceiverType receiverType = ReceiverType::Value;
@@ -634,14 +808,14 @@ std::unique_ptr<ImplBlockNode> Parser::parseImplBlock() {
     }
     
     Token nameToken = consume(TokenType::IDENTIFIER, "Expected struct name");
-    structName = nameToken.value;
+    structName = std::string(nameToken.value);
     
     consume(TokenType::LBRACE, "Expected '{' after impl declaration");
     
-    std::vector<std::unique_ptr<FunctionNode>> methods;
+    std::vector<AstPtr<FunctionNode>> methods;
     
     while (!check(TokenType::RBRACE) && !isAtEnd()) {
-        if (check(TokenType::DEF)) {
+        if (check(TokenType::DEF) || check(TokenType::ANNOTATION)) {
             methods.push_back(parseFunction());
         } else {
             // Skip newlines
@@ -654,10 +828,10 @@ std::unique_ptr<ImplBlockNode> Parser::parseImplBlock() {
     
     consume(TokenType::RBRACE, "Expected '}' after impl block");
     
-    return std::make_unique<ImplBlockNode>(receiverType, structName, std::move(methods));
+    return arena.make<ImplBlockNode>(receiverType, structName, std::move(methods));
 }
 
-std::unique_ptr<UnionDefNode> Parser::parseUnionDefinition() {
+AstPtr<UnionDefNode> Parser::parseUnionDefinition() {
     consume(TokenType::UNION, "Expected 'union'");
     Token nameToken = consume(TokenType::IDENTIFIER, "Expected union name");
     consume(TokenType::LBRACE, "Expected '{' after union name");
@@ -666,10 +840,10 @@ std::unique_ptr<UnionDefNode> Parser::parseUnionDefinition() {
     
     consume(TokenType::RBRACE, "Expected '}' after union fields");
     
-    return std::make_unique<UnionDefNode>(nameToken.value, std::move(fields));
+    return arena.make<UnionDefNode>(std::string(nameToken.value), std::move(fields));
 }
 
-std::unique_ptr<EnumDefNode> Parser::parseEnumDefinition() {
+AstPtr<EnumDefNode> Parser::parseEnumDefinition() {
     consume(TokenType::ENUM, "Expected 'enum'");
     Token nameToken = consume(TokenType::IDENTIFIER, "Expected enum name");
     consume(TokenType::LBRACE, "Expected '{' after enum name");
@@ -678,7 +852,7 @@ std::unique_ptr<EnumDefNode> Parser::parseEnumDefinition() {
     
     consume(TokenType::RBRACE, "Expected '}' after enum members");
     
-    return std::make_unique<EnumDefNode>(nameToken.value, std::move(members));
+    return arena.make<EnumDefNode>(std::string(nameToken.value), std::move(members));
 }
 
 std::vector<EnumMember> Parser::parseEnumMembers() {
@@ -687,12 +861,12 @@ std::vector<EnumMember> Parser::parseEnumMembers() {
     while (!check(TokenType::RBRACE) && !isAtEnd()) {
         Token memberName = consume(TokenType::IDENTIFIER, "Expected enum member name");
         
-        std::unique_ptr<ExprNode> value = nullptr;
+        AstPtr<ExprNode> value = nullptr;
         if (match(TokenType::ASSIGN)) {
             value = parseExpression();
         }
         
-        members.emplace_back(memberName.value, std::move(value));
+        members.emplace_back(std::string(memberName.value), std::move(value));
         
         // Optional comma
         match(TokenType::COMMA);
@@ -2,25 +2,31 @@
 #include <vector>
 #include <memory>
 #include "token.h"
+#include "token_stream.h"
 #include "ast.h"
+#include "arena.h"
 
 class Parser {
 private:
-    std::vector<Token> tokens;
-    size_t current;
+    TokenStream tokens;
+    AstArena& arena;
     
     bool isAtEnd() const;
-    Token peek() const;
-    Token previous() const;
-    Token advance();
+    const Token& peek() const;
+    const Token& previous() const;
+    const Token& advance();
     bool check(TokenType type) const;
     bool match(TokenType type);
     bool match(std::initializer_list<TokenType> types);
-    Token consume(TokenType type, const std::string& message);
+    const Token& consume(TokenType type, const std::string& message);
     void synchronize();
     
     // Type parsing
     TypeNodePtr parseType();
+    TypeNodePtr parseParameterType();
+    void markNoAlias(TypeNode* type, const Token& paramName);
+    bool isTypeArgument();
+    std::vector<TypeNodePtr> parseTypeArguments(size_t count);
     
     // Expression parsing
     ExprNodePtr parseExpression();
@@ -42,17 +48,19 @@ private:
     StmtNodePtr parseBlockStatement();
     StmtNodePtr parseIfStatement();
     StmtNodePtr parseWhileStatement();
-    StmtNodePtr parseForStatement();
+    StmtNodePtr parseForStatement(bool isParallel = false);
+    std::vector<Reduction> parseReductions();
     StmtNodePtr parseReturnStatement();
     
     // Function parsing
-    std::unique_ptr<FunctionNode> parseFunction();
+    AstPtr<FunctionNode> parseFunction();
+    void parseAnnotations(InlineHint& inlineHint, bool& isExported);
     
     // Struct parsing
-    std::unique_ptr<StructDefNode> parseStructDefinition();
-    std::unique_ptr<UnionDefNode> parseUnionDefinition();
-    std::unique_ptr<EnumDefNode> parseEnumDefinition();
-    std::unique_ptr<ImplBlockNode> parseImplBlock();
+    AstPtr<StructDefNode> parseStructDefinition();
+    AstPtr<UnionDefNode> parseUnionDefinition();
+    AstPtr<EnumDefNode> parseEnumDefinition();
+    AstPtr<ImplBlockNode> parseImplBlock();
     std::vector<StructField> parseStructFields();
     std::vector<EnumMember> parseEnumMembers();
     
@@ -60,6 +68,9 @@ private:
     std::vector<ExprNodePtr> parseArguments();
     
 public:
-    explicit Parser(const std::vector<Token>& toks);
-    std::unique_ptr<ProgramNode> parse();
+    Parser(Lexer& lexer, AstArena& nodeArena);
+    
+    // Number of tokens consumed so far
+    size_t getTokenCount() const { return tokens.consumed(); }
+    AstPtr<ProgramNode> parse();
 };
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "process.h"
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+
+pid_t spawnWithActions(const std::vector<std::string>& args, const posix_spawn_file_actions_t* actions) {
+    if (args.empty()) {
+        throw std::runtime_error("Cannot run an empty command");
+    }
+    
+    std::vector<char*> argv;
+    argv.reserve(args.size() + 1);
+    for (const auto& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    
+    pid_t pid;
+    int error = posix_spawnp(&pid, argv[0], actions, nullptr, argv.data(), environ);
+    if (error != 0) {
+        throw std::runtime_error("Cannot run " + args[0] + ": " + std::strerror(error));
+    }
+    return pid;
+}
+
+} // namespace
+
+pid_t spawnProcess(const std::vector<std::string>& args) {
+    return spawnWithActions(args, nullptr);
+}
+
+pid_t spawnProcessWithInput(const std::vector<std::string>& args, int& inputFd) {
+    static std::once_flag ignoreSigpipe;
+    std::call_once(ignoreSigpipe, [] { std::signal(SIGPIPE, SIG_IGN); });
+    
+    // Both ends are close-on-exec so that children spawned concurrently by
+    // other threads never inherit the write end and keep the pipe open
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        throw std::runtime_error(std::string("Cannot create pipe: ") + std::strerror(errno));
+    }
+    
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[0], STDIN_FILENO);
+    
+    pid_t pid;
+    try {
+        pid = spawnWithActions(args, &actions);
+    } catch (...) {
+        posix_spawn_file_actions_destroy(&actions);
+        close(fds[0]);
+        close(fds[1]);
+        throw;
+    }
+    
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[0]);
+    inputFd = fds[1];
+    return pid;
+}
+
+int waitProcess(pid_t pid) {
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    return -1;
+}
+
+int runProcess(const std::vector<std::string>& args) {
+    return waitProcess(spawnProcess(args));
+}
+
+std::string formatCommand(const std::vector<std::string>& args) {
+    std::string command;
+    for (const auto& arg : args) {
+        if (!command.empty()) {
+            command += " ";
+        }
+        command += arg;
+    }
+    return command;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+// Child processes are started with posix_spawnp, never through a shell, so
+// file names need no quoting and no /bin/sh is forked per command.
+
+// Start args[0] (looked up in PATH) with the given arguments.
+// Throws std::runtime_error if the process cannot be started.
+pid_t spawnProcess(const std::vector<std::string>& args);
+
+// Start args[0] with its standard input connected to a new pipe whose write
+// end is stored in inputFd; close it to signal end of input. SIGPIPE is
+// ignored from then on so a reader that exits early surfaces as a write error.
+pid_t spawnProcessWithInput(const std::vector<std::string>& args, int& inputFd);
+
+// Wait for a spawned process. Returns its exit status, or -1 if it was
+// terminated by a signal.
+int waitProcess(pid_t pid);
+
+// Spawn and wait
+int runProcess(const std::vector<std::string>& args);
+
+// Render an argument vector as a command line for verbose output
+std::string formatCommand(const std::vector<std::string>& args);
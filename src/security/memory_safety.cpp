@@ -1,5 +1,4 @@
 #include "memory_safety.h"
-#include "ast.h"
 #include <algorithm>
 
 std::vector<MemorySafetyAnalyzer::MemoryIssue> MemorySafetyAnalyzer::analyzeProgram(ProgramNode* program) {
@@ -46,58 +45,10 @@ std::vector<MemorySafetyAnalyzer::MemoryIssue> MemorySafetyAnalyzer::analyzeStat
         return issues; // Empty statement is safe
     }
     
-    // Variable declarations
-    if (auto* varDecl = dynamic_cast<VarDeclNode*>(statement)) {
-        if (varDecl->initializer) {
-            // Variable is initialized
-            markVariableInitialized(varDecl->name);
-            auto exprIssues = analyzeExpression(varDecl->initializer.get());
-            issues.insert(issues.end(), exprIssues.begin(), exprIssues.end());
-        } else {
-            // Variable is declared but not initialized
-            markVariableUninitialized(varDecl->name);
-        }
-        
-        // Check for pointer types that might cause issues
-        if (varDecl->type) {
-            std::string typeStr = varDecl->type->toCType();
-            if (typeStr.find("*") != std::string::npos) {
-                // This is a pointer type - track it
-                trackPointer(varDecl->name, "");
-            }
-        }
-    }
-    
-    // Block statements
-    if (auto* block = dynamic_cast<BlockNode*>(statement)) {
-        for (const auto& stmt : block->statements) {
-            auto stmtIssues = analyzeStatement(stmt.get());
-            issues.insert(issues.end(), stmtIssues.begin(), stmtIssues.end());
-        }
-    }
-    
-    // Expression statements
-    if (auto* exprStmt = dynamic_cast<ExprStmtNode*>(statement)) {
-        auto exprIssues = analyzeExpression(exprStmt->expr.get());
-        issues.insert(issues.end(), exprIssues.begin(), exprIssues.end());
-    }
-    
-    // Assignment statements (check for use of uninitialized variables)
-    if (auto* exprStmt = dynamic_cast<ExprStmtNode*>(statement)) {
-        if (auto* binOp = dynamic_cast<BinaryOpNode*>(exprStmt->expr.get())) {
-            if (binOp->op == "=") {
-                // This is an assignment
-                auto rhsIssues = analyzeExpression(binOp->right.get());
-                issues.insert(issues.end(), rhsIssues.begin(), rhsIssues.end());
-                
-                // Mark LHS as initialized if it's a simple identifier
-                if (auto* lhsIdent = dynamic_cast<IdentifierNode*>(binOp->left.get())) {
-                    markVariableInitialized(lhsIdent->name);
-                }
-            }
-        }
-    }
-    
+    // The visitors append to the member list; collect into a fresh one
+    issues.swap(pendingIssues);
+    StmtVisitor::visit(statement);
+    issues.swap(pendingIssues);
     return issues;
 }
 
@@ -108,66 +59,110 @@ std::vector<MemorySafetyAnalyzer::MemoryIssue> MemorySafetyAnalyzer::analyzeExpr
         return issues;
     }
     
-    // Check identifier usage
-    if (auto* ident = dynamic_cast<IdentifierNode*>(expression)) {
-        if (!isVariableInitialized(ident->name)) {
-            issues.emplace_back(MemoryIssue::UNINITIALIZED_USE, 
-                "Use of uninitialized variable: " + ident->name, ident->name, 0, 0);
+    issues.swap(pendingIssues);
+    ExprVisitor::visit(expression);
+    issues.swap(pendingIssues);
+    return issues;
+}
+
+// Variable declarations
+void MemorySafetyAnalyzer::visitVarDecl(VarDeclNode* varDecl) {
+    if (varDecl->initializer) {
+        // Variable is initialized
+        markVariableInitialized(varDecl->name);
+        ExprVisitor::visit(varDecl->initializer.get());
+    } else {
+        // Variable is declared but not initialized
+        markVariableUninitialized(varDecl->name);
+    }
+    
+    // Check for pointer types that might cause issues
+    if (varDecl->type) {
+        std::string typeStr = varDecl->type->toCType();
+        if (typeStr.find("*") != std::string::npos) {
+            // This is a pointer type - track it
+            trackPointer(varDecl->name, "");
         }
-        
-        if (isPointerDangling(ident->name)) {
-            issues.emplace_back(MemoryIssue::DANGLING_POINTER,
-                "Use of dangling pointer: " + ident->name, ident->name, 0, 0);
+    }
+}
+
+// Block statements
+void MemorySafetyAnalyzer::visitBlock(BlockNode* block) {
+    for (const auto& stmt : block->statements) {
+        if (stmt) {
+            StmtVisitor::visit(stmt.get());
         }
     }
+}
+
+// Expression statements
+void MemorySafetyAnalyzer::visitExprStmt(ExprStmtNode* exprStmt) {
+    ExprVisitor::visit(exprStmt->expr.get());
     
-    // Check binary operations
-    if (auto* binOp = dynamic_cast<BinaryOpNode*>(expression)) {
-        auto leftIssues = analyzeExpression(binOp->left.get());
-        auto rightIssues = analyzeExpression(binOp->right.get());
-        issues.insert(issues.end(), leftIssues.begin(), leftIssues.end());
-        issues.insert(issues.end(), rightIssues.begin(), rightIssues.end());
+    // Assignment statements (check for use of uninitialized variables)
+    if (auto* binOp = nodeCast<BinaryOpNode>(exprStmt->expr.get())) {
+        if (binOp->op == "=") {
+            // This is an assignment
+            ExprVisitor::visit(binOp->right.get());
+            
+            // Mark LHS as initialized if it's a simple identifier
+            if (auto* lhsIdent = nodeCast<IdentifierNode>(binOp->left.get())) {
+                markVariableInitialized(lhsIdent->name);
+            }
+        }
     }
-    
-    // Check unary operations
-    if (auto* unaryOp = dynamic_cast<UnaryOpNode*>(expression)) {
-        auto operandIssues = analyzeExpression(unaryOp->operand.get());
-        issues.insert(issues.end(), operandIssues.begin(), operandIssues.end());
+}
+
+// Check identifier usage
+void MemorySafetyAnalyzer::visitIdentifier(IdentifierNode* ident) {
+    if (!isVariableInitialized(ident->name)) {
+        pendingIssues.emplace_back(MemoryIssue::UNINITIALIZED_USE, 
+            "Use of uninitialized variable: " + ident->name.str(), ident->name, 0, 0);
     }
     
-    // Check function calls
-    if (auto* call = dynamic_cast<CallNode*>(expression)) {
-        for (const auto& arg : call->arguments) {
-            auto argIssues = analyzeExpression(arg.get());
-            issues.insert(issues.end(), argIssues.begin(), argIssues.end());
-        }
+    if (isPointerDangling(ident->name)) {
+        pendingIssues.emplace_back(MemoryIssue::DANGLING_POINTER,
+            "Use of dangling pointer: " + ident->name.str(), ident->name, 0, 0);
     }
-    
-    // Check array access
-    if (auto* indexNode = dynamic_cast<IndexNode*>(expression)) {
-        auto arrayIssues = analyzeExpression(indexNode->array.get());
-        auto indexIssues = analyzeExpression(indexNode->index.get());
-        issues.insert(issues.end(), arrayIssues.begin(), arrayIssues.end());
-        issues.insert(issues.end(), indexIssues.begin(), indexIssues.end());
-        
-        // TODO: Add bounds checking analysis
+}
+
+// Check binary operations
+void MemorySafetyAnalyzer::visitBinaryOp(BinaryOpNode* binOp) {
+    ExprVisitor::visit(binOp->left.get());
+    ExprVisitor::visit(binOp->right.get());
+}
+
+// Check unary operations
+void MemorySafetyAnalyzer::visitUnaryOp(UnaryOpNode* unaryOp) {
+    ExprVisitor::visit(unaryOp->operand.get());
+}
+
+// Check function calls
+void MemorySafetyAnalyzer::visitCall(CallNode* call) {
+    for (const auto& arg : call->arguments) {
+        ExprVisitor::visit(arg.get());
     }
+}
+
+// Check array access
+void MemorySafetyAnalyzer::visitIndex(IndexNode* indexNode) {
+    ExprVisitor::visit(indexNode->array.get());
+    ExprVisitor::visit(indexNode->index.get());
     
-    // Check dereference operations
-    if (auto* deref = dynamic_cast<DereferenceNode*>(expression)) {
-        auto operandIssues = analyzeExpression(deref->operand.get());
-        issues.insert(issues.end(), operandIssues.begin(), operandIssues.end());
-        
-        // Check if dereferencing a potentially null pointer
-        if (auto* ident = dynamic_cast<IdentifierNode*>(deref->operand.get())) {
-            if (isPointerDangling(ident->name)) {
-                issues.emplace_back(MemoryIssue::DANGLING_POINTER,
-                    "Dereferencing dangling pointer: " + ident->name, ident->name, 0, 0);
-            }
+    // TODO: Add bounds checking analysis
+}
+
+// Check dereference operations
+void MemorySafetyAnalyzer::visitDereference(DereferenceNode* deref) {
+    ExprVisitor::visit(deref->operand.get());
+    
+    // Check if dereferencing a potentially null pointer
+    if (auto* ident = nodeCast<IdentifierNode>(deref->operand.get())) {
+        if (isPointerDangling(ident->name)) {
+            pendingIssues.emplace_back(MemoryIssue::DANGLING_POINTER,
+                "Dereferencing dangling pointer: " + ident->name.str(), ident->name, 0, 0);
         }
     }
-    
-    return issues;
 }
 
 void MemorySafetyAnalyzer::markVariableInitialized(const std::string& varName) {
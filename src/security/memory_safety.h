@@ -4,10 +4,15 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include "../ast_visitor.h"
 
 // Memory safety analyzer for detecting potential memory issues
-class MemorySafetyAnalyzer {
+class MemorySafetyAnalyzer : public ExprVisitor<MemorySafetyAnalyzer>,
+                             public StmtVisitor<MemorySafetyAnalyzer> {
 private:
+    friend class ExprVisitor<MemorySafetyAnalyzer>;
+    friend class StmtVisitor<MemorySafetyAnalyzer>;
+    
     // Track variable lifetimes and ownership
     std::unordered_map<std::string, bool> variableInitialized;
     std::unordered_set<std::string> danglingPointers;
@@ -33,10 +38,10 @@ public:
             : type(t), message(msg), variableName(var), line(l), column(c) {}
     };
     
-    std::vector<MemoryIssue> analyzeProgram(class ProgramNode* program);
-    std::vector<MemoryIssue> analyzeFunction(class FunctionNode* function);
-    std::vector<MemoryIssue> analyzeStatement(class StmtNode* statement);
-    std::vector<MemoryIssue> analyzeExpression(class ExprNode* expression);
+    std::vector<MemoryIssue> analyzeProgram(ProgramNode* program);
+    std::vector<MemoryIssue> analyzeFunction(FunctionNode* function);
+    std::vector<MemoryIssue> analyzeStatement(StmtNode* statement);
+    std::vector<MemoryIssue> analyzeExpression(ExprNode* expression);
     
     // Variable tracking
     void markVariableInitialized(const std::string& varName);
@@ -50,4 +55,18 @@ public:
     
     // Reset for new analysis
     void reset();
+    
+private:
+    // Issues found by the visitors below, drained by analyzeStatement/analyzeExpression
+    std::vector<MemoryIssue> pendingIssues;
+    
+    void visitVarDecl(VarDeclNode* varDecl);
+    void visitBlock(BlockNode* block);
+    void visitExprStmt(ExprStmtNode* exprStmt);
+    void visitIdentifier(IdentifierNode* ident);
+    void visitBinaryOp(BinaryOpNode* binOp);
+    void visitUnaryOp(UnaryOpNode* unaryOp);
+    void visitCall(CallNode* call);
+    void visitIndex(IndexNode* indexNode);
+    void visitDereference(DereferenceNode* deref);
 };
\ No newline at end of file
@@ -44,7 +44,7 @@ TypeSafetyChecker::TypeSafetyResult TypeSafetyChecker::checkFunction(FunctionNod
         std::string paramType = param.second->toCType();
         if (!isTypeDeclarated(paramType) && !isBuiltinType(paramType)) {
             return TypeSafetyResult(false, 
-                "Unknown parameter type: " + paramType + " in function " + function->name, 0, 0);
+                "Unknown parameter type: " + paramType + " in function " + function->name.str(), 0, 0);
         }
         registerVariable(param.first);
     }
@@ -54,7 +54,7 @@ TypeSafetyChecker::TypeSafetyResult TypeSafetyChecker::checkFunction(FunctionNod
         std::string returnType = function->returnType->toCType();
         if (!isTypeDeclarated(returnType) && !isBuiltinType(returnType)) {
             return TypeSafetyResult(false, 
-                "Unknown return type: " + returnType + " in function " + function->name, 0, 0);
+                "Unknown return type: " + returnType + " in function " + function->name.str(), 0, 0);
         }
     }
     
@@ -67,42 +67,7 @@ TypeSafetyChecker::TypeSafetyResult TypeSafetyChecker::checkStatement(StmtNode*
         return TypeSafetyResult(true); // Empty statement is valid
     }
     
-    // Check variable declarations
-    if (auto* varDecl = dynamic_cast<VarDeclNode*>(statement)) {
-        if (varDecl->type) {
-            std::string declType = varDecl->type->toCType();
-            if (!isTypeDeclarated(declType) && !isBuiltinType(declType)) {
-                return TypeSafetyResult(false, 
-                    "Unknown type in variable declaration: " + declType, 0, 0);
-            }
-        }
-        
-        if (varDecl->initializer) {
-            auto exprResult = checkExpression(varDecl->initializer.get());
-            if (!exprResult.isValid) {
-                return exprResult;
-            }
-        }
-        
-        registerVariable(varDecl->name);
-    }
-    
-    // Check block statements
-    if (auto* block = dynamic_cast<BlockNode*>(statement)) {
-        for (const auto& stmt : block->statements) {
-            auto result = checkStatement(stmt.get());
-            if (!result.isValid) {
-                return result;
-            }
-        }
-    }
-    
-    // Check expression statements
-    if (auto* exprStmt = dynamic_cast<ExprStmtNode*>(statement)) {
-        return checkExpression(exprStmt->expr.get());
-    }
-    
-    return TypeSafetyResult(true);
+    return StmtVisitor::visit(statement);
 }
 
 TypeSafetyChecker::TypeSafetyResult TypeSafetyChecker::checkExpression(ExprNode* expression) {
@@ -110,31 +75,70 @@ TypeSafetyChecker::TypeSafetyResult TypeSafetyChecker::checkExpression(ExprNode*
         return TypeSafetyResult(false, "Null expression", 0, 0);
     }
     
-    // Check function calls
-    if (auto* call = dynamic_cast<CallNode*>(expression)) {
-        if (declaredFunctions.find(call->functionName) == declaredFunctions.end() && 
-            !isBuiltinFunction(call->functionName)) {
+    return ExprVisitor::visit(expression);
+}
+
+// Check variable declarations
+TypeSafetyChecker::TypeSafetyResult TypeSafetyChecker::visitVarDecl(VarDeclNode* varDecl) {
+    if (varDecl->type) {
+        std::string declType = varDecl->type->toCType();
+        if (!isTypeDeclarated(declType) && !isBuiltinType(declType)) {
             return TypeSafetyResult(false, 
-                "Undefined function: " + call->functionName, 0, 0);
+                "Unknown type in variable declaration: " + declType, 0, 0);
         }
-        
-        // Check arguments
-        for (const auto& arg : call->arguments) {
-            auto result = checkExpression(arg.get());
-            if (!result.isValid) {
-                return result;
-            }
+    }
+    
+    if (varDecl->initializer) {
+        auto exprResult = checkExpression(varDecl->initializer.get());
+        if (!exprResult.isValid) {
+            return exprResult;
         }
     }
     
-    // Check identifiers
-    if (auto* ident = dynamic_cast<IdentifierNode*>(expression)) {
-        if (declaredVariables.find(ident->name) == declaredVariables.end()) {
-            return TypeSafetyResult(false, 
-                "Undefined variable: " + ident->name, 0, 0);
+    registerVariable(varDecl->name);
+    return TypeSafetyResult(true);
+}
+
+// Check block statements
+TypeSafetyChecker::TypeSafetyResult TypeSafetyChecker::visitBlock(BlockNode* block) {
+    for (const auto& stmt : block->statements) {
+        auto result = checkStatement(stmt.get());
+        if (!result.isValid) {
+            return result;
         }
     }
+    return TypeSafetyResult(true);
+}
+
+// Check expression statements
+TypeSafetyChecker::TypeSafetyResult TypeSafetyChecker::visitExprStmt(ExprStmtNode* exprStmt) {
+    return checkExpression(exprStmt->expr.get());
+}
+
+// Check function calls
+TypeSafetyChecker::TypeSafetyResult TypeSafetyChecker::visitCall(CallNode* call) {
+    if (declaredFunctions.find(call->functionName) == declaredFunctions.end() && 
+        !isBuiltinFunction(call->functionName)) {
+        return TypeSafetyResult(false, 
+            "Undefined function: " + call->functionName.str(), 0, 0);
+    }
     
+    // Check arguments
+    for (const auto& arg : call->arguments) {
+        auto result = checkExpression(arg.get());
+        if (!result.isValid) {
+            return result;
+        }
+    }
+    return TypeSafetyResult(true);
+}
+
+// Check identifiers
+TypeSafetyChecker::TypeSafetyResult TypeSafetyChecker::visitIdentifier(IdentifierNode* ident) {
+    if (declaredVariables.find(ident->name) == declaredVariables.end()) {
+        return TypeSafetyResult(false, 
+            "Undefined variable: " + ident->name.str(), 0, 0);
+    }
     return TypeSafetyResult(true);
 }
 
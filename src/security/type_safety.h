@@ -2,25 +2,32 @@
 #include <string>
 #include <unordered_set>
 #include <memory>
-#include "ast.h"
+#include "../ast_visitor.h"
+
+// Outcome of a type safety check
+struct TypeSafetyResult {
+    bool isValid;
+    std::string errorMessage;
+    int line;
+    int column;
+    
+    TypeSafetyResult(bool valid = true, const std::string& msg = "", int l = 0, int c = 0)
+        : isValid(valid), errorMessage(msg), line(l), column(c) {}
+};
 
 // Type safety checker for compile-time verification
-class TypeSafetyChecker {
+class TypeSafetyChecker : public ExprVisitor<TypeSafetyChecker, ::TypeSafetyResult>,
+                          public StmtVisitor<TypeSafetyChecker, ::TypeSafetyResult> {
 private:
+    friend class ExprVisitor<TypeSafetyChecker, ::TypeSafetyResult>;
+    friend class StmtVisitor<TypeSafetyChecker, ::TypeSafetyResult>;
+    
     std::unordered_set<std::string> declaredTypes;
     std::unordered_set<std::string> declaredFunctions;
     std::unordered_set<std::string> declaredVariables;
     
 public:
-    struct TypeSafetyResult {
-        bool isValid;
-        std::string errorMessage;
-        int line;
-        int column;
-        
-        TypeSafetyResult(bool valid = true, const std::string& msg = "", int l = 0, int c = 0)
-            : isValid(valid), errorMessage(msg), line(l), column(c) {}
-    };
+    using TypeSafetyResult = ::TypeSafetyResult;
     
     TypeSafetyResult checkProgram(ProgramNode* program);
     TypeSafetyResult checkFunction(FunctionNode* function);
@@ -43,4 +50,13 @@ private:
     // Helper methods
     bool isBuiltinType(const std::string& typeName);
     bool isBuiltinFunction(const std::string& functionName);
+    
+    // Per-kind checks; kinds without a handler are valid
+    TypeSafetyResult visitExpr(ExprNode*) { return TypeSafetyResult(true); }
+    TypeSafetyResult visitStmt(StmtNode*) { return TypeSafetyResult(true); }
+    TypeSafetyResult visitVarDecl(VarDeclNode* varDecl);
+    TypeSafetyResult visitBlock(BlockNode* block);
+    TypeSafetyResult visitExprStmt(ExprStmtNode* exprStmt);
+    TypeSafetyResult visitCall(CallNode* call);
+    TypeSafetyResult visitIdentifier(IdentifierNode* ident);
 };
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include "source_file.h"
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceFile::SourceFile(const std::string& path) : data(nullptr), size(0), mapped(false) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            data = static_cast<const char*>(mapping);
+            size = st.st_size;
+            mapped = true;
+            close(fd);
+            return;
+        }
+    }
+    
+    // Not mappable (empty file, pipe, ...): read it the slow way
+    char buffer[65536];
+    ssize_t count;
+    while ((count = read(fd, buffer, sizeof(buffer))) > 0) {
+        fallback.append(buffer, count);
+    }
+    close(fd);
+    if (count < 0) {
+        throw std::runtime_error("Cannot read file: " + path);
+    }
+    
+    data = fallback.data();
+    size = fallback.size();
+}
+
+SourceFile::~SourceFile() {
+    if (mapped) {
+        munmap(const_cast<char*>(data), size);
+    }
+}
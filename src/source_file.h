@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Read-only view of a source file. The file is memory-mapped when possible so
+// the lexer and its tokens can slice the bytes in place without copying them;
+// it falls back to reading the file into memory (e.g. for pipes).
+class SourceFile {
+private:
+    const char* data;
+    size_t size;
+    bool mapped;
+    std::string fallback;
+    
+public:
+    explicit SourceFile(const std::string& path);
+    ~SourceFile();
+    
+    // Prevent copying, tokens point into the mapping
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+    
+    std::string_view view() const { return std::string_view(data, size); }
+};
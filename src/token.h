@@ -1,5 +1,6 @@
 #pragma once
-#include <string>
+#include <string_view>
+#include "interner.h"
 
 enum class TokenType {
     // Keywords
@@ -7,6 +8,7 @@ enum class TokenType {
     
     // Types
     INT_TYPE, LONG_TYPE, FLOAT_TYPE, DOUBLE_TYPE, BOOL_TYPE, STRING_TYPE,
+    VECTOR_TYPE, // f32x8 and friends, see vector_types.h
     
     // Literals
     INT_LITERAL, LONG_LITERAL, FLOAT_LITERAL, DOUBLE_LITERAL, STRING_LITERAL,
@@ -26,17 +28,23 @@ enum class TokenType {
     SEMICOLON, COMMA, COLON, ARROW, DOT,
     
     // Special
+    ANNOTATION, // @name, value holds the name
     NEWLINE,
     END_OF_FILE,
     UNKNOWN
 };
 
+// Tokens do not own their text: value is a slice of the source buffer (or of
+// the lexer's storage for decoded string literals), so the lexer and the
+// source must outlive them.
 struct Token {
     TokenType type;
-    std::string value;
+    std::string_view value;
+    Symbol symbol; // interned spelling, set for identifiers only
     int line;
     int column;
     
-    Token(TokenType t, const std::string& v, int l, int c) 
+    Token() : type(TokenType::UNKNOWN), line(0), column(0) {}
+    Token(TokenType t, std::string_view v, int l, int c) 
         : type(t), value(v), line(l), column(c) {}
 };
\ No newline at end of file
@@ -0,0 +1,26 @@
+#include "token_stream.h"
+#include <stdexcept>
+
+TokenStream::TokenStream(Lexer& lex) : lexer(lex), position(0), filled(0) {
+    fill(0);
+}
+
+void TokenStream::fill(size_t index) {
+    while (filled <= index) {
+        ring[filled % CAPACITY] = lexer.next();
+        filled++;
+    }
+}
+
+const Token& TokenStream::peek(size_t ahead) {
+    if (ahead > LOOKAHEAD) {
+        throw std::logic_error("Token lookahead exceeds stream window");
+    }
+    fill(position + ahead);
+    return ring[(position + ahead) % CAPACITY];
+}
+
+void TokenStream::advance() {
+    position++;
+    fill(position);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include "token.h"
+#include "lexer.h"
+
+// Pull-based token source for the parser. Tokens are lexed on demand into a
+// small ring buffer, so memory stays bounded regardless of file size. The
+// window keeps the previous token plus up to LOOKAHEAD tokens past the
+// current one; references returned by peek()/previous() stay valid until the
+// stream advances past the end of the window.
+class TokenStream {
+public:
+    static constexpr size_t LOOKAHEAD = 6;
+    
+private:
+    static constexpr size_t CAPACITY = 8; // power of two > LOOKAHEAD + 1
+    
+    Lexer& lexer;
+    std::array<Token, CAPACITY> ring;
+    size_t position; // index of the current token
+    size_t filled;   // index one past the last lexed token
+    
+    void fill(size_t index);
+    
+public:
+    explicit TokenStream(Lexer& lex);
+    
+    const Token& current() const { return ring[position % CAPACITY]; }
+    const Token& previous() const { return ring[(position - 1) % CAPACITY]; }
+    const Token& peek(size_t ahead);
+    void advance();
+    
+    // Number of tokens consumed so far
+    size_t consumed() const { return position; }
+};
@@ -4,7 +4,7 @@ void TypeRegistry::registerStruct(const std::string& name) {
     structs[name] = StructInfo{name, {}, {}};
 }
 
-void TypeRegistry::addStructField(const std::string& structName, const std::string& fieldName, const std::string& fieldType) {
+void TypeRegistry::addStructField(const std::string& structName, Symbol fieldName, const std::string& fieldType) {
     auto it = structs.find(structName);
     if (it != structs.end()) {
         it->second.fields[fieldName] = fieldType;
@@ -18,11 +18,81 @@ void TypeRegistry::addStructMethod(const std::string& structName, const MethodIn
     }
 }
 
-void TypeRegistry::registerVariable(const std::string& varName, const std::string& varType) {
+void TypeRegistry::registerFunction(Symbol name, const std::vector<std::string>& parameterTypes) {
+    functions[name] = parameterTypes;
+}
+
+const std::vector<std::string>* TypeRegistry::getFunctionParameterTypes(Symbol name) const {
+    auto it = functions.find(name);
+    if (it != functions.end()) {
+        return &it->second;
+    }
+    return nullptr;
+}
+
+const std::vector<std::string>* TypeRegistry::getMethodParameterTypes(const std::string& structName, Symbol methodName) const {
+    auto structIt = structs.find(structName);
+    if (structIt != structs.end()) {
+        for (const auto& method : structIt->second.methods) {
+            if (method.name == methodName) {
+                return &method.parameterTypes;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void TypeRegistry::registerSlice(const std::string& sliceType, const std::string& elementType, bool isRestrict) {
+    if (getSliceElementType(sliceType).empty()) {
+        slices.push_back({sliceType, elementType, isRestrict});
+    }
+}
+
+std::string TypeRegistry::getSliceElementType(const std::string& sliceType) const {
+    // Only a handful of slice types per unit, a scan is enough
+    for (const auto& slice : slices) {
+        if (slice.name == sliceType) {
+            return slice.elementType;
+        }
+    }
+    return "";
+}
+
+void TypeRegistry::registerVec(const std::string& vecType, const std::string& elementType) {
+    if (getVecElementType(vecType).empty()) {
+        vecs.push_back({vecType, elementType});
+    }
+}
+
+std::string TypeRegistry::getVecElementType(const std::string& vecType) const {
+    for (const auto& vec : vecs) {
+        if (vec.name == vecType) {
+            return vec.elementType;
+        }
+    }
+    return "";
+}
+
+void TypeRegistry::registerMap(const std::string& mapType, const std::string& keyType, const std::string& valueType) {
+    if (!getMap(mapType)) {
+        maps.push_back({mapType, keyType, valueType});
+    }
+}
+
+const MapInfo* TypeRegistry::getMap(const std::string& mapType) const {
+    for (const auto& map : maps) {
+        if (map.name == mapType) {
+            return &map;
+        }
+    }
+    return nullptr;
+}
+
+void TypeRegistry::registerVariable(Symbol varName, const std::string& varType) {
     variables[varName] = varType;
 }
 
-std::string TypeRegistry::getVariableType(const std::string& varName) const {
+std::string TypeRegistry::getVariableType(Symbol varName) const {
     auto it = variables.find(varName);
     if (it != variables.end()) {
         return it->second;
@@ -34,7 +104,7 @@ bool TypeRegistry::isStruct(const std::string& typeName) const {
     return structs.find(typeName) != structs.end();
 }
 
-std::string TypeRegistry::getFieldType(const std::string& structName, const std::string& fieldName) const {
+std::string TypeRegistry::getFieldType(const std::string& structName, Symbol fieldName) const {
     auto structIt = structs.find(structName);
     if (structIt != structs.end()) {
         auto fieldIt = structIt->second.fields.find(fieldName);
@@ -45,7 +115,7 @@ std::string TypeRegistry::getFieldType(const std::string& structName, const std:
     return "";
 }
 
-std::string TypeRegistry::getMethodReturnType(const std::string& structName, const std::string& methodName) const {
+std::string TypeRegistry::getMethodReturnType(const std::string& structName, Symbol methodName) const {
     auto structIt = structs.find(structName);
     if (structIt != structs.end()) {
         for (const auto& method : structIt->second.methods) {
@@ -57,7 +127,24 @@ std::string TypeRegistry::getMethodReturnType(const std::string& structName, con
     return "";
 }
 
+const MethodInfo* TypeRegistry::getMethod(const std::string& structName, Symbol methodName) const {
+    auto structIt = structs.find(structName);
+    if (structIt != structs.end()) {
+        for (const auto& method : structIt->second.methods) {
+            if (method.name == methodName) {
+                return &method;
+            }
+        }
+    }
+    return nullptr;
+}
+
 void TypeRegistry::clear() {
     structs.clear();
     variables.clear();
+    functions.clear();
+    slices.clear();
+    vecs.clear();
+    maps.clear();
+    vectorsUsed = false;
 }
\ No newline at end of file
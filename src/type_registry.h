@@ -3,43 +3,94 @@
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include "interner.h"
 
 struct MethodInfo {
-    std::string name;
+    Symbol name;
     std::string returnType;
     std::vector<std::string> parameterTypes;
     bool isPointerReceiver;
+    bool isReceiverByReference; // value receiver passed as `const struct X*`
     
-    MethodInfo(const std::string& n, const std::string& ret, 
-               const std::vector<std::string>& params, bool ptrReceiver)
-        : name(n), returnType(ret), parameterTypes(params), isPointerReceiver(ptrReceiver) {}
+    MethodInfo(Symbol n, const std::string& ret, 
+               const std::vector<std::string>& params, bool ptrReceiver, bool receiverByReference = false)
+        : name(n), returnType(ret), parameterTypes(params), isPointerReceiver(ptrReceiver),
+          isReceiverByReference(receiverByReference) {}
+};
+
+struct SliceInfo {
+    std::string name;
+    std::string elementType;
+    bool isRestrict;
+};
+
+struct VecInfo {
+    std::string name;
+    std::string elementType;
+};
+
+struct MapInfo {
+    std::string name;
+    std::string keyType;
+    std::string valueType;
 };
 
 struct StructInfo {
     std::string name;
-    std::unordered_map<std::string, std::string> fields; // field name -> type
+    std::unordered_map<Symbol, std::string> fields; // field name -> type
     std::vector<MethodInfo> methods;
 };
 
 class TypeRegistry {
 private:
     std::unordered_map<std::string, StructInfo> structs;
-    std::unordered_map<std::string, std::string> variables; // variable name -> type
+    std::unordered_map<Symbol, std::string> variables; // variable name -> type
+    std::unordered_map<Symbol, std::vector<std::string>> functions; // function name -> parameter types
+    std::vector<SliceInfo> slices; // in first-use order
+    std::vector<VecInfo> vecs; // in first-use order
+    std::vector<MapInfo> maps;
+    bool vectorsUsed = false;
     
 public:
     // Struct management
     void registerStruct(const std::string& name);
-    void addStructField(const std::string& structName, const std::string& fieldName, const std::string& fieldType);
+    void addStructField(const std::string& structName, Symbol fieldName, const std::string& fieldType);
     void addStructMethod(const std::string& structName, const MethodInfo& method);
     
+    // Function signatures, used to convert arguments at call sites
+    void registerFunction(Symbol name, const std::vector<std::string>& parameterTypes);
+    const std::vector<std::string>* getFunctionParameterTypes(Symbol name) const;
+    const std::vector<std::string>* getMethodParameterTypes(const std::string& structName, Symbol methodName) const;
+    
+    // Slice types, one C typedef each
+    void registerSlice(const std::string& sliceType, const std::string& elementType, bool isRestrict);
+    std::string getSliceElementType(const std::string& sliceType) const;
+    const std::vector<SliceInfo>& getSlices() const { return slices; }
+    
+    // Vec[T] types, one struct and set of functions each
+    void registerVec(const std::string& vecType, const std::string& elementType);
+    std::string getVecElementType(const std::string& vecType) const;
+    const std::vector<VecInfo>& getVecs() const { return vecs; }
+    
+    // Map[K, V] types, one struct and set of functions each
+    void registerMap(const std::string& mapType, const std::string& keyType, const std::string& valueType);
+    const MapInfo* getMap(const std::string& mapType) const;
+    const std::vector<MapInfo>& getMaps() const { return maps; }
+    
+    // Whether the program uses SIMD vector types; operators only need to
+    // check their operand types when it does
+    void setUsesVectors(bool used) { vectorsUsed = used; }
+    bool usesVectors() const { return vectorsUsed; }
+    
     // Variable type tracking
-    void registerVariable(const std::string& varName, const std::string& varType);
-    std::string getVariableType(const std::string& varName) const;
+    void registerVariable(Symbol varName, const std::string& varType);
+    std::string getVariableType(Symbol varName) const;
     
     // Type queries
     bool isStruct(const std::string& typeName) const;
-    std::string getFieldType(const std::string& structName, const std::string& fieldName) const;
-    std::string getMethodReturnType(const std::string& structName, const std::string& methodName) const;
+    std::string getFieldType(const std::string& structName, Symbol fieldName) const;
+    std::string getMethodReturnType(const std::string& structName, Symbol methodName) const;
+    const MethodInfo* getMethod(const std::string& structName, Symbol methodName) const;
     
     // Clear registry (for new compilation units)
     void clear();
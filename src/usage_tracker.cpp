@@ -1,19 +1,49 @@
 #include "usage_tracker.h"
+#include "vector_types.h"
 
-void UsageTracker::trackFunction(const std::string& name) {
+void UsageTracker::trackFunction(Symbol name) {
+    static const Symbol range("range"), range1("range1"), range2("range2"), range3("range3");
+    static const Symbol print("print"), flush("flush"), len("len"), sizeofName("sizeof"), arenaName("Arena");
+    static const Symbol vecName("Vec"), mapName("Map");
+    
     usedFunctions.insert(name);
     
-    if (name == "range" || name == "range1" || name == "range2" || name == "range3") {
+    if (name == range || name == range1 || name == range2 || name == range3) {
         usesRange = true;
-    } else if (name == "print") {
+    } else if (name == print) {
         usesPrint = true;
-    } else if (name == "len") {
+    } else if (name == flush) {
+        usesPrint = true; // flush() lives in the print runtime
+        usesFlush = true;
+    } else if (name == len) {
         usesLen = true;
-    } else if (name == "sizeof") {
+    } else if (name == sizeofName) {
         usesSizeof = true;
+    } else if (name == arenaName) {
+        usesArena = true;
+    } else if (name == vecName) {
+        usesVec = true;
+    } else if (name == mapName) {
+        usesMap = true;
+    }
+    
+    // Typed vector builtins, e.g. f32x8_load
+    std::string_view operation;
+    if (const VectorType* vector = findVectorBuiltin(name.str(), operation)) {
+        usedVectors.insert(std::string(vector->name));
     }
 }
 
 void UsageTracker::trackType(const std::string& type) {
     usedTypes.insert(type);
+    if (type == "Arena") {
+        usesArena = true;
+    } else if (type == "Vec") {
+        usesVec = true;
+    } else if (type == "Map") {
+        usesMap = true;
+    }
+    if (const VectorType* vector = findVectorType(type)) {
+        usedVectors.insert(std::string(vector->name));
+    }
 }
\ No newline at end of file
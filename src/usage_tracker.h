@@ -1,26 +1,47 @@
 #pragma once
 #include <set>
 #include <string>
+#include <unordered_set>
+#include "interner.h"
 
 class UsageTracker {
 private:
-    std::set<std::string> usedFunctions;
+    std::unordered_set<Symbol> usedFunctions;
     std::set<std::string> usedTypes;
+    std::set<std::string> usedVectors; // vector type names, e.g. "f32x8"
     bool usesRange;
     bool usesPrint;
+    bool usesFlush;
     bool usesLen;
     bool usesSizeof;
+    bool usesParallel;
+    bool usesInlining; // some function is @noinline or picked by InlineAnalyzer
+    bool usesArena;
+    bool usesVec;
+    bool usesMap;
     
 public:
-    UsageTracker() : usesRange(false), usesPrint(false), usesLen(false), usesSizeof(false) {}
+    UsageTracker()
+        : usesRange(false), usesPrint(false), usesFlush(false), usesLen(false), usesSizeof(false), usesParallel(false),
+          usesInlining(false), usesArena(false), usesVec(false), usesMap(false) {}
     
-    void trackFunction(const std::string& name);
+    void trackFunction(Symbol name);
     void trackType(const std::string& type);
+    void trackParallelLoop() { usesParallel = true; }
+    void trackInlining() { usesInlining = true; }
     
     bool isRangeUsed() const { return usesRange; }
     bool isPrintUsed() const { return usesPrint; }
+    bool isFlushUsed() const { return usesFlush; }
     bool isLenUsed() const { return usesLen; }
     bool isSizeofUsed() const { return usesSizeof; }
+    bool isParallelUsed() const { return usesParallel; }
+    bool isInliningUsed() const { return usesInlining; }
+    bool isArenaUsed() const { return usesArena; }
+    bool isVecUsed() const { return usesVec; }
+    bool isMapUsed() const { return usesMap; }
+    bool isVectorUsed() const { return !usedVectors.empty(); }
     
     const std::set<std::string>& getUsedTypes() const { return usedTypes; }
+    const std::set<std::string>& getUsedVectors() const { return usedVectors; }
 };
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "vector_types.h"
+
+namespace {
+
+const VectorType VECTOR_TYPES[] = {
+    {"f32x4", "float", 4},
+    {"f32x8", "float", 8},
+    {"f64x2", "double", 2},
+    {"f64x4", "double", 4},
+    {"i32x4", "int", 4},
+    {"i32x8", "int", 8},
+    {"i64x2", "long", 2},
+    {"i64x4", "long", 4},
+};
+
+} // namespace
+
+const VectorType* findVectorType(std::string_view name) {
+    static const std::string_view prefix = "peach_";
+    if (name.compare(0, prefix.size(), prefix) == 0) {
+        name.remove_prefix(prefix.size());
+    }
+    for (const auto& type : VECTOR_TYPES) {
+        if (type.name == name) {
+            return &type;
+        }
+    }
+    return nullptr;
+}
+
+const VectorType* findVectorBuiltin(std::string_view functionName, std::string_view& operation) {
+    size_t underscore = functionName.find('_');
+    if (underscore == std::string_view::npos) {
+        return nullptr;
+    }
+    const VectorType* type = findVectorType(functionName.substr(0, underscore));
+    if (type) {
+        operation = functionName.substr(underscore + 1);
+    }
+    return type;
+}
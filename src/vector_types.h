@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Fixed-width SIMD vector types, e.g. f32x8 holds eight floats. In C each is
+// a typedef named "peach_" + name, backed by a GCC vector extension or, for
+// other compilers, by a struct of lanes.
+struct VectorType {
+    std::string_view name;        // Peach spelling, e.g. "f32x8"
+    std::string_view elementType; // C element type
+    int lanes;
+    
+    std::string cType() const { return "peach_" + std::string(name); }
+};
+
+// Look up a vector type by its Peach name or its C typedef name
+const VectorType* findVectorType(std::string_view name);
+
+// Split a typed builtin like "f32x8_load" into its vector type and
+// operation. Returns nullptr for any other name.
+const VectorType* findVectorBuiltin(std::string_view functionName, std::string_view& operation);
@@ -0,0 +1,5 @@
+#pragma once
+
+// Compiler version. Build cache keys use a digest of the peachc executable
+// and fall back to this only where that cannot be read.
+#define PEACH_VERSION "0.2.0"